@@ -267,6 +267,23 @@ PyAPI_FUNC(PyObject *) _PyObject_FastCall_Prepend(
     PyObject *const *args,
     Py_ssize_t nargs);
 
+PyAPI_FUNC(PyObject *) _PyObject_FastCallKeywords_Prepend(
+    PyObject *callable,
+    PyObject *obj,
+    PyObject *const *args,
+    Py_ssize_t nargs,
+    PyObject *kwnames);
+
+/* Call the callable object 'callable' through its tp_call slot, with the
+   arguments given in the format of _PyObject_FastCallKeywords(): build a
+   temporary tuple and dictionary of the arguments.  A vectorcallfunc can
+   use it for the calls that it doesn't implement itself. */
+PyAPI_FUNC(PyObject *) _PyObject_MakeTpCall(
+    PyObject *callable,
+    PyObject *const *args,
+    Py_ssize_t nargs,
+    PyObject *kwnames);
+
 PyAPI_FUNC(PyObject *) _Py_CheckFunctionResult(PyObject *callable,
                                                PyObject *result,
                                                const char *where);
@@ -200,10 +200,24 @@ PyAPI_FUNC(void) PyEval_ReInitThreads(void);
 #ifndef Py_LIMITED_API
 PyAPI_FUNC(void) _PyEval_SetSwitchInterval(unsigned long microseconds);
 PyAPI_FUNC(unsigned long) _PyEval_GetSwitchInterval(void);
+
+/* GIL scheduling policies */
+#define _PyGIL_SCHED_DEFAULT 0   /* any waiting thread can take the GIL */
+#define _PyGIL_SCHED_PRIORITY 1  /* FIFO, threads back from I/O first */
+PyAPI_FUNC(void) _PyEval_SetGILScheduling(int policy);
+PyAPI_FUNC(int) _PyEval_GetGILScheduling(void);
+PyAPI_FUNC(void) _PyEval_SetGILStats(int enable);
+PyAPI_FUNC(int) _PyEval_GetGILStats(void);
 #endif
 
 #ifndef Py_LIMITED_API
 PyAPI_FUNC(Py_ssize_t) _PyEval_RequestCodeExtraIndex(freefunc);
+
+/* Opcode profiler of the current interpreter, see sys._setopcodeprofile() */
+PyAPI_FUNC(int) _PyEval_SetOpcodeProfile(int enable, int per_code);
+PyAPI_FUNC(PyObject *) _PyEval_GetOpcodeProfile(PyObject *code);
+PyAPI_FUNC(void) _PyEval_ResetOpcodeProfile(void);
+PyAPI_FUNC(void) _PyEval_FiniOpcodeProfile(PyInterpreterState *interp);
 #endif
 
 #define Py_BEGIN_ALLOW_THREADS { \
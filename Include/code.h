@@ -9,6 +9,8 @@ extern "C" {
 
 typedef uint16_t _Py_CODEUNIT;
 
+typedef struct _PyOpcache _PyOpcache;
+
 #ifdef WORDS_BIGENDIAN
 #  define _Py_OPCODE(word) ((word) >> 8)
 #  define _Py_OPARG(word) ((word) & 255)
@@ -48,6 +50,26 @@ typedef struct {
        Type is a void* to keep the format private in codeobject.c to force
        people to go through the proper APIs. */
     void *co_extra;
+
+    /* Per opcodes just-in-time cache
+
+       To reduce cache size, we use indirect mapping from opcode index to
+       cache object:
+         cache = co_opcache[co_opcache_map[next_instr - first_instr] - 1]
+    */
+
+    /* co_opcache_map is indexed by (next_instr - first_instr).
+         * 0 means there is no cache for this opcode.
+         * n > 0 means there is cache in co_opcache[n-1]. */
+    unsigned char *co_opcache_map;
+    _PyOpcache *co_opcache;
+    int co_opcache_flag;  /* used to determine when to create a cache */
+    unsigned char co_opcache_size;  /* length of co_opcache */
+
+    /* Private copy of co_code executed by the interpreter once the code
+       object is hot, in which generic instructions are rewritten into
+       specialized ones.  NULL until then, or if nothing is specializable. */
+    _Py_CODEUNIT *co_quickened;
 } PyCodeObject;
 
 /* Masks for co_flags above */
@@ -42,6 +42,19 @@ typedef struct _frame {
     int f_lineno;               /* Current line number */
     int f_iblock;               /* index in f_blockstack */
     char f_executing;           /* whether the frame is still executing */
+    /* Frames of function calls live on the data stack of their thread
+       while they execute; they are not tracked by the garbage collector.
+       A frame object is created on the heap for such a frame when a
+       reference to it is needed (tracebacks, sys._getframe(), trace
+       functions): it forwards to the frame on the stack until the call
+       returns, and then takes over its contents.  See
+       Objects/frameobject.c. */
+    char f_onstack;             /* whether the frame is on the data stack */
+    /* For a frame on the data stack: its frame object, or NULL */
+    struct _frame *f_frameobj;
+    /* For a frame object: the frame on the data stack it stands for, or
+       NULL when it doesn't stand for an executing frame */
+    struct _frame *f_stackframe;
     PyTryBlock f_blockstack[CO_MAXBLOCKS]; /* for try and loop blocks */
     PyObject *f_localsplus[1];  /* locals+stack, dynamically sized */
 } PyFrameObject;
@@ -59,6 +72,16 @@ PyAPI_FUNC(PyFrameObject *) PyFrame_New(PyThreadState *, PyCodeObject *,
 /* only internal use */
 PyFrameObject* _PyFrame_New_NoTrack(PyThreadState *, PyCodeObject *,
                                     PyObject *, PyObject *);
+PyFrameObject* _PyFrame_New_OnStack(PyThreadState *, PyCodeObject *,
+                                    PyObject *, PyObject *);
+void _PyFrame_Clear_OnStack(PyThreadState *, PyFrameObject *);
+PyFrameObject* _PyFrame_Materialize(PyFrameObject *);
+void _PyFrame_ClearDataStack(PyThreadState *);
+
+/* The frame holding the state of the frame f: the frame on the data stack
+   f stands for while it executes, or f itself */
+#define _PyFrame_LIVE(f) \
+    ((f)->f_stackframe != NULL ? (f)->f_stackframe : (f))
 
 
 /* The rest of the interface is specific for frame objects */
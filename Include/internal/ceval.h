@@ -33,7 +33,9 @@ struct _ceval_runtime_state {
        of threads for which tstate->c_tracefunc is non-NULL, so if the
        value is 0, we know we don't have to check this thread's
        c_tracefunc.  This speeds up the if statement in
-       PyEval_EvalFrameEx() after fast_next_opcode. */
+       PyEval_EvalFrameEx() after fast_next_opcode.  Interpreters
+       for which the opcode profiler is enabled are counted as well, since
+       it also needs every instruction to go through fast_next_opcode. */
     int tracing_possible;
     /* This single variable consolidates all requests to break out of
        the fast path in the eval loop. */
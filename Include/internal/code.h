@@ -0,0 +1,63 @@
+#ifndef Py_INTERNAL_CODE_H
+#define Py_INTERNAL_CODE_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    PyObject *ptr;  /* Cached pointer (borrowed reference) */
+    uint64_t globals_ver;  /* ma_version of global dict */
+    uint64_t builtins_ver; /* ma_version of builtin dict */
+} _PyOpcache_LoadGlobal;
+
+typedef struct {
+    PyTypeObject *type;  /* Cached type (borrowed reference) */
+    Py_ssize_t hint;  /* Index in the instance dict, or ~offset of a slot */
+    unsigned int tp_version_tag;  /* tp_version_tag of the cached type */
+} _PyOpcache_LoadAttr;
+
+typedef struct {
+    PyTypeObject *type;  /* Cached type (borrowed reference) */
+    PyObject *descr;  /* Unbound method found on the type (borrowed) */
+    unsigned int tp_version_tag;  /* tp_version_tag of the cached type */
+} _PyOpcache_LoadMethod;
+
+struct _PyOpcache {
+    union {
+        _PyOpcache_LoadGlobal lg;
+        _PyOpcache_LoadAttr la;
+        _PyOpcache_LoadMethod lm;
+    } u;
+    /* 0: not optimized yet.  For LOAD_ATTR, LOAD_METHOD and specializable
+       instructions, a positive value is the number of misses left before
+       the entry is disabled. */
+    char optimized;
+};
+
+/* Number of times a code object must be executed before
+   _PyEval_EvalFrameDefault() allocates its opcode cache. */
+#define _PyCode_OPCACHE_MIN_RUNS 1024
+
+/* Number of misses tolerated by the LOAD_ATTR and LOAD_METHOD caches, and
+   by specialized instructions, before they give up on an instruction (e.g.
+   a polymorphic one). */
+#define _PyCode_OPCACHE_MAX_TRIES 20
+
+/* Replace the opcode of a code unit, keeping its argument. */
+#ifdef WORDS_BIGENDIAN
+#  define _Py_SET_OPCODE(word, opcode) \
+    ((word) = (_Py_CODEUNIT)(((opcode) << 8) | ((word) & 0xff)))
+#else
+#  define _Py_SET_OPCODE(word, opcode) \
+    ((word) = (_Py_CODEUNIT)(((word) & 0xff00) | (opcode)))
+#endif
+
+/* Private API */
+/* Allocate the opcode cache of a code object.  Return 0 on success, or
+   raise MemoryError and return -1. */
+PyAPI_FUNC(int) _PyCode_InitOpcache(PyCodeObject *co);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !Py_INTERNAL_CODE_H */
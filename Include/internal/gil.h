@@ -16,6 +16,32 @@ extern "C" {
 #undef FORCE_SWITCHING
 #define FORCE_SWITCHING
 
+/* FIFO queue of threads waiting for the GIL, as a pair of tickets */
+struct _gil_queue {
+    /* Ticket of the next thread to take the GIL */
+    unsigned long head;
+    /* Ticket given to the next thread to wait for the GIL */
+    unsigned long tail;
+};
+
+/* Number of buckets of the GIL wait and hold time histograms: bucket 0
+   counts durations under 1 microsecond, bucket i durations in
+   [2**(i-1), 2**i) microseconds, and the last one longer durations. */
+#define _PyGIL_HISTOGRAM_SIZE 24
+
+/* Per-thread GIL statistics, collected while _gil_runtime_state.stats is
+   set.  See sys._getgilstats(). */
+struct _gil_thread_stats {
+    uint64_t wait_histogram[_PyGIL_HISTOGRAM_SIZE];
+    uint64_t hold_histogram[_PyGIL_HISTOGRAM_SIZE];
+    /* Number of times the thread dropped the GIL on gil_drop_request */
+    uint64_t forced_switches;
+    /* Number of times the thread set gil_drop_request while waiting */
+    uint64_t drop_requests;
+    /* When the thread took the GIL, or 0 */
+    _PyTime_t hold_start;
+};
+
 struct _gil_runtime_state {
     /* microseconds (the Python API uses seconds, though) */
     unsigned long interval;
@@ -27,6 +53,14 @@ struct _gil_runtime_state {
     _Py_atomic_int locked;
     /* Number of GIL switches since the beginning. */
     unsigned long switch_number;
+    /* Scheduling policy: _PyGIL_SCHED_DEFAULT or _PyGIL_SCHED_PRIORITY. */
+    int scheduling;
+    /* With _PyGIL_SCHED_PRIORITY, waiting threads take the GIL in FIFO
+       order, those which released it voluntarily (queues[1]) before those
+       which were forced to drop it or never held it (queues[0]). */
+    struct _gil_queue queues[2];
+    /* Whether struct _gil_thread_stats are collected */
+    int stats;
     /* This condition variable allows one or several threads to wait
        until the GIL is released. In addition, the mutex also protects
        the above variables. */
@@ -90,6 +90,43 @@ extern "C" {
    the algorithm was refined in response to issue #14775.
 */
 
+/*
+   NOTE: about incremental collection of the oldest generation.
+
+   A full collection examines every tracked object, which can pause a
+   program with a large heap for a long time.  When incremental collection
+   is enabled (see gc.set_incremental()), the collection of the oldest
+   generation is instead spread over many slices.  Each slice examines the
+   younger generations and a bounded number of "pending" objects of the
+   oldest generation, taken with the pending objects they refer to until
+   the bound is reached (the "increment").  Objects of the oldest
+   generation which are not in the increment are considered reachable
+   from outside, so a slice never frees a live object; cycles wholly
+   contained in an increment are collected.
+
+   When the bound stops the traversal, the pending objects referred to by
+   the increment are moved to the front of the oldest generation, so that
+   the next slice continues from them.  A garbage cycle cut this way is
+   kept alive by its part outside of the increment, and a cycle larger
+   than a slice can't be found by any slice.  So once a slice was cut,
+   the passes end with a full collection (the "rescan"), which examines
+   all objects at once, when the condition of the full collections of
+   the non-incremental mode holds (see long_lived_pending).
+
+   The survivors of a slice are moved to the "visited" list and marked
+   with the visited_space gc_refs value, which keeps them out of the next
+   increments.  Once no pending object is left, a new pass starts: the
+   visited list becomes the oldest generation again and the meaning of
+   the two marks is swapped, so that starting a pass doesn't touch the
+   objects.
+
+   The number of objects examined by a slice adapts to the measured cost
+   of the previous slices, to make a slice last about the pause budget.
+*/
+
+/* Number of buckets of the collection pause time histogram */
+#define NUM_PAUSE_BUCKETS 12
+
 struct gc_generation {
     PyGC_Head head;
     int threshold; /* collection threshold */
@@ -105,6 +142,16 @@ struct gc_generation_stats {
     Py_ssize_t collected;
     /* total number of uncollectable objects (put into gc.garbage) */
     Py_ssize_t uncollectable;
+    /* total number of objects examined */
+    Py_ssize_t scanned;
+    /* total and longest duration of the collections */
+    _PyTime_t pause;
+    _PyTime_t max_pause;
+    /* total time spent in handle_weakrefs(), finalize_garbage() and
+       delete_garbage() */
+    _PyTime_t weakrefs_time;
+    _PyTime_t finalize_time;
+    _PyTime_t delete_time;
 };
 
 struct _gc_runtime_state {
@@ -139,12 +186,53 @@ struct _gc_runtime_state {
        collections, and are awaiting to undergo a full collection for
        the first time. */
     Py_ssize_t long_lived_pending;
+    /* Incremental collection of the oldest generation: the pause budget
+       of a slice in seconds (0.0 if disabled), the objects examined in
+       the current pass, the space marking them, the number of objects
+       to examine in the next slice, and whether a slice was cut by that
+       number since the last full collection. */
+    double incremental_budget;
+    PyGC_Head old_visited;
+    Py_ssize_t visited_space;
+    Py_ssize_t increment_size;
+    int incremental_rescan;
+    /* histogram of collection pause times: bucket 0 counts the pauses
+       shorter than 1 ms, bucket i the pauses in [2**(i-1), 2**i) ms and
+       the last bucket the longer ones */
+    Py_ssize_t pause_histogram[NUM_PAUSE_BUCKETS];
+    /* Adaptive threshold of generation 0: the threshold set by the user,
+       and the upper bound of generations[0].threshold (0 if disabled). */
+    int base_threshold;
+    int adaptive_max;
+    /* number of tuples and frozensets untracked when created, see
+       _PyGC_UNTRACK_NEW() */
+    Py_ssize_t untracked_at_creation;
 };
 
 PyAPI_FUNC(void) _PyGC_Initialize(struct _gc_runtime_state *);
 
+/* Untrack an immutable container just created, whose items are all atomic:
+   it can't be part of a reference cycle, so there is no need to wait for a
+   collection to untrack it (see _PyTuple_MaybeUntrack()). */
+#define _PyGC_UNTRACK_NEW(o) \
+    do { \
+        _PyObject_GC_UNTRACK(o); \
+        _PyRuntime.gc.untracked_at_creation++; \
+    } while (0)
+
 #define _PyGC_generation0 _PyRuntime.gc.generation0
 
+/* Per-thread pymalloc block caches, see Objects/obmalloc.c */
+PyAPI_FUNC(void) _PyObject_ClearThreadCache(PyThreadState *tstate);
+PyAPI_FUNC(int) _PyObject_SetThreadCacheEnabled(int enabled);
+PyAPI_FUNC(int) _PyObject_GetThreadCacheEnabled(void);
+
+/* Arena size and huge pages (-X arenasize, -X hugepages) */
+PyAPI_FUNC(const char *) _PyObject_SetArenaConfig(size_t size, int hugepages);
+
+/* Give the memory of free pools back to the system */
+PyAPI_FUNC(size_t) _PyObject_TrimArenas(int lazy);
+
 #ifdef __cplusplus
 }
 #endif
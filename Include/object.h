@@ -343,6 +343,14 @@ typedef PyObject *(*allocfunc)(struct _typeobject *, Py_ssize_t);
 #ifdef Py_LIMITED_API
 typedef struct _typeobject PyTypeObject; /* opaque */
 #else
+/* Call a callable object with the "fast call" calling convention of
+   _PyObject_FastCallKeywords(), except that kwnames is NULL when there
+   are no keyword arguments.  See Py_TPFLAGS_HAVE_VECTORCALL. */
+typedef PyObject *(*vectorcallfunc)(PyObject *callable,
+                                    PyObject *const *args,
+                                    Py_ssize_t nargs,
+                                    PyObject *kwnames);
+
 typedef struct _typeobject {
     PyObject_VAR_HEAD
     const char *tp_name; /* For printing, in format "<module>.<name>" */
@@ -424,6 +432,13 @@ typedef struct _typeobject {
 
     destructor tp_finalize;
 
+    /* Offset of the vectorcallfunc of the instances, if the type has
+       Py_TPFLAGS_HAVE_VECTORCALL */
+    Py_ssize_t tp_vectorcall_offset;
+    /* Function to call the type itself, or NULL: the vectorcallfunc of
+       type objects */
+    vectorcallfunc tp_vectorcall;
+
 #ifdef COUNT_ALLOCS
     /* these must be last and never explicitly initialized */
     Py_ssize_t tp_allocs;
@@ -457,6 +472,10 @@ PyAPI_FUNC(void*) PyType_GetSlot(PyTypeObject*, int);
 #endif
 
 #ifndef Py_LIMITED_API
+/* Number of other key orders of the instance dicts which can share their
+   keys, besides ht_cached_keys */
+#define _PyHeapType_KEYS_VARIANTS 3
+
 /* The *real* layout of a type object when allocated on the heap */
 typedef struct _heaptypeobject {
     /* Note: there's a dependency on the order of these members
@@ -473,6 +492,7 @@ typedef struct _heaptypeobject {
     PyBufferProcs as_buffer;
     PyObject *ht_name, *ht_slots, *ht_qualname;
     struct _dictkeysobject *ht_cached_keys;
+    struct _dictkeysobject *ht_keys_variants[_PyHeapType_KEYS_VARIANTS];
     /* here are optional user slots, followed by the members. */
 } PyHeapTypeObject;
 
@@ -623,6 +643,11 @@ given type object has a specified feature.
 /* Set if the type allows subclassing */
 #define Py_TPFLAGS_BASETYPE (1UL << 10)
 
+/* Set if the instances store at tp_vectorcall_offset a function to call
+   them without creating a tuple and a dict of the arguments.  It is not
+   inherited. */
+#define Py_TPFLAGS_HAVE_VECTORCALL (1UL << 11)
+
 /* Set if the type is 'ready' -- fully initialized */
 #define Py_TPFLAGS_READY (1UL << 12)
 
@@ -129,6 +129,17 @@ extern "C" {
 #define LOAD_METHOD             160
 #define CALL_METHOD             161
 
+/* Specialized instructions, never emitted by the compiler */
+#define BINARY_ADD_INT          200
+#define BINARY_ADD_FLOAT        201
+#define BINARY_SUBTRACT_INT     202
+#define BINARY_SUBTRACT_FLOAT   203
+#define BINARY_MULTIPLY_INT     204
+#define BINARY_MULTIPLY_FLOAT   205
+#define COMPARE_OP_INT          206
+#define COMPARE_OP_FLOAT        207
+#define COMPARE_OP_STR          208
+
 /* EXCEPT_HANDLER is a special, implicit block type which is created when
    entering an except handler. It is not an opcode but we define it here
    as we want it to be available to both frameobject.c and ceval.c, while
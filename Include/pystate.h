@@ -37,6 +37,9 @@ typedef struct {
     int import_time;        /* -X importtime */
     int show_ref_count;     /* -X showrefcount */
     int show_alloc_count;   /* -X showalloccount */
+    int opcode_profile;     /* -X opcodeprofile: 1, -X opcodeprofile=code: 2 */
+    size_t arena_size;      /* -X arenasize=SIZE */
+    int hugepages;          /* -X hugepages */
     int dump_refs;          /* PYTHONDUMPREFS */
     int malloc_stats;       /* PYTHONMALLOCSTATS */
     int coerce_c_locale;    /* PYTHONCOERCECLOCALE, -1 means unknown */
@@ -135,6 +138,10 @@ typedef struct _is {
     Py_ssize_t co_extra_user_count;
     freefunc co_extra_freefuncs[MAX_CO_EXTRA_USERS];
 
+    /* Used in Python/ceval.c, see sys._setopcodeprofile(). */
+    int opcode_profiling;
+    struct _opcode_profile *opcode_profile;
+
 #ifdef HAVE_FORK
     PyObject *before_forkers;
     PyObject *after_forkers_parent;
@@ -268,6 +275,23 @@ typedef struct _ts {
     PyObject *async_gen_firstiter;
     PyObject *async_gen_finalizer;
 
+    /* Waits for the GIL in take_gil(), see sys._getgilwaitstats().
+       Only modified by this thread while holding the GIL. */
+    uint64_t gil_wait_count;
+    _PyTime_t gil_wait_total;
+    _PyTime_t gil_wait_max;
+    /* Detailed GIL statistics, see sys._setgilstats().  NULL unless
+       they were enabled while this thread was running. */
+    struct _gil_thread_stats *gil_stats;
+    /* Free blocks cached by pymalloc for this thread, see
+       Objects/obmalloc.c.  NULL until the first block is cached. */
+    struct _pymalloc_cache *pymalloc_cache;
+    /* Data stack holding the frames of the function calls of this thread,
+       see Objects/frameobject.c.  NULL until the first call. */
+    struct _PyDataStackChunk *datastack_chunk;
+    PyObject **datastack_top;
+    PyObject **datastack_limit;
+
     /* XXX signal handlers should also be here */
 
 } PyThreadState;
@@ -406,6 +430,14 @@ PyAPI_FUNC(PyInterpreterState *) _PyGILState_GetInterpreterStateUnsafe(void);
 PyAPI_FUNC(PyObject *) _PyThread_CurrentFrames(void);
 #endif
 
+/* The implementation of sys._getgilwaitstats(), sys._getgilstats() and
+   sys._resetgilstats(). */
+#ifndef Py_LIMITED_API
+PyAPI_FUNC(PyObject *) _PyThread_GILWaitStats(void);
+PyAPI_FUNC(PyObject *) _PyThread_GILStats(void);
+PyAPI_FUNC(void) _PyThread_ResetGILStats(void);
+#endif
+
 /* Routines for advanced debuggers, requested by David Beazley.
    Don't use unless you know what you are doing! */
 #ifndef Py_LIMITED_API
@@ -0,0 +1,279 @@
+"""Python implementations of some algorithms for use by longobject.c.
+
+The goal is to provide asymptotically faster algorithms that can be used
+for operations on integers with many digits.  In those cases, the
+performance overhead of the Python implementation is not significant since
+the asymptotic behavior is what dominates runtime.  Functions provided by
+this module should be considered private and not part of any public API.
+
+Note: for ease of maintainability, please prefer clear code and avoid
+"micro-optimizations".  This module is only imported and used for integers
+with a huge number of digits.  Saving a few microseconds with tricky or
+non-obvious code is not worth it.
+"""
+
+try:
+    import _decimal as decimal
+except ImportError:
+    # The pure Python decimal module multiplies in quadratic time, which
+    # would defeat the purpose.
+    decimal = None
+
+
+def _int_to_decimal(n):
+    """Asymptotically fast conversion of a non-negative 'int' to Decimal.
+
+    Builds an equal decimal.Decimal from the binary halves of n, using the
+    fast multiplication of libmpdec for the powers of two.
+    """
+    D = decimal.Decimal
+    D2 = D(2)
+
+    BITLIM = 128
+
+    mem = {}
+
+    def w2pow(w):
+        """Return D(2)**w, keeping the results: they are likely to be
+        reused across the levels of the recursion."""
+        result = mem.get(w)
+        if result is None:
+            if w <= BITLIM:
+                result = D2 ** w
+            elif w - 1 in mem:
+                t = mem[w - 1]
+                result = t + t
+            else:
+                w2 = w >> 1
+                # If w is odd, w - w2 is one larger than w2.  Recurse on
+                # the smaller one first, so that the larger one is found
+                # by the cheaper "w - 1 in mem" branch.
+                result = w2pow(w2) * w2pow(w - w2)
+            mem[w] = result
+        return result
+
+    def inner(n, w):
+        if w <= BITLIM:
+            return D(n)
+        w2 = w >> 1
+        hi = n >> w2
+        lo = n - (hi << w2)
+        return inner(lo, w2) + inner(hi, w - w2) * w2pow(w2)
+
+    with decimal.localcontext() as ctx:
+        ctx.prec = decimal.MAX_PREC
+        ctx.Emax = decimal.MAX_EMAX
+        ctx.Emin = decimal.MIN_EMIN
+        ctx.traps[decimal.Inexact] = 1
+        return inner(n, n.bit_length())
+
+
+def _int_to_decimal_string_pure(n):
+    """Conversion of a non-negative 'int' to a decimal string, by splitting
+    it around powers of 10 with int_divmod()."""
+    DIGLIM = 1000
+
+    mem = {}
+
+    def w10pow(w):
+        result = mem.get(w)
+        if result is None:
+            if w <= DIGLIM:
+                result = 10 ** w
+            else:
+                w2 = w >> 1
+                result = w10pow(w2) * w10pow(w - w2)
+            mem[w] = result
+        return result
+
+    def inner(n, w):
+        # n < 10**w; return exactly w digits, with leading zeros.
+        if w <= DIGLIM:
+            return str(n).zfill(w)
+        w2 = w >> 1
+        hi, lo = int_divmod(n, w10pow(w2))
+        return inner(hi, w - w2) + inner(lo, w2)
+
+    # log10(2) < 0.30103, so this is at least the number of digits of n.
+    w = n.bit_length() * 30103 // 100000 + 1
+    return inner(n, w).lstrip('0') or '0'
+
+
+def int_to_decimal_string(n):
+    """Asymptotically fast conversion of an 'int' to a decimal string."""
+    if n < 0:
+        return '-' + int_to_decimal_string(-n)
+    if decimal is not None:
+        return str(_int_to_decimal(n))
+    return _int_to_decimal_string_pure(n)
+
+
+def _str_to_int_inner(s):
+    """Asymptotically fast conversion of a string of decimal digits to an
+    'int'.
+
+    Splits the string in halves and combines the conversions of the halves
+    with Python's big int multiplication, which uses the Karatsuba
+    algorithm: the time complexity is O(len(s)**1.58).
+    """
+    DIGLIM = 2048
+
+    mem = {}
+
+    def w5pow(w):
+        """Return 5**w, keeping the results: they are likely to be reused
+        across the levels of the recursion."""
+        result = mem.get(w)
+        if result is None:
+            if w <= DIGLIM:
+                result = 5 ** w
+            elif w - 1 in mem:
+                result = mem[w - 1] * 5
+            else:
+                w2 = w >> 1
+                # If w is odd, w - w2 is one larger than w2.  Recurse on
+                # the smaller one first, so that the larger one is found
+                # by the cheaper "w - 1 in mem" branch.
+                result = w5pow(w2) * w5pow(w - w2)
+            mem[w] = result
+        return result
+
+    def inner(a, b):
+        if b - a <= DIGLIM:
+            return int(s[a:b])
+        mid = (a + b + 1) >> 1
+        # 10**k == 5**k << k
+        return (inner(mid, b)
+                + ((inner(a, mid) * w5pow(b - mid)) << (b - mid)))
+
+    return inner(0, len(s))
+
+
+def int_from_string(s):
+    """Asymptotically fast version of PyLong_FromString(), conversion of a
+    string of decimal digits into a non-negative 'int'."""
+    # PyLong_FromString() has already removed the leading sign and
+    # whitespace, and checked that the string consists of only digits and
+    # properly placed underscores.
+    return _str_to_int_inner(s.replace('_', ''))
+
+
+# Fast integer division, based on code from Mark Dickinson, fast_div.py
+# (bpo-3451).  The algorithm is due to Burnikel and Ziegler, in their paper
+# "Fast Recursive Division".
+
+_DIV_LIMIT = 4000
+
+
+def _div2n1n(a, b, n):
+    """Divide a 2n-bit nonnegative integer a by an n-bit positive integer
+    b, using a recursive divide-and-conquer algorithm.
+
+    Inputs:
+      n is a positive integer
+      b is a positive integer with exactly n bits
+      a is a nonnegative integer such that a < 2**n * b
+
+    Output:
+      (q, r) such that a = b*q+r and 0 <= r < b.
+    """
+    if a.bit_length() - n <= _DIV_LIMIT:
+        return divmod(a, b)
+    pad = n & 1
+    if pad:
+        a <<= 1
+        b <<= 1
+        n += 1
+    half_n = n >> 1
+    mask = (1 << half_n) - 1
+    b1, b2 = b >> half_n, b & mask
+    q1, r = _div3n2n(a >> n, (a >> half_n) & mask, b, b1, b2, half_n)
+    q2, r = _div3n2n(r, a & mask, b, b1, b2, half_n)
+    if pad:
+        r >>= 1
+    return q1 << half_n | q2, r
+
+
+def _div3n2n(a12, a3, b, b1, b2, n):
+    """Helper function for _div2n1n; not intended to be called directly."""
+    if a12 >> n == b1:
+        q, r = (1 << n) - 1, a12 - (b1 << n) + b1
+    else:
+        q, r = _div2n1n(a12, b1, n)
+    r = (r << n | a3) - q * b2
+    while r < 0:
+        q -= 1
+        r += b
+    return q, r
+
+
+def _int2digits(a, n):
+    """Decompose the non-negative int a into base 2**n.
+
+    Return the list of the digits of a in base 2**n, least significant
+    first.  The most significant digit is non-zero; the list is empty if
+    a is 0.
+    """
+    a_digits = [0] * ((a.bit_length() + n - 1) // n)
+
+    def inner(x, L, R):
+        if L + 1 == R:
+            a_digits[L] = x
+            return
+        mid = (L + R) >> 1
+        shift = (mid - L) * n
+        upper = x >> shift
+        lower = x ^ (upper << shift)
+        inner(lower, L, mid)
+        inner(upper, mid, R)
+
+    if a:
+        inner(a, 0, len(a_digits))
+    return a_digits
+
+
+def _digits2int(digits, n):
+    """Combine base 2**n digits into an int: the inverse of _int2digits()."""
+
+    def inner(L, R):
+        if L + 1 == R:
+            return digits[L]
+        mid = (L + R) >> 1
+        shift = (mid - L) * n
+        return (inner(mid, R) << shift) + inner(L, mid)
+
+    return inner(0, len(digits)) if digits else 0
+
+
+def _divmod_pos(a, b):
+    """Divide a non-negative integer a by a positive integer b, giving
+    quotient and remainder."""
+    # Use the grade-school algorithm in base 2**n, n = nbits(b)
+    n = b.bit_length()
+    a_digits = _int2digits(a, n)
+
+    r = 0
+    q_digits = []
+    for a_digit in reversed(a_digits):
+        q_digit, r = _div2n1n((r << n) + a_digit, b, n)
+        q_digits.append(q_digit)
+    q_digits.reverse()
+    q = _digits2int(q_digits, n)
+    return q, r
+
+
+def int_divmod(a, b):
+    """Asymptotically fast replacement for divmod, for 'int'.
+
+    Its time complexity is O(n**1.58), where n = #bits(a) + #bits(b).
+    """
+    if b == 0:
+        raise ZeroDivisionError('integer division or modulo by zero')
+    elif b < 0:
+        q, r = int_divmod(-a, -b)
+        return q, -r
+    elif a < 0:
+        q, r = int_divmod(~a, b)
+        return ~q, b + ~r
+    else:
+        return _divmod_pos(a, b)
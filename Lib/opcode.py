@@ -216,3 +216,20 @@ name_op('LOAD_METHOD', 160)
 def_op('CALL_METHOD', 161)
 
 del def_op, name_op, jrel_op, jabs_op
+
+# Specialized variants of some of the instructions above.  The compiler never
+# emits them: the interpreter writes them into a private copy of the bytecode
+# of hot code objects, and turns them back into the generic instruction when
+# the types of their operands change (see "Adaptive specialization" in
+# Python/ceval.c).  They are deliberately left out of opmap and opname.
+_specialized_instructions = [
+    ('BINARY_ADD_INT', 200),
+    ('BINARY_ADD_FLOAT', 201),
+    ('BINARY_SUBTRACT_INT', 202),
+    ('BINARY_SUBTRACT_FLOAT', 203),
+    ('BINARY_MULTIPLY_INT', 204),
+    ('BINARY_MULTIPLY_FLOAT', 205),
+    ('COMPARE_OP_INT', 206),
+    ('COMPARE_OP_FLOAT', 207),
+    ('COMPARE_OP_STR', 208),
+]
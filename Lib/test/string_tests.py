@@ -213,6 +213,60 @@ class BaseTest:
                 if loc != -1:
                     self.assertEqual(i[loc:loc+len(j)], j)
 
+    def test_find_periodic_pattern(self):
+        # Long needles in long haystacks use the two-way algorithm, which
+        # treats periodic needles differently
+        for needle, haystack in [
+                ('a' * 100 + 'b', 'a' * 5000 + 'b'),
+                ('ab' * 60, 'a' + 'ba' * 2000 + 'b'),
+                ('abc' * 40 + 'x', 'abc' * 2000 + 'x'),
+                ('abcab' * 30 + 'abc', ('abcab' * 29 + 'x') * 100),
+                ('x' + 'ab' * 60, 'ab' * 2000 + 'x' + 'ab' * 60)]:
+            loc = -1
+            for i in range(len(haystack) - len(needle) + 1):
+                if haystack.startswith(needle, i):
+                    loc = i
+                    break
+            self.checkequal(loc, haystack, 'find', needle)
+            self.checkequal(loc != -1, haystack, '__contains__', needle)
+            self.checkequal(loc, haystack + 'y' * 3000, 'find', needle)
+
+    def test_find_many_lengths(self):
+        # Needles of every length up to a few hundred characters, matching
+        # at the start, at the end, or not at all
+        haystack = 'abcd' * 1000
+        for m in range(1, 300, 7):
+            needle = haystack[1:1 + m]
+            self.checkequal(1, haystack, 'find', needle)
+            self.checkequal(2999, 'x' * 3000 + haystack, 'find',
+                            'x' + haystack[:m])
+            self.checkequal(3000 + 1, 'x' * 3000 + haystack, 'find', needle)
+            self.checkequal(-1, haystack, 'find', needle + 'x')
+            self.checkequal(4000 - m, haystack + 'x', 'find',
+                            haystack[-m:] + 'x')
+            self.checkequal(1, haystack + 'x', 'count', haystack[-m:] + 'x')
+
+    def test_find_shift_table_overflow(self):
+        # The skip table stores shifts in a byte
+        for m in (254, 255, 256, 257, 600):
+            needle = 'b' + 'a' * (m - 1)
+            self.checkequal(-1, 'a' * 10000, 'find', needle)
+            self.checkequal(5000, 'a' * 5000 + needle + 'a' * 5000,
+                            'find', needle)
+            self.checkequal(2, (needle + 'a' * 3000) * 2, 'count', needle)
+
+    def test_count_long_patterns(self):
+        # Matches found by count() don't overlap, whatever the algorithm
+        for m in (2, 3, 5, 17, 31, 33, 64, 150):
+            needle = 'a' * m
+            for n in (m * 10, 5000, 40000):
+                self.checkequal(n // m, 'a' * n, 'count', needle)
+                self.checkequal(n // m, 'a' * n, 'count', needle, 0,
+                                sys.maxsize)
+                self.checkequal((n - 1) // m, 'a' * n, 'count', needle, 1)
+            self.checkequal(2, 'ab' * 3000 + needle + 'b' + needle,
+                            'count', needle)
+
     def test_rfind(self):
         self.checkequal(9,  'abcdefghiabc', 'rfind', 'abc')
         self.checkequal(12, 'abcdefghiabc', 'rfind', '')
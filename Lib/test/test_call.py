@@ -279,6 +279,14 @@ class PythonClass:
 PYTHON_INSTANCE = PythonClass()
 
 
+class PythonInitClass:
+    def __init__(self, arg1, arg2=None):
+        self.args = [arg1, arg2]
+
+    def __eq__(self, other):
+        return self.args == other
+
+
 IGNORE_RESULT = object()
 
 
@@ -325,6 +333,29 @@ class FastCallTests(unittest.TestCase):
         # bpo-30524: Test that calling a C type static method with no argument
         # doesn't crash (ignore the result): METH_FASTCALL | METH_CLASS
         (datetime.datetime.now, (), IGNORE_RESULT),
+
+        # Types with a tp_vectorcall
+        (type, (1,), int),
+        (object, (), IGNORE_RESULT),
+        (int, (), 0),
+        (int, ('42',), 42),
+        (int, ('ff', 16), 255),
+        (float, ('1.5',), 1.5),
+        (bool, ([1],), True),
+        (str, (), ''),
+        (str, (12,), '12'),
+        (list, ((1, 2),), [1, 2]),
+        (tuple, ([1, 2],), (1, 2)),
+        (dict, ([(1, 2)],), {1: 2}),
+        (set, ([1, 1],), {1}),
+        (frozenset, ([1, 1],), frozenset({1})),
+
+        # Python class
+        (PythonInitClass, (1, 2), [1, 2]),
+        (PythonInitClass, (1,), [1, None]),
+
+        # Type without a tp_vectorcall
+        (bytes, ([65],), b'A'),
     )
 
     # Test calls with positional and keyword arguments
@@ -345,6 +376,16 @@ class FastCallTests(unittest.TestCase):
         # C type static method: METH_FASTCALL | METH_CLASS
         (int.from_bytes, (b'\x01\x00',), {'byteorder': 'little'}, 1),
         (int.from_bytes, (), {'bytes': b'\x01\x00', 'byteorder': 'little'}, 1),
+
+        # Types with a tp_vectorcall
+        (int, ('ff',), {'base': 16}, 255),
+        (str, (b'ab',), {'encoding': 'ascii'}, 'ab'),
+        (dict, (), {'a': 1}, {'a': 1}),
+        (dict, ([(1, 2)],), {'a': 1}, {1: 2, 'a': 1}),
+
+        # Python class
+        (PythonInitClass, (1,), {'arg2': 2}, [1, 2]),
+        (PythonInitClass, (), {'arg1': 1, 'arg2': 2}, [1, 2]),
     )
 
     def check_result(self, result, expected):
@@ -422,5 +463,94 @@ class FastCallTests(unittest.TestCase):
                 self.check_result(result, expected)
 
 
+class TypeCallTests(unittest.TestCase):
+    # Calls of types which avoid creating a tuple of the arguments must
+    # behave as type.__call__()
+
+    def test_init_errors(self):
+        class A:
+            pass
+        class B:
+            def __init__(self, x):
+                return x
+        self.assertIsInstance(A(), A)
+        self.assertRaisesRegex(TypeError, r"A\(\) takes no arguments", A, 1)
+        self.assertRaisesRegex(TypeError, r"A\(\) takes no arguments",
+                               A, x=1)
+        self.assertRaisesRegex(TypeError, r"object\(\) takes no arguments",
+                               object, 1)
+        self.assertIsNone(B(None).__dict__.get('x'))
+        self.assertRaisesRegex(TypeError, "should return None, not 'int'",
+                               B, 1)
+        self.assertRaises(TypeError, B)
+        self.assertRaises(TypeError, B, 1, 2)
+
+    def test_abstract(self):
+        import abc
+        class A(abc.ABC):
+            @abc.abstractmethod
+            def f(self):
+                pass
+        self.assertRaisesRegex(TypeError, "abstract", A)
+
+    def test_changed_slots(self):
+        class A:
+            def __init__(self, x):
+                self.x = x
+        self.assertEqual(A(1).x, 1)
+        A.__init__ = lambda self, y: setattr(self, 'y', y)
+        self.assertEqual(A(y=3).y, 3)
+        del A.__init__
+        self.assertIsInstance(A(), A)
+        A.__new__ = lambda cls, x: x
+        self.assertEqual(A(2), 2)
+
+    def test_metaclass_call(self):
+        class Meta(type):
+            def __call__(cls, *args, **kwargs):
+                return (args, kwargs)
+        class A(metaclass=Meta):
+            def __init__(self, x):
+                pass
+        self.assertEqual(A(1, y=2), ((1,), {'y': 2}))
+
+    def test_type(self):
+        self.assertIs(type(1), int)
+        self.assertRaises(TypeError, type, 1, x=1)
+        C = type('C', (), {'a': 1})
+        self.assertEqual(C.a, 1)
+
+    def test_builtin_subclasses(self):
+        class MyInt(int):
+            pass
+        class MyList(list):
+            def __init__(self, *args):
+                super().__init__(*args)
+                self.extra = len(args)
+        self.assertIs(type(MyInt('7')), MyInt)
+        self.assertEqual(MyInt('7'), 7)
+        l = MyList((1, 2))
+        self.assertEqual(l, [1, 2])
+        self.assertEqual(l.extra, 1)
+
+    def test_builtin_errors(self):
+        self.assertRaises(TypeError, list, 1, 2)
+        self.assertRaises(TypeError, list, iterable=[])
+        self.assertRaises(TypeError, set, [], [])
+        self.assertRaises(TypeError, frozenset, iterable=[])
+        self.assertRaises(TypeError, bool, 1, 2)
+        self.assertRaises(TypeError, dict, 1)
+        self.assertRaises(TypeError, tuple, 1)
+        self.assertRaises(ValueError, int, 'x')
+        self.assertRaises(TypeError, lambda: dict(**{1: 2}))
+
+    def test_bound_method(self):
+        f = PYTHON_INSTANCE.method
+        self.assertEqual(list(map(f, [1, 2], [3, 4])), [[1, 3], [2, 4]])
+        f = PYTHON_INSTANCE.method_noarg
+        self.assertEqual(list(map(lambda g: g(), [f, f])), ['noarg', 'noarg'])
+        self.assertEqual(sorted([3, 1, 2], key=(-1).__mul__), [3, 2, 1])
+
+
 if __name__ == "__main__":
     unittest.main()
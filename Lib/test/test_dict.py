@@ -270,6 +270,71 @@ class DictTest(unittest.TestCase):
         res.update(a=None, b=None, c=None)
         self.assertEqual(baddict3.fromkeys({"a", "b", "c"}), res)
 
+    @support.cpython_only
+    def test_presized_from_length_hint(self):
+        # Iterables that report their length build the same dict as
+        # iterators that don't, and a hint inflated by repeated keys
+        # doesn't leave a large table behind.
+        keys = list(range(1000))
+        self.assertEqual(dict.fromkeys(keys), dict.fromkeys(iter(keys)))
+        self.assertEqual(dict(zip(keys, keys)),
+                         {k: k for k in keys})
+        self.assertEqual(list(dict(zip(keys, keys))), keys)
+        d = dict.fromkeys(keys * 10)
+        self.assertEqual(list(d), keys)
+        self.assertEqual(sys.getsizeof(d),
+                         sys.getsizeof(dict.fromkeys(iter(keys))))
+        d = dict([(0, 0)] * 1000)
+        self.assertEqual(d, {0: 0})
+        self.assertEqual(sys.getsizeof(d), sys.getsizeof({0: 0}))
+        d = {0: 0}
+        d.update(zip(keys, keys))
+        self.assertEqual(d, dict(zip(keys, keys)))
+        a = {i: i for i in range(100)}
+        b = {-i: i for i in range(1, 100)}
+        self.assertEqual({**a, **b},
+                         dict(list(a.items()) + list(b.items())))
+
+    @support.cpython_only
+    def test_presized_peak_memory(self):
+        # A length hint inflated by repeated keys doesn't allocate a
+        # table for all of them
+        tracemalloc = support.import_module('tracemalloc')
+        keys = [0] * 100000
+        for func in (dict.fromkeys, lambda keys: dict(zip(keys, keys)),
+                     lambda keys: {}.update(zip(keys, keys))):
+            with self.subTest(func=func):
+                tracemalloc.start()
+                try:
+                    func(keys)
+                    size, peak = tracemalloc.get_traced_memory()
+                finally:
+                    tracemalloc.stop()
+                self.assertLess(peak, 200000)
+
+    @support.cpython_only
+    def test_presized_large(self):
+        # A large dict built from distinct keys allocates about its final
+        # table only, instead of also holding the previous table while it
+        # is resized
+        tracemalloc = support.import_module('tracemalloc')
+        keys = list(range(100000))
+        def update(keys):
+            d = {}
+            d.update(zip(keys, keys))
+            return d
+        for func in (dict.fromkeys, lambda keys: dict(zip(keys, keys)),
+                     update):
+            with self.subTest(func=func):
+                tracemalloc.start()
+                try:
+                    d = func(keys)
+                    size, peak = tracemalloc.get_traced_memory()
+                finally:
+                    tracemalloc.stop()
+                self.assertEqual(len(d), len(keys))
+                self.assertLess(peak, sys.getsizeof(d) * 1.1)
+
     def test_copy(self):
         d = {1:1, 2:2, 3:3}
         self.assertEqual(d.copy(), {1:1, 2:2, 3:3})
@@ -720,6 +785,62 @@ class DictTest(unittest.TestCase):
         resizing = True
         d[9] = 6
 
+    def test_large_dicts(self):
+        # Large tables are probed by groups of slots
+        n = 50000
+        d = {}
+        for i in range(n):
+            d['k%d' % i] = i
+        self.assertEqual(len(d), n)
+        for i in range(n):
+            self.assertEqual(d['k%d' % i], i)
+        self.assertNotIn('k%d' % n, d)
+        for i in range(0, n, 2):
+            del d['k%d' % i]
+        self.assertEqual(len(d), n // 2)
+        self.assertNotIn('k0', d)
+        self.assertEqual(d['k1'], 1)
+        for i in range(0, n, 2):
+            d['k%d' % i] = -i
+        self.assertEqual(list(d)[:2], ['k1', 'k3'])
+        self.assertEqual(d.popitem(), ('k%d' % (n - 2), 2 - n))
+        self.assertEqual(d.setdefault('k4', 0), -4)
+        self.assertEqual(d.setdefault('new', 0), 0)
+
+        # Keys of other types, and colliding hashes
+        class Key:
+            def __init__(self, i):
+                self.i = i
+            def __hash__(self):
+                return self.i % 100
+            def __eq__(self, other):
+                return isinstance(other, Key) and self.i == other.i
+        d.update((i, i) for i in range(n))
+        d.update((Key(i), i) for i in range(1000))
+        for i in range(1000):
+            self.assertEqual(d[Key(i)], i)
+            self.assertEqual(d[i], i)
+        self.assertNotIn(Key(1000), d)
+        self.assertNotIn(n, d)
+        self.assertEqual(d.pop(Key(10)), 10)
+        self.assertNotIn(Key(10), d)
+
+    def test_large_dict_mutating_lookup(self):
+        # The lookup restarts if a comparison mutates a large dict
+        class Key:
+            def __hash__(self):
+                return 1
+            def __eq__(self, other):
+                if mutate:
+                    d.clear()
+                return False
+        mutate = False
+        d = {i: i for i in range(20000)}
+        d[Key()] = 1
+        mutate = True
+        self.assertNotIn(Key(), d)
+        self.assertEqual(d, {})
+
     def test_empty_presized_dict_in_freelist(self):
         # Bug #3537: if an empty but presized dict with a size larger
         # than 7 was in the freelist, it triggered an assertion failure
@@ -969,6 +1090,84 @@ class DictTest(unittest.TestCase):
         a.a = 3
         self.assertFalse(_testcapi.dict_hassplittable(a.__dict__))
 
+    @support.cpython_only
+    def test_splittable_key_order_variants(self):
+        """instances setting their attributes in another order keep
+        sharing keys"""
+        import _testcapi
+
+        class C:
+            def __init__(self, flip):
+                if flip:
+                    self.y, self.x = 1, 2
+                else:
+                    self.x, self.y = 1, 2
+
+        stats = sys._getdictsharingstats()
+        a, b, c, d = C(False), C(True), C(True), C(False)
+        for o in a, b, c, d:
+            self.assertTrue(_testcapi.dict_hassplittable(o.__dict__))
+        self.assertEqual(list(a.__dict__), ['x', 'y'])
+        self.assertEqual(list(b.__dict__), ['y', 'x'])
+        self.assertEqual(list(c.__dict__), ['y', 'x'])
+        self.assertEqual(c.__dict__, {'x': 2, 'y': 1})
+        self.assertEqual(sys.getsizeof(b.__dict__),
+                         sys.getsizeof(a.__dict__))
+        new_stats = sys._getdictsharingstats()
+        self.assertEqual(new_stats['variants_created'] -
+                         stats['variants_created'], 1)
+        self.assertEqual(new_stats['variant_switches'] -
+                         stats['variant_switches'], 1)
+        self.assertEqual(new_stats['order'] - stats['order'], 1)
+
+        # The number of variants is limited
+        for names in ('zyx', 'zxy', 'yzx', 'xzy', 'wxy'):
+            o = C.__new__(C)
+            for name in names:
+                setattr(o, name, name)
+            self.assertEqual(list(o.__dict__), list(names))
+        new_stats = sys._getdictsharingstats()
+        self.assertEqual(new_stats['variants_created'] -
+                         stats['variants_created'], 3)
+        o = C(True)
+        self.assertTrue(_testcapi.dict_hassplittable(o.__dict__))
+
+    @support.cpython_only
+    def test_splittable_del_keeps_sharing(self):
+        """deleting an attribute only unshares the keys of its instance"""
+        import _testcapi
+
+        class C:
+            pass
+
+        stats = sys._getdictsharingstats()
+        a = C()
+        a.x, a.y = 1, 2
+        del a.x
+        self.assertFalse(_testcapi.dict_hassplittable(a.__dict__))
+        b = C()
+        b.x, b.y = 1, 2
+        self.assertTrue(_testcapi.dict_hassplittable(b.__dict__))
+        new_stats = sys._getdictsharingstats()
+        self.assertEqual(new_stats['deletion'] - stats['deletion'], 1)
+        self.assertEqual(new_stats['created'] - stats['created'], 2)
+
+    @support.cpython_only
+    def test_dict_sharing_stats(self):
+        stats = sys._getdictsharingstats()
+        self.assertEqual(set(stats), {'created', 'unshared', 'order',
+                                      'deletion', 'non_str', 'full',
+                                      'other', 'variants_created',
+                                      'variant_switches'})
+        a, b = self.make_shared_key_dict(2)
+        a[1] = 1
+        b.pop('x')
+        new_stats = sys._getdictsharingstats()
+        self.assertEqual(new_stats['created'] - stats['created'], 2)
+        self.assertEqual(new_stats['unshared'] - stats['unshared'], 2)
+        self.assertEqual(new_stats['non_str'] - stats['non_str'], 1)
+        self.assertEqual(new_stats['deletion'] - stats['deletion'], 1)
+
     def test_iterator_pickling(self):
         for proto in range(pickle.HIGHEST_PROTOCOL + 1):
             data = {1:"a", 2:"b", 3:"c"}
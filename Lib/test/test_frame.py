@@ -1,9 +1,17 @@
+import os
+import sys
+import traceback
 import types
 import unittest
 import weakref
 
 from test import support
 
+try:
+    import _testcapi
+except ImportError:
+    _testcapi = None
+
 
 class ClearTest(unittest.TestCase):
     """
@@ -159,5 +167,145 @@ class FrameLocalsTest(unittest.TestCase):
         self.assertEqual(inner.f_locals, {})
 
 
+class LazyFrameTest(unittest.TestCase):
+    """
+    Tests for the frame objects created on demand for the frames of
+    function calls, which live on the data stack of the thread.
+    """
+
+    def test_frame_outlives_call(self):
+        def f():
+            x = 1
+            y = 'spam'
+            return sys._getframe()
+        frame = f()
+        self.assertEqual(frame.f_locals, {'x': 1, 'y': 'spam'})
+        self.assertEqual(frame.f_code, f.__code__)
+        self.assertEqual(frame.f_lineno, f.__code__.co_firstlineno + 3)
+        self.assertIs(frame.f_back.f_code,
+                      self.test_frame_outlives_call.__code__)
+
+    def test_executing_frame(self):
+        def f():
+            frame = sys._getframe()
+            first = frame.f_lineno, frame.f_lasti
+            x = 5
+            self.assertEqual(frame.f_locals['x'], 5)
+            self.assertGreater(frame.f_lineno, first[0])
+            self.assertGreater(frame.f_lasti, first[1])
+            self.assertIs(sys._getframe(), frame)
+            return frame
+        frame = f()
+        self.assertEqual(frame.f_locals['x'], 5)
+
+    def test_f_back(self):
+        def inner():
+            return sys._getframe(), sys._getframe(1)
+        def outer():
+            return inner()
+        frame, back = outer()
+        self.assertIs(frame.f_back, back)
+        self.assertEqual(back.f_code, outer.__code__)
+
+    def test_traceback(self):
+        def f(n):
+            depth = n
+            if n:
+                f(n - 1)
+            1/0
+        try:
+            f(3)
+        except ZeroDivisionError as e:
+            tb = e.__traceback__
+        frames = [frame for frame, lineno in traceback.walk_tb(tb)][1:]
+        self.assertEqual([frame.f_locals['depth'] for frame in frames],
+                         [3, 2, 1, 0])
+        for frame, back in zip(frames[1:], frames):
+            self.assertIs(frame.f_back, back)
+
+    def test_deep_recursion(self):
+        # Frames spanning several chunks of the data stack
+        def f(n, *args):
+            if n:
+                return f(n - 1, *args)
+            return sys._getframe()
+        for i in range(3):
+            frame = f(500, *range(100))
+            depth = 0
+            while frame.f_code is f.__code__:
+                frame = frame.f_back
+                depth += 1
+            self.assertEqual(depth, 501)
+
+    def test_refcycle(self):
+        class C:
+            pass
+        def f():
+            c = C()
+            frame = sys._getframe()
+            return weakref.ref(c)
+        wr = f()
+        support.gc_collect()
+        self.assertIsNone(wr())
+
+
+@unittest.skipIf(_testcapi is None, 'need _testcapi')
+class NewFrameTest(unittest.TestCase):
+    """
+    Tests for the callers of a frame created by PyFrame_New() while
+    function calls on the data stack execute.
+    """
+
+    code = compile('pass', '<new frame>', 'exec')
+
+    def test_getframe(self):
+        def outer():
+            lineno = sys._getframe().f_lineno + 1
+            return _testcapi.call_in_new_frame(self.code, inner), lineno
+        def inner():
+            frames = []
+            for i in range(4):
+                frames.append(sys._getframe(i))
+            return frames
+        frames, lineno = outer()
+        self.assertEqual([f.f_code for f in frames],
+                         [inner.__code__, self.code, outer.__code__,
+                          self.test_getframe.__code__])
+        self.assertEqual(frames[2].f_lineno, lineno)
+        self.assertIs(frames[1].f_back, frames[2])
+
+    def test_faulthandler(self):
+        import faulthandler
+        def outer():
+            lineno = sys._getframe().f_lineno + 1
+            return _testcapi.call_in_new_frame(self.code, inner), lineno
+        def inner():
+            with support.temp_dir() as path:
+                filename = os.path.join(path, 'dump')
+                with open(filename, 'w') as fp:
+                    faulthandler.dump_traceback(fp, all_threads=False)
+                with open(filename) as fp:
+                    return fp.read()
+        dump, lineno = outer()
+        self.assertIn('File "<new frame>"', dump)
+        self.assertIn('line %s in outer' % lineno, dump)
+        self.assertIn('in test_faulthandler', dump)
+
+    def test_warnings(self):
+        import warnings
+        def outer():
+            lineno = sys._getframe().f_lineno + 1
+            _testcapi.call_in_new_frame(self.code, inner)
+            return lineno
+        def inner():
+            warnings.warn('spam', UserWarning, stacklevel=3)
+        with warnings.catch_warnings(record=True) as w:
+            warnings.simplefilter('always')
+            lineno = outer()
+        self.assertEqual(len(w), 1)
+        self.assertEqual(w[0].filename, __file__)
+        self.assertEqual(w[0].lineno, lineno)
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -714,10 +714,20 @@ class GCTests(unittest.TestCase):
         for st in stats:
             self.assertIsInstance(st, dict)
             self.assertEqual(set(st),
-                             {"collected", "collections", "uncollectable"})
+                             {"collected", "collections", "uncollectable",
+                              "scanned", "total_pause", "max_pause",
+                              "weakrefs_time", "finalize_time",
+                              "delete_time"})
             self.assertGreaterEqual(st["collected"], 0)
             self.assertGreaterEqual(st["collections"], 0)
             self.assertGreaterEqual(st["uncollectable"], 0)
+            self.assertGreaterEqual(st["scanned"], 0)
+            self.assertGreaterEqual(st["total_pause"], st["max_pause"])
+            self.assertGreaterEqual(st["max_pause"], 0.0)
+            self.assertGreaterEqual(st["total_pause"],
+                                    st["weakrefs_time"] +
+                                    st["finalize_time"] +
+                                    st["delete_time"])
         # Check that collection counts are incremented correctly
         if gc.isenabled():
             self.addCleanup(gc.enable)
@@ -733,6 +743,28 @@ class GCTests(unittest.TestCase):
         self.assertEqual(new[0]["collections"], old[0]["collections"] + 1)
         self.assertEqual(new[1]["collections"], old[1]["collections"])
         self.assertEqual(new[2]["collections"], old[2]["collections"] + 1)
+        self.assertGreater(new[2]["scanned"], old[2]["scanned"])
+        self.assertGreaterEqual(new[2]["total_pause"], old[2]["total_pause"])
+        self.assertGreaterEqual(new[2]["max_pause"], old[2]["max_pause"])
+
+    @cpython_only
+    def test_get_untracked_count(self):
+        x = 1.5
+        count = gc.get_untracked_count()
+        t = (x, "a")
+        self.assertEqual(gc.get_untracked_count(), count + 1)
+        u = (x, [])
+        self.assertEqual(gc.get_untracked_count(), count + 1)
+        f = frozenset(t)
+        self.assertEqual(gc.get_untracked_count(), count + 2)
+        # The empty tuple singleton is not counted
+        def g(*args, **kwargs):
+            return args
+        kwargs = {}
+        self.assertEqual(g(**kwargs), ())
+        self.assertEqual(tuple([]), ())
+        self.assertEqual(t[2:], ())
+        self.assertEqual(gc.get_untracked_count(), count + 2)
 
     def test_freeze(self):
         gc.freeze()
@@ -740,6 +772,35 @@ class GCTests(unittest.TestCase):
         gc.unfreeze()
         self.assertEqual(gc.get_freeze_count(), 0)
 
+    def test_freeze_not_collected(self):
+        # Frozen objects are not examined by collections, so an unreachable
+        # frozen cycle stays alive until it is unfrozen.
+        if gc.isenabled():
+            self.addCleanup(gc.enable)
+            gc.disable()
+        collected = []
+        class A:
+            pass
+        a = A()
+        a.cycle = a
+        wr = weakref.ref(a, lambda wr: collected.append('a'))
+        gc.freeze()
+        try:
+            self.assertFalse(any(o is a for o in gc.get_objects()))
+            self.assertTrue(gc.is_tracked(a))
+            b = A()
+            b.cycle = b
+            wrb = weakref.ref(b, lambda wr: collected.append('b'))
+            del a, b
+            gc.collect()
+            self.assertEqual(collected, ['b'])
+            self.assertIsNotNone(wr())
+        finally:
+            gc.unfreeze()
+        gc.collect()
+        self.assertEqual(collected, ['b', 'a'])
+        self.assertIsNone(wr())
+
 
 class GCCallbackTests(unittest.TestCase):
     def setUp(self):
@@ -819,6 +880,39 @@ class GCCallbackTests(unittest.TestCase):
             self.assertTrue("collected" in info)
             self.assertTrue("uncollectable" in info)
 
+    def test_collect_pause(self):
+        self.preclean()
+        gc.collect()
+        start, stop = [v[2] for v in self.visit if v[0] == 1]
+        self.assertFalse(start["incremental"])
+        self.assertFalse(stop["incremental"])
+        self.assertGreaterEqual(stop["pause"], 0.0)
+        self.assertEqual(len(stop["pause_histogram"]), 12)
+        self.assertEqual(sum(stop["pause_histogram"]),
+                         sum(start["pause_histogram"]) + 1)
+
+    def test_collect_phase_times(self):
+        self.preclean()
+        # A cycle with a finalizer and a weakref callback, so that every
+        # phase of the collection has work to do.
+        class A:
+            def __del__(self):
+                pass
+        a = A()
+        a.cycle = a
+        wr = weakref.ref(a, lambda wr: None)
+        del a
+        gc.collect()
+        stop = [v[2] for v in self.visit if v[0] == 1 and v[1] == "stop"][-1]
+        self.assertGreaterEqual(stop["collected"], 2)
+        self.assertGreaterEqual(stop["scanned"], stop["collected"])
+        for key in ("weakrefs_time", "finalize_time", "delete_time"):
+            self.assertGreaterEqual(stop[key], 0.0)
+        self.assertGreaterEqual(stop["pause"],
+                                stop["weakrefs_time"] +
+                                stop["finalize_time"] +
+                                stop["delete_time"])
+
     def test_collect_generation(self):
         self.preclean()
         gc.collect(2)
@@ -863,6 +957,210 @@ class GCCallbackTests(unittest.TestCase):
         self.assertEqual(len(gc.garbage), 0)
 
 
+class GCIncrementalTests(unittest.TestCase):
+    def setUp(self):
+        self.enabled = gc.isenabled()
+        self.threshold = gc.get_threshold()
+        gc.collect()
+        gc.set_incremental(0.001)
+        # Every automatic collection is a slice
+        gc.set_threshold(100, 0, 0)
+        gc.enable()
+        self.slices = []
+        self.full_collections = []
+        gc.callbacks.append(self.callback)
+
+    def tearDown(self):
+        gc.callbacks.remove(self.callback)
+        gc.set_incremental(0)
+        gc.set_threshold(*self.threshold)
+        if not self.enabled:
+            gc.disable()
+        gc.collect()
+
+    def callback(self, phase, info):
+        if phase == "stop" and info["incremental"]:
+            self.slices.append(info)
+        elif phase == "stop" and info["generation"] == 2:
+            self.full_collections.append(info)
+
+    def run_slices(self, predicate):
+        # Make garbage cycles until the predicate is true, so that
+        # slices run meanwhile.
+        for i in range(10**6):
+            if predicate():
+                return True
+            x = []
+            x.append(x)
+        return False
+
+    def make_cycle(self):
+        a = C1055820(1)
+        a.loop = a
+        return a, weakref.ref(a)
+
+    def test_set_incremental(self):
+        self.assertEqual(gc.get_incremental(), 0.001)
+        gc.set_incremental(0.5)
+        self.assertEqual(gc.get_incremental(), 0.5)
+        self.assertRaises(ValueError, gc.set_incremental, -1.0)
+        self.assertRaises(ValueError, gc.set_incremental, float('nan'))
+        self.assertEqual(gc.get_incremental(), 0.5)
+        gc.set_incremental(0)
+        self.assertEqual(gc.get_incremental(), 0.0)
+
+    def test_young_cycle(self):
+        a, wr = self.make_cycle()
+        del a
+        self.assertTrue(self.run_slices(
+            lambda: wr() is None and self.slices))
+        for info in self.slices:
+            self.assertEqual(info["generation"], 2)
+            self.assertGreaterEqual(info["pause"], 0.0)
+            self.assertEqual(len(info["pause_histogram"]), 12)
+
+    def test_old_cycles(self):
+        cycles = [self.make_cycle() for i in range(100)]
+        # Move the cycles to the oldest generation
+        gc.set_incremental(0)
+        gc.collect()
+        gc.set_incremental(0.001)
+        refs = [wr for a, wr in cycles]
+        del cycles
+        self.assertTrue(self.run_slices(
+            lambda: all(wr() is None for wr in refs)))
+        self.assertGreater(len(self.slices), 1)
+
+    def test_live_objects(self):
+        # Objects reachable from outside an increment are never collected
+        objs = [[[i]] for i in range(10000)]
+        refs = []
+        for i in range(100):
+            a, wr = self.make_cycle()
+            a.objs = objs
+            refs.append(wr)
+        del a
+        self.assertTrue(self.run_slices(
+            lambda: all(wr() is None for wr in refs)))
+        self.assertEqual(objs, [[[i]] for i in range(10000)])
+        for obj in objs:
+            self.assertTrue(gc.is_tracked(obj))
+        self.assertIn(objs[-1], gc.get_referrers(objs[-1][0]))
+
+    def test_deep_heap(self):
+        # A slice stops following references at its size, even in a long
+        # chain of objects.  The cycle is larger than any slice, so it is
+        # found by a full collection ending a pass, once enough objects
+        # survived the younger generations.
+        class Node:
+            pass
+        n = 100000
+        first = node = Node()
+        for i in range(n):
+            node.next = Node()
+            node = node.next
+        node.next = first
+        wr = weakref.ref(first)
+        gc.set_incremental(0)
+        gc.collect()
+        gc.set_incremental(0.001)
+        del first, node
+        self.full_collections.clear()
+        live = []
+        self.assertTrue(self.run_slices(
+            lambda: live.append([]) or wr() is None))
+        self.assertEqual(len(self.full_collections), 1)
+        self.assertGreater(self.full_collections[0]["collected"], 2 * n)
+        self.assertGreater(len(self.slices), 1)
+        for info in self.slices:
+            self.assertLess(info["scanned"], n // 2)
+        pauses = sorted(info["pause"] for info in self.slices)
+        self.assertLess(pauses[len(pauses) // 2], 0.005)
+
+    def test_frozen(self):
+        frozen, frozen_wr = self.make_cycle()
+        gc.freeze()
+        try:
+            del frozen
+            a, wr = self.make_cycle()
+            gc.set_incremental(0)
+            gc.collect()
+            gc.set_incremental(0.001)
+            del a
+            # Once the cycle in the oldest generation is collected, the
+            # frozen cycle was skipped by at least one pass.
+            self.assertTrue(self.run_slices(lambda: wr() is None))
+            self.assertIsNotNone(frozen_wr())
+        finally:
+            gc.unfreeze()
+        gc.collect()
+        self.assertIsNone(frozen_wr())
+
+
+class GCAdaptiveThresholdTests(unittest.TestCase):
+    def setUp(self):
+        self.enabled = gc.isenabled()
+        self.threshold = gc.get_threshold()
+        gc.collect()
+        gc.set_threshold(100)
+        gc.set_adaptive_threshold(10000)
+        gc.enable()
+
+    def tearDown(self):
+        gc.set_adaptive_threshold(0)
+        gc.set_threshold(*self.threshold)
+        if not self.enabled:
+            gc.disable()
+        gc.collect()
+
+    def young_collections(self, func):
+        before = gc.get_stats()
+        func()
+        after = gc.get_stats()
+        return sum(after[i]["collections"] - before[i]["collections"]
+                   for i in range(2))
+
+    def test_set_adaptive_threshold(self):
+        self.assertEqual(gc.get_adaptive_threshold(), 10000)
+        self.assertRaises(ValueError, gc.set_adaptive_threshold, -1)
+        self.assertEqual(gc.get_adaptive_threshold(), 10000)
+        # The threshold set by the user is still reported
+        self.assertEqual(gc.get_threshold()[0], 100)
+        gc.set_adaptive_threshold(0)
+        self.assertEqual(gc.get_adaptive_threshold(), 0)
+
+    def test_live_objects(self):
+        # Collections finding no garbage grow the threshold
+        live = []
+        def allocate():
+            for i in range(100000):
+                live.append([i])
+        self.assertLess(self.young_collections(allocate), 100)
+        self.assertEqual(gc.get_threshold()[0], 100)
+
+    def test_garbage(self):
+        def allocate_garbage():
+            for i in range(100000):
+                x = []
+                x.append(x)
+        gc.set_adaptive_threshold(0)
+        expected = self.young_collections(allocate_garbage)
+        gc.set_adaptive_threshold(10000)
+        live = []
+        for i in range(100000):
+            live.append([i])
+        # Collections finding much garbage shrink the threshold back to
+        # the one set by the user
+        self.assertGreater(self.young_collections(allocate_garbage),
+                           expected * 0.8)
+
+    def test_disable(self):
+        gc.set_adaptive_threshold(0)
+        def allocate():
+            live = [[i] for i in range(10000)]
+        self.assertGreater(self.young_collections(allocate), 50)
+
+
 class GCTogglingTests(unittest.TestCase):
     def setUp(self):
         gc.enable()
@@ -1016,7 +1314,8 @@ def test_main():
 
     try:
         gc.collect() # Delete 2nd generation garbage
-        run_unittest(GCTests, GCTogglingTests, GCCallbackTests)
+        run_unittest(GCTests, GCTogglingTests, GCCallbackTests,
+                     GCIncrementalTests, GCAdaptiveThresholdTests)
     finally:
         gc.set_debug(debug)
         # test gc.enable() even if GC is disabled by default
@@ -516,5 +516,86 @@ class IntTestCases(unittest.TestCase):
         self.assertEqual(int('1_2_3_4_5_6_7', 32), 1144132807)
 
 
+class PyLongModuleTests(unittest.TestCase):
+    # Tests of the functions in _pylong.py, which get used when the
+    # values have enough digits.
+
+    def _test_int_to_decimal(self, n, suffix):
+        s = str(n)
+        self.assertEqual(s[-10:], suffix)
+        self.assertEqual(str(-n), '-' + s)
+        self.assertEqual('%d' % n, s)
+        self.assertEqual(b'%d' % n, s.encode('ascii'))
+        self.assertEqual(format(n, ',').replace(',', ''), s)
+        self.assertEqual(str(IntSubclass(n)), s)
+
+    def test_int_to_decimal(self):
+        n = 1 << 100000
+        self._test_int_to_decimal(n, '9883109376')
+        self._test_int_to_decimal(n - 1, '9883109375')
+        self._test_int_to_decimal(10**30000, '0000000000')
+        self._test_int_to_decimal(10**30000 - 1, '9999999999')
+
+    def test_pure_int_to_decimal(self):
+        import _pylong
+        for n in (0, 1, 10**5000, 10**5000 - 1, 1 << 33333, 3**20000):
+            self.assertEqual(_pylong._int_to_decimal_string_pure(n), str(n))
+
+    def test_str_to_int(self):
+        v1 = 1 << 100000
+        s = str(v1)
+        self.assertEqual(int(s), v1)
+        self.assertEqual(int(' -' + s), -v1)
+        self.assertEqual(int(' +' + s + ' '), v1)
+        self.assertEqual(int(s[:5000] + '_' + s[5000:]), v1)
+        self.assertEqual(int(s.encode('ascii')), v1)
+        self.assertEqual(int('-' + '0' * 7000 + '1'), -1)
+        self.assertEqual(int('0' * 7000, 0), 0)
+        for bad in (s + 'z', s + '_', '_' + s, s[:5000] + '__' + s[5000:]):
+            with self.assertRaises(ValueError):
+                int(bad)
+        with self.assertRaises(ValueError):
+            int('0' * 7000 + '1', 0)
+
+    def test_divmod(self):
+        n = 1 << 100000
+        self.assertEqual(divmod(n * 3 + 1, n), (3, 1))
+        a = 7**60000 + 12345
+        b = 3**30000 + 1
+        for sa in 1, -1:
+            for sb in 1, -1:
+                q, r = divmod(sa * a, sb * b)
+                self.assertEqual(q * sb * b + r, sa * a)
+                self.assertLess(abs(r), b)
+                self.assertTrue(r == 0 or (r < 0) == (sb < 0))
+                self.assertEqual(sa * a // (sb * b), q)
+                self.assertEqual(sa * a % (sb * b), r)
+        m = b | 1
+        self.assertEqual(pow(a, 3, m), a * a % m * a % m)
+
+    def test_without_module(self):
+        # The C algorithms are used when _pylong can't be imported
+        n = 7**30000
+        s = str(n)
+        with support.swap_item(sys.modules, '_pylong', None):
+            self.assertEqual(str(n), s)
+            self.assertEqual(int(s), n)
+            self.assertEqual(divmod(n, 3**20000 + 1),
+                             (n // (3**20000 + 1), n % (3**20000 + 1)))
+
+    @support.cpython_only
+    def test_errors_propagate(self):
+        import _pylong
+        from unittest import mock
+        n = 7**30000
+        s = str(n)
+        for name, func, args in [('int_to_decimal_string', str, (n,)),
+                                 ('int_from_string', int, (s,)),
+                                 ('int_divmod', divmod, (n, 3**20000 + 1))]:
+            with mock.patch.object(_pylong, name, side_effect=OverflowError):
+                with self.assertRaises(OverflowError):
+                    func(*args)
+
+
 if __name__ == "__main__":
     unittest.main()
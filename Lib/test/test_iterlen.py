@@ -33,6 +33,9 @@ Reversed objects can also be wrapped around mutable objects; however, any
 appends after the current position are ignored.  Any other approach leads
 to confusion and possibly returning the same item more than once.
 
+A zip object reports the shortest length among the iterators it wraps, as
+long as all of them can report theirs.
+
 The iterators not listed above, such as enumerate and the other itertools,
 are not length transparent because they have no way to distinguish between
 iterables that report static length and iterators whose length changes with
@@ -96,6 +99,16 @@ class TestTuple(TestInvariantWithoutMutations, unittest.TestCase):
     def setUp(self):
         self.it = iter(tuple(range(n)))
 
+class TestZip(TestInvariantWithoutMutations, unittest.TestCase):
+
+    def setUp(self):
+        self.it = zip(range(n), iter(range(n + 5)), repeat(None, n + 1))
+
+    def test_unknown_lengths(self):
+        self.assertEqual(length_hint(zip(range(n), (i for i in range(n))),
+                                     -1), -1)
+        self.assertEqual(length_hint(zip(), -1), 0)
+
 ## ------- Types that should not be mutated during iteration -------
 
 class TestDeque(TestTemporarilyImmutable, unittest.TestCase):
@@ -208,6 +221,20 @@ class NoneLengthHint(object):
         return NotImplemented
 
 
+class BadLengthHintIterator(object):
+    def __init__(self, exc):
+        self.exc = exc
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+        raise StopIteration
+
+    def __length_hint__(self):
+        raise self.exc
+
+
 class TestLengthHintExceptions(unittest.TestCase):
 
     def test_issue1242657(self):
@@ -218,10 +245,29 @@ class TestLengthHintExceptions(unittest.TestCase):
         b = bytearray(range(10))
         self.assertRaises(RuntimeError, b.extend, BadLen())
         self.assertRaises(RuntimeError, b.extend, BadLengthHint())
+        for func in dict, dict.fromkeys, set, frozenset, set().update:
+            self.assertRaises(RuntimeError, func, BadLen())
+            self.assertRaises(RuntimeError, func, BadLengthHint())
 
     def test_invalid_hint(self):
         # Make sure an invalid result doesn't muck-up the works
         self.assertEqual(list(NoneLengthHint()), list(range(10)))
+        self.assertEqual(set(NoneLengthHint()), set(range(10)))
+        self.assertEqual(dict.fromkeys(NoneLengthHint()),
+                         dict.fromkeys(range(10)))
+
+    def test_zip_bad_hint(self):
+        # zip reports an unknown length instead of the error of the hint
+        # of one of its iterators
+        for exc in RuntimeError, TypeError:
+            it = BadLengthHintIterator(exc)
+            self.assertEqual(length_hint(zip(range(3), it), -1), -1)
+            it = BadLengthHintIterator(exc)
+            self.assertEqual(list(zip(range(3), it)), [])
+            it = BadLengthHintIterator(exc)
+            self.assertEqual(dict(zip(range(3), it)), {})
+        it = zip(range(3), iter(NoneLengthHint()), NoneLengthHint())
+        self.assertEqual(length_hint(it, -1), 3)
 
 
 if __name__ == "__main__":
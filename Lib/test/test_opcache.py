@@ -0,0 +1,261 @@
+import builtins
+import sys
+import unittest
+from test import support
+
+# _PyCode_OPCACHE_MIN_RUNS in Include/internal/code.h: the opcode cache of
+# a code object is allocated when it starts its MIN_RUNS-th run.
+MIN_RUNS = 1024
+
+# Must be larger than MIN_RUNS, so that the opcode cache of the tested
+# functions gets allocated.
+WARMUP = 2000
+
+
+def warm(func, *args):
+    for _ in range(WARMUP):
+        func(*args)
+
+
+class TestLoadGlobalCache(unittest.TestCase):
+
+    def setUp(self):
+        self.namespace = {}
+
+    def make_function(self, source, name='f'):
+        exec(source, self.namespace)
+        return self.namespace[name]
+
+    def test_global_rebinding(self):
+        f = self.make_function("x = 1\ndef f():\n    return x\n")
+        warm(f)
+        self.assertEqual(f(), 1)
+        self.namespace['x'] = 2
+        self.assertEqual(f(), 2)
+
+    def test_builtin_shadowed_by_global(self):
+        f = self.make_function("def f(s):\n    return len(s)\n")
+        warm(f, 'abc')
+        self.assertEqual(f('abc'), 3)
+        self.namespace['len'] = lambda s: 'shadowed'
+        self.assertEqual(f('abc'), 'shadowed')
+        del self.namespace['len']
+        self.assertEqual(f('abc'), 3)
+
+    def test_builtin_replaced(self):
+        f = self.make_function("def f():\n    return _opcache_test_name\n")
+        builtins._opcache_test_name = 1
+        try:
+            warm(f)
+            self.assertEqual(f(), 1)
+            builtins._opcache_test_name = 2
+            self.assertEqual(f(), 2)
+        finally:
+            del builtins._opcache_test_name
+        self.assertRaises(NameError, f)
+
+    def test_global_deleted(self):
+        f = self.make_function("y = 1\ndef f():\n    return y\n")
+        warm(f)
+        del self.namespace['y']
+        self.assertRaises(NameError, f)
+        self.namespace['y'] = 3
+        self.assertEqual(f(), 3)
+
+
+class TestLoadAttrCache(unittest.TestCase):
+
+    def test_instance_attribute(self):
+        class C:
+            def __init__(self, x):
+                self.x = x
+        def f(o):
+            return o.x
+        warm(f, C(1))
+        self.assertEqual(f(C(2)), 2)
+        o = C(3)
+        del o.x
+        self.assertRaises(AttributeError, f, o)
+        o.__dict__['x'] = 4
+        self.assertEqual(f(o), 4)
+
+    def test_class_modified(self):
+        class C:
+            def __init__(self):
+                self.x = 'instance'
+        def f(o):
+            return o.x
+        o = C()
+        warm(f, o)
+        C.x = property(lambda self: 'property')
+        self.assertEqual(f(o), 'property')
+        del C.x
+        self.assertEqual(f(o), 'instance')
+
+    def test_polymorphic(self):
+        class A:
+            def __init__(self):
+                self.x = 'A'
+        class B:
+            x = 'B'
+        def f(o):
+            return o.x
+        objs = [A(), B()]
+        for _ in range(WARMUP):
+            for o in objs:
+                f(o)
+        self.assertEqual([f(o) for o in objs], ['A', 'B'])
+
+    def test_slots(self):
+        class C:
+            __slots__ = ('x',)
+        def f(o):
+            return o.x
+        o = C()
+        o.x = 1
+        warm(f, o)
+        self.assertEqual(f(o), 1)
+        del o.x
+        self.assertRaises(AttributeError, f, o)
+
+    def test_foreign_slot_descriptor(self):
+        class A:
+            __slots__ = ('x',)
+        class B:
+            pass
+        B.x = A.__dict__['x']
+        def f(o):
+            return o.x
+        a = A()
+        a.x = 1
+        b = B()
+        for _ in range(WARMUP):
+            self.assertRaises(TypeError, f, b)
+        self.assertEqual(f(a), 1)
+
+
+class TestLoadMethodCache(unittest.TestCase):
+
+    def test_method_shadowed_by_instance(self):
+        class C:
+            def meth(self):
+                return 'method'
+        def f(o):
+            return o.meth()
+        warm(f, C())
+        o = C()
+        o.meth = lambda: 'instance'
+        self.assertEqual(f(o), 'instance')
+        self.assertEqual(f(C()), 'method')
+
+    def test_method_replaced(self):
+        class C:
+            def meth(self):
+                return 'old'
+        def f(o):
+            return o.meth()
+        warm(f, C())
+        C.meth = lambda self: 'new'
+        self.assertEqual(f(C()), 'new')
+
+    def test_builtin_method(self):
+        def f(o):
+            return o.upper()
+        warm(f, 'a')
+        self.assertEqual(f('b'), 'B')
+        self.assertEqual(f(b'c'), b'C')
+
+
+class TestSpecialization(unittest.TestCase):
+
+    def test_int(self):
+        def f(a, b):
+            return (a + b, a - b, a * b, a < b, a == b, a >= b)
+        warm(f, 3, 4)
+        self.assertEqual(f(3, 4), (7, -1, 12, True, False, False))
+        self.assertEqual(f(-5, 0), (-5, -5, 0, True, False, False))
+        big = 2 ** 100
+        self.assertEqual(f(big, 1),
+                         (big + 1, big - 1, big, False, False, True))
+        self.assertEqual(f(-2 ** 30, 2 ** 30),
+                         (0, -2 ** 31, -2 ** 60, True, False, False))
+
+    def test_float(self):
+        def f(a, b):
+            return (a + b, a - b, a * b, a < b, a != b, a <= b)
+        warm(f, 1.5, 2.0)
+        self.assertEqual(f(1.5, 2.0), (3.5, -0.5, 3.0, True, True, True))
+        nan = float('nan')
+        self.assertEqual(f(nan, nan)[3:], (False, True, False))
+
+    def test_str(self):
+        def f(a, b):
+            return (a == b, a != b, a < b)
+        warm(f, 'abc', 'abd')
+        self.assertEqual(f('abc', 'abd'), (False, True, True))
+        self.assertEqual(f('x', 'x'), (True, False, False))
+        self.assertEqual(f('€', '€'), (True, False, False))
+
+    def test_type_change(self):
+        def f(a, b):
+            return a + b
+        warm(f, 1, 2)
+        self.assertEqual(f(1.5, 2), 3.5)
+        self.assertEqual(f('a', 'b'), 'ab')
+        self.assertEqual(f([1], [2]), [1, 2])
+        self.assertRaises(TypeError, f, 1, 'a')
+        # Polymorphic instructions eventually go back to the generic one
+        for _ in range(WARMUP):
+            self.assertEqual(f(1, 2), 3)
+            self.assertEqual(f(1.0, 2.0), 3.0)
+
+    def test_subclass(self):
+        class MyInt(int):
+            def __add__(self, other):
+                return 'MyInt'
+        def f(a, b):
+            return a + b
+        warm(f, 1, 2)
+        self.assertEqual(f(MyInt(1), 2), 'MyInt')
+
+    def test_stats(self):
+        def f(a, b):
+            return a * b
+        warm(f, 2, 3)
+        stats = sys._getspecializationstats()
+        self.assertEqual(set(stats['BINARY_MULTIPLY']), {'failure'})
+        self.assertEqual(set(stats['BINARY_MULTIPLY_INT']),
+                         {'specialized', 'hit', 'miss', 'deopt'})
+        self.assertGreaterEqual(stats['BINARY_MULTIPLY_INT']['specialized'], 1)
+        hits = stats['BINARY_MULTIPLY_INT']['hit']
+        f(2, 3)
+        stats = sys._getspecializationstats()
+        self.assertEqual(stats['BINARY_MULTIPLY_INT']['hit'], hits + 1)
+
+
+class TestOpcacheAllocation(unittest.TestCase):
+
+    @support.cpython_only
+    def test_nomemory(self):
+        # A failed allocation of the cache raises MemoryError, not
+        # SystemError
+        _testcapi = support.import_module('_testcapi')
+        def f():
+            return len
+        for _ in range(MIN_RUNS - 1):
+            f()
+        try:
+            _testcapi.set_nomemory(0, 1)
+            try:
+                f()
+            finally:
+                _testcapi.remove_mem_hooks()
+        except MemoryError:
+            pass
+        else:
+            self.fail("MemoryError not raised")
+        self.assertIs(f(), len)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -5,6 +5,7 @@ import weakref
 import operator
 import copy
 import pickle
+import sys
 from random import randrange, shuffle
 import warnings
 import collections
@@ -58,6 +59,46 @@ class TestJointOps:
         self.assertRaises(PassThru, self.thetype, check_pass_thru())
         self.assertRaises(TypeError, self.thetype, [[]])
 
+    @support.cpython_only
+    def test_presized_from_length_hint(self):
+        # A length hint inflated by duplicates doesn't leave a large
+        # table behind
+        items = list(range(100))
+        self.assertEqual(self.thetype(items * 50), self.thetype(items))
+        self.assertLessEqual(sys.getsizeof(self.thetype(items * 50)),
+                             2 * sys.getsizeof(self.thetype(iter(items))))
+        s = self.thetype([0] * 1000)
+        self.assertEqual(sys.getsizeof(s), sys.getsizeof(self.thetype([0])))
+
+    @support.cpython_only
+    def test_presized_peak_memory(self):
+        # A length hint inflated by duplicates doesn't allocate a table
+        # for all of them
+        tracemalloc = support.import_module('tracemalloc')
+        items = [0] * 100000
+        tracemalloc.start()
+        try:
+            self.thetype(items)
+            size, peak = tracemalloc.get_traced_memory()
+        finally:
+            tracemalloc.stop()
+        self.assertLess(peak, 200000)
+
+    @support.cpython_only
+    def test_presized_large(self):
+        # A large set built from distinct items allocates about its final
+        # table only
+        tracemalloc = support.import_module('tracemalloc')
+        items = list(range(100000))
+        tracemalloc.start()
+        try:
+            s = self.thetype(items)
+            size, peak = tracemalloc.get_traced_memory()
+        finally:
+            tracemalloc.stop()
+        self.assertEqual(len(s), len(items))
+        self.assertLess(peak, sys.getsizeof(s) * 1.1)
+
     def test_len(self):
         self.assertEqual(len(self.s), len(self.d))
 
@@ -689,6 +730,18 @@ class TestFrozenSet(TestJointOps, unittest.TestCase):
         t = self.thetype(s)
         self.assertEqual(id(s), id(t))
 
+    @support.cpython_only
+    def test_track_at_creation(self):
+        # Frozensets of atomic objects are untracked when created
+        class A:
+            pass
+        self.assertFalse(gc.is_tracked(frozenset(self.word)))
+        self.assertFalse(gc.is_tracked(frozenset([1, (2, 3), frozenset([4])])))
+        self.assertTrue(gc.is_tracked(frozenset([1, A()])))
+        self.assertTrue(gc.is_tracked(frozenset([(1, A())])))
+        # Frozensets built by set operations are left to the collector
+        self.assertTrue(gc.is_tracked(frozenset([1]) | frozenset([A()])))
+
     def test_hash(self):
         self.assertEqual(hash(self.thetype('abcdeb')),
                          hash(self.thetype('ebecda')))
@@ -259,6 +259,118 @@ class TestDecorateSortUndecorate(unittest.TestCase):
         copy2.sort(key=lambda x: x[0], reverse=True)
         self.assertEqual(data, copy2)
 
+#==============================================================================
+def check_against_PyObject_RichCompare(test, L):
+    # unsafe_tuple_compare uses PyObject_RichCompareBool for the second
+    # elements of tuples, so
+    #     sorted(L) == [y[1] for y in sorted([(0, x) for x in L])]
+    # as long as x == y implies not x < y for the objects in L.  Comparing
+    # against that keeps the specialized compares consistent with the
+    # generic rich comparison.  L, [(x,) for x in L] and [((x,),) for x in L]
+    # are all checked, after a shuffle.
+    random.seed(0)
+    random.shuffle(L)
+    for L in [L[:], [(x,) for x in L], [((x,),) for x in L]]:
+        optimized = sorted(L)
+        reference = [y[1] for y in sorted([(0, x) for x in L])]
+        for opt, ref in zip(optimized, reference):
+            # Not assertEqual: the behavior must be *identical*
+            test.assertIs(opt, ref)
+
+class TestOptimizedCompares(unittest.TestCase):
+
+    def test_safe_object_compare(self):
+        heterogeneous_lists = [[0, 'foo'],
+                               [0.0, 'foo'],
+                               [('foo',), 'foo']]
+        for L in heterogeneous_lists:
+            self.assertRaises(TypeError, L.sort)
+            self.assertRaises(TypeError, [(x,) for x in L].sort)
+            self.assertRaises(TypeError, [((x,),) for x in L].sort)
+
+        float_int_lists = [[1, 1.1],
+                           [1<<70, 1.1],
+                           [1.1, 1],
+                           [1.1, 1<<70]]
+        for L in float_int_lists:
+            check_against_PyObject_RichCompare(self, L)
+
+    def test_unsafe_object_compare(self):
+        # unsafe_object_compare must check that the type of a key still has
+        # the tp_richcompare found by the pre-sort check.
+        class WackyComparator(int):
+            def __lt__(self, other):
+                elem.__class__ = WackyList2
+                return int.__lt__(self, other)
+
+        class WackyList1(list):
+            pass
+
+        class WackyList2(list):
+            def __lt__(self, other):
+                raise ValueError
+
+        L = [WackyList1([WackyComparator(i), i]) for i in range(10)]
+        elem = L[-1]
+        with self.assertRaises(ValueError):
+            L.sort()
+
+        L = [WackyList1([WackyComparator(i), i]) for i in range(10)]
+        elem = L[-1]
+        with self.assertRaises(ValueError):
+            [(x,) for x in L].sort()
+
+        # It must also handle NotImplemented.
+        class PointlessComparator:
+            def __lt__(self, other):
+                return NotImplemented
+        L = [PointlessComparator(), PointlessComparator()]
+        self.assertRaises(TypeError, L.sort)
+        self.assertRaises(TypeError, [(x,) for x in L].sort)
+
+        # Types that select unsafe_object_compare
+        lists = [list(range(100)) + [(1<<70)],
+                 [str(x) for x in range(100)] + ['\uffff'],
+                 [bytes(x) for x in range(100)],
+                 [cmp_to_key(lambda x,y: x<y)(x) for x in range(100)]]
+        for L in lists:
+            check_against_PyObject_RichCompare(self, L)
+
+    def test_unsafe_latin_compare(self):
+        check_against_PyObject_RichCompare(self, [str(x) for x in range(100)])
+        check_against_PyObject_RichCompare(self, ['', 'a', 'ab', 'b', '\xff',
+                                                  'a\x00', '\x00', 'ba'])
+
+    def test_unsafe_long_compare(self):
+        check_against_PyObject_RichCompare(self, [x for x in range(100)])
+        check_against_PyObject_RichCompare(self, [x - 50 for x in range(100)])
+        check_against_PyObject_RichCompare(self, [-(1<<30) + 1, (1<<30) - 1,
+                                                  0, -1, 1])
+
+    def test_unsafe_float_compare(self):
+        check_against_PyObject_RichCompare(self,
+                                           [float(x) for x in range(100)])
+
+    def test_unsafe_tuple_compare(self):
+        # The tuple compare must respect the current tuple compare
+        # semantics, which do not guarantee that x < x <=> (x,) < (x,)
+        #
+        # check_against_PyObject_RichCompare puts the items in tuples
+        # itself.
+        check_against_PyObject_RichCompare(self, [float('nan')]*100)
+        check_against_PyObject_RichCompare(self, [float('nan')
+                                                  for _ in range(100)])
+
+    def test_mixed_tuples(self):
+        # Tuples of the same length whose first items differ in type are
+        # compared with the generic comparison
+        L = [(1, 'a'), (1.5, 'b'), (0, 'c'), (True, 'd')]
+        self.assertEqual(sorted(L), [(0, 'c'), (1, 'a'), (True, 'd'),
+                                     (1.5, 'b')])
+        self.assertRaises(TypeError, sorted, [(1,), ('a',)])
+        self.assertRaises(TypeError, sorted, [(1,), 2])
+        self.assertRaises(TypeError, sorted, [(1,), ()] + [(2,)]*3 + [3])
+
 #==============================================================================
 
 if __name__ == "__main__":
@@ -1,6 +1,7 @@
 import unittest, test.support
 from test.support.script_helper import assert_python_ok, assert_python_failure
 import sys, io, os
+import re
 import struct
 import subprocess
 import textwrap
@@ -11,6 +12,7 @@ import gc
 import sysconfig
 import locale
 import threading
+import time
 
 # count the number of test runs, used to create unique
 # strings to intern in test_intern()
@@ -184,6 +186,99 @@ class SysModuleTest(unittest.TestCase):
         finally:
             sys.setswitchinterval(orig)
 
+    def test_gilscheduling(self):
+        self.assertRaises(TypeError, sys._setgilscheduling)
+        self.assertRaises(ValueError, sys._setgilscheduling, "lifo")
+        orig = sys._getgilscheduling()
+        self.assertIn(orig, ("default", "priority"))
+        try:
+            for policy in "priority", "default":
+                sys._setgilscheduling(policy)
+                self.assertEqual(sys._getgilscheduling(), policy)
+        finally:
+            sys._setgilscheduling(orig)
+
+    @test.support.reap_threads
+    def test_gilscheduling_priority(self):
+        orig = sys._getgilscheduling()
+        sys._setgilscheduling("priority")
+        try:
+            stop = False
+            counts = [0] * 4
+            def spin(i):
+                while not stop:
+                    counts[i] += 1
+            def sleep(i):
+                while not stop:
+                    time.sleep(0.0001)
+                    counts[i] += 1
+            threads = [threading.Thread(target=spin, args=(0,)),
+                       threading.Thread(target=spin, args=(1,)),
+                       threading.Thread(target=sleep, args=(2,)),
+                       threading.Thread(target=sleep, args=(3,))]
+            with test.support.start_threads(threads):
+                time.sleep(0.5)
+                stop = True
+            # No thread was starved
+            self.assertTrue(all(counts), counts)
+        finally:
+            sys._setgilscheduling(orig)
+
+    @test.support.reap_threads
+    def test_gilwaitstats(self):
+        ident = threading.get_ident()
+        stats = sys._getgilwaitstats()
+        self.assertIn(ident, stats)
+        count, total, longest = stats[ident]
+        self.assertGreaterEqual(count, 0)
+        self.assertGreaterEqual(total, longest)
+        self.assertGreaterEqual(longest, 0.0)
+
+        def spin(deadline):
+            while time.monotonic() < deadline:
+                pass
+        thread = threading.Thread(target=spin,
+                                  args=(time.monotonic() + 0.1,))
+        with test.support.start_threads([thread]):
+            spin(time.monotonic() + 0.1)
+        new_count, new_total, new_longest = sys._getgilwaitstats()[ident]
+        self.assertGreater(new_count, count)
+        self.assertGreater(new_total, total)
+
+    @test.support.reap_threads
+    def test_gilstats(self):
+        def spin(deadline):
+            while time.monotonic() < deadline:
+                pass
+        ident = threading.get_ident()
+        sys._setgilstats(True)
+        try:
+            sys._resetgilstats()
+            thread = threading.Thread(target=spin,
+                                      args=(time.monotonic() + 0.1,))
+            with test.support.start_threads([thread]):
+                spin(time.monotonic() + 0.1)
+            stats = sys._getgilstats()[ident]
+        finally:
+            sys._setgilstats(False)
+        self.assertEqual(set(stats), {'wait_histogram', 'hold_histogram',
+                                      'forced_switches', 'drop_requests'})
+        self.assertEqual(len(stats['wait_histogram']), 24)
+        self.assertEqual(len(stats['hold_histogram']), 24)
+        self.assertGreater(stats['forced_switches'], 0)
+        self.assertGreater(stats['drop_requests'], 0)
+        self.assertGreater(sum(stats['wait_histogram']), 0)
+        self.assertGreater(sum(stats['hold_histogram']), 0)
+        # Switching every 5 ms, the GIL is mostly held for at least 1 ms
+        self.assertGreater(sum(stats['hold_histogram'][11:]), 0)
+
+        # Nothing is collected while disabled
+        sys._resetgilstats()
+        time.sleep(0.001)
+        stats = sys._getgilstats()[ident]
+        self.assertEqual(sum(stats['wait_histogram']), 0)
+        self.assertEqual(sum(stats['hold_histogram']), 0)
+
     def test_recursionlimit(self):
         self.assertRaises(TypeError, sys.getrecursionlimit, 42)
         oldlimit = sys.getrecursionlimit()
@@ -754,6 +849,115 @@ class SysModuleTest(unittest.TestCase):
         # The function has no parameter
         self.assertRaises(TypeError, sys._debugmallocstats, True)
 
+    @unittest.skipUnless(test.support.with_pymalloc(), 'need pymalloc')
+    def test_arenas_xoption(self):
+        code = 'import sys; x = [[i] for i in range(10**5)]; sys._debugmallocstats()'
+        ret, out, err = assert_python_ok('-X', 'arenasize=1M', '-c', code,
+                                         PYTHONMALLOC='pymalloc')
+        self.assertIn(b' * 1048576 bytes/arena', err)
+        # Arenas which are not a power of two in size
+        code2 = textwrap.dedent('''
+            x = [str(i) * (i % 50) for i in range(10**5)]
+            del x[::3]
+            y = [bytes(1000) for i in range(1000)]
+            assert len(''.join(x)) == 7985307
+        ''')
+        for size in ('12k', '20k', '3M'):
+            assert_python_ok('-X', 'arenasize=' + size, '-c', code2,
+                             PYTHONMALLOC='pymalloc')
+        if sys.platform != 'win32':
+            ret, out, err = assert_python_ok('-X', 'hugepages', '-c', code,
+                                             PYTHONMALLOC='pymalloc')
+            self.assertIn(b' * 2097152 bytes/arena', err)
+            self.assertRegex(err, br'# arena mappings +=  +1\n')
+        for size in ('0', '1000', '2G', 'x', ''):
+            assert_python_failure('-X', 'arenasize=' + size, '-c', 'pass')
+
+    @unittest.skipUnless(test.support.with_pymalloc(), 'need pymalloc')
+    def test_malloctrim(self):
+        code = textwrap.dedent('''
+            import sys
+            x = [[i] for i in range(10**5)]
+            keep = x[::1000]
+            del x
+            print(sys._malloctrim() > 0, sys._malloctrim(lazy=True))
+            x = [[i] for i in range(10**5)]
+            assert [l[0] for l in keep] == list(range(0, 10**5, 1000))
+            sys._debugmallocstats()
+        ''')
+        ret, out, err = assert_python_ok('-c', code, PYTHONMALLOC='pymalloc')
+        if sys.platform != 'win32':
+            self.assertEqual(out.rstrip(), b'True 0')
+            self.assertRegex(err, br'# times arenas trimmed +=  +2\n')
+        self.assertIsInstance(sys._malloctrim(), int)
+
+    @unittest.skipUnless(test.support.with_pymalloc(), 'need pymalloc')
+    @unittest.skipIf(sys.platform == 'win32', 'needs madvise()')
+    def test_malloctrim_reuse(self):
+        # The trimmed pools of a large arena are all found again, also
+        # after pools below the ones already reused were trimmed.
+        code = textwrap.dedent('''
+            import sys
+            x = [[i] for i in range(10**5)]
+            keep = x[::100]
+            del x
+            sys._malloctrim()
+            x = [[i] for i in range(10**5)]
+            del x
+            sys._malloctrim()
+            y = [[i] for i in range(10**5)]
+            assert [l[0] for l in keep] == list(range(0, 10**5, 100))
+            assert [l[0] for l in y] == list(range(10**5))
+            sys._debugmallocstats()
+        ''')
+        ret, out, err = assert_python_ok('-X', 'arenasize=4M', '-c', code,
+                                         PYTHONMALLOC='pymalloc')
+        reused = re.search(br'# trimmed pools reused += +([\d,]+)\n', err)
+        self.assertGreater(int(reused.group(1).replace(b',', b'')), 0)
+
+    def test_opcodeprofile(self):
+        import dis
+        def f(n):
+            total = 0
+            for i in range(n):
+                total += i
+            return total
+        sys._resetopcodeprofile()
+        sys._setopcodeprofile(True, per_code=True)
+        try:
+            f(10)
+        finally:
+            sys._setopcodeprofile(False)
+        profile = sys._getopcodeprofile()
+        self.assertEqual(len(profile), 257)
+        self.assertTrue(all(len(counts) == 256 for counts in profile))
+        FOR_ITER = dis.opmap['FOR_ITER']
+        STORE_FAST = dis.opmap['STORE_FAST']
+        self.assertGreaterEqual(profile[256][FOR_ITER], 11)
+        self.assertGreaterEqual(profile[FOR_ITER][STORE_FAST], 10)
+
+        counts = sys._getopcodeprofile(f.__code__)
+        self.assertEqual(counts[FOR_ITER], 11)
+        self.assertEqual(counts[dis.opmap['INPLACE_ADD']], 10)
+
+        # Nothing is counted while the profiler is disabled
+        f(10)
+        self.assertEqual(sys._getopcodeprofile(f.__code__), counts)
+
+        sys._resetopcodeprofile()
+        self.assertEqual(sum(sys._getopcodeprofile()[256]), 0)
+        self.assertEqual(sum(sys._getopcodeprofile(f.__code__)), 0)
+        self.assertRaises(TypeError, sys._getopcodeprofile, f)
+
+    def test_opcodeprofile_xoption(self):
+        code = 'import sys; print(sum(sys._getopcodeprofile()[256]) > 0)'
+        rc, out, err = assert_python_ok('-X', 'opcodeprofile', '-c', code)
+        self.assertEqual(out.rstrip(), b'True')
+        rc, out, err = assert_python_ok('-c', code)
+        self.assertEqual(out.rstrip(), b'False')
+        assert_python_ok('-X', 'opcodeprofile=code', '-c', code)
+        assert_python_failure('-X', 'opcodeprofile=xyz', '-c', code)
+
     @unittest.skipUnless(hasattr(sys, "getallocatedblocks"),
                          "sys.getallocatedblocks unavailable on this build")
     def test_getallocatedblocks(self):
@@ -790,6 +994,29 @@ class SysModuleTest(unittest.TestCase):
         c = sys.getallocatedblocks()
         self.assertIn(c, range(b - 50, b + 50))
 
+    def test_malloccache(self):
+        old = sys._getmalloccache()
+        self.assertIsInstance(old, bool)
+        try:
+            sys._setmalloccache(True)
+            self.assertIs(sys._getmalloccache(), True)
+            def f():
+                for i in range(1000):
+                    [float(j) for j in range(100)]
+            # Fill the float free list and the opcode caches first
+            f()
+            a = sys.getallocatedblocks()
+            f()
+            # Cached blocks are free blocks
+            self.assertIn(sys.getallocatedblocks(), range(a - 50, a + 50))
+            sys._setmalloccache(False)
+            self.assertIs(sys._getmalloccache(), False)
+            self.assertIn(sys.getallocatedblocks(), range(a - 50, a + 50))
+            f()
+        finally:
+            sys._setmalloccache(old)
+        self.assertRaises(TypeError, sys._setmalloccache)
+
     @test.support.requires_type_collecting
     def test_is_finalizing(self):
         self.assertIs(sys.is_finalizing(), False)
@@ -941,13 +1168,13 @@ class SizeofTest(unittest.TestCase):
         # code
         def check_code_size(a, expected_size):
             self.assertGreaterEqual(sys.getsizeof(a), expected_size)
-        check_code_size(get_cell().__code__, size('6i13P'))
-        check_code_size(get_cell.__code__, size('6i13P'))
+        check_code_size(get_cell().__code__, size('6i15PicP'))
+        check_code_size(get_cell.__code__, size('6i15PicP'))
         def get_cell2(x):
             def inner():
                 return x
             return inner
-        check_code_size(get_cell2.__code__, size('6i13P') + calcsize('n'))
+        check_code_size(get_cell2.__code__, size('6i15PicP') + calcsize('n'))
         # complex
         check(complex(0,1), size('2d'))
         # method_descriptor (descriptor object)
@@ -1015,7 +1242,7 @@ class SizeofTest(unittest.TestCase):
         nfrees = len(x.f_code.co_freevars)
         extras = x.f_code.co_stacksize + x.f_code.co_nlocals +\
                   ncells + nfrees - 1
-        check(x, vsize('5P2c4P3ic' + CO_MAXBLOCKS*'3i' + 'P' + extras*'P'))
+        check(x, vsize('5P2c4P3i2c2P' + CO_MAXBLOCKS*'3i' + 'P' + extras*'P'))
         # function
         def func(): pass
         check(func, size('12P'))
@@ -1113,7 +1340,7 @@ class SizeofTest(unittest.TestCase):
         check((1,2,3), vsize('') + 3*self.P)
         # type
         # static type: PyTypeObject
-        fmt = 'P2n15Pl4Pn9Pn11PIP'
+        fmt = 'P2n15Pl4Pn9Pn11PIPnP'
         if hasattr(sys, 'getcounts'):
             fmt += '3n2P'
         s = vsize(fmt)
@@ -1125,7 +1352,7 @@ class SizeofTest(unittest.TestCase):
                   '3P'                  # PyMappingMethods
                   '10P'                 # PySequenceMethods
                   '2P'                  # PyBufferProcs
-                  '4P')
+                  '7P')
         class newstyleclass(object): pass
         # Separate block for PyDictKeysObject with 8 keys and 5 entries
         check(newstyleclass, s + calcsize("2nP2n0P") + 8 + 5*calcsize("n2P"))
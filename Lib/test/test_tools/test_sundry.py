@@ -9,6 +9,7 @@ import os
 import sys
 import unittest
 from test import support
+from test.support.script_helper import assert_python_ok
 
 from test.test_tools import scriptsdir, import_tool, skip_if_missing
 
@@ -41,12 +42,28 @@ class TestSundryScripts(unittest.TestCase):
             import_tool(name)
 
     def test_analyze_dxp_import(self):
-        if hasattr(sys, 'getdxp'):
+        if hasattr(sys, 'getdxp') or hasattr(sys, '_getopcodeprofile'):
             import_tool('analyze_dxp')
         else:
             with self.assertRaises(RuntimeError):
                 import_tool('analyze_dxp')
 
+    @unittest.skipIf(hasattr(sys, 'getdxp') or
+                     not hasattr(sys, '_getopcodeprofile'),
+                     'requires the opcode profiler')
+    def test_analyze_dxp_profiler_disabled(self):
+        # Importing analyze_dxp doesn't enable the opcode profiler
+        code = ('import sys; sys.path.insert(0, %r); import analyze_dxp; '
+                'sum(range(10)); '
+                'print(sum(sys._getopcodeprofile()[-1]))' % scriptsdir)
+        rc, out, err = assert_python_ok('-c', code)
+        self.assertEqual(out.strip(), b'0')
+
+        code += ('; analyze_dxp.enable_profile(); sum(range(10)); '
+                 'print(sum(analyze_dxp.snapshot_profile()[-1]) > 0)')
+        rc, out, err = assert_python_ok('-c', code)
+        self.assertEqual(out.split(), [b'0', b'True'])
+
 
 if __name__ == '__main__':
     unittest.main()
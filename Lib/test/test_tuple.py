@@ -162,6 +162,30 @@ class TupleTest(seq_tests.CommonTest):
             pass
         self.check_track_dynamic(MyTuple, True)
 
+    @support.cpython_only
+    def test_track_at_creation(self):
+        # Tuples of atomic objects built by Python code are untracked
+        # without waiting for a collection.
+        x, y, z = 1.5, "a", []
+        t = (x, y, 1)
+        self.assertFalse(gc.is_tracked(t))
+        self.assertFalse(gc.is_tracked((t, frozenset([x]))))
+        self.assertFalse(gc.is_tracked(tuple([x, y])))
+        self.assertFalse(gc.is_tracked(tuple(iter([x, y]))))
+        self.assertFalse(gc.is_tracked(t[1:]))
+        self.assertFalse(gc.is_tracked(t[::2]))
+        self.assertFalse(gc.is_tracked(t + t))
+        self.assertFalse(gc.is_tracked(t * 2))
+
+        u = (x, y, z)
+        self.assertTrue(gc.is_tracked(u))
+        self.assertTrue(gc.is_tracked((t, u)))
+        self.assertTrue(gc.is_tracked(tuple([x, z])))
+        self.assertTrue(gc.is_tracked(u[1:]))
+        self.assertTrue(gc.is_tracked(u[::2]))
+        self.assertTrue(gc.is_tracked(t + u))
+        self.assertTrue(gc.is_tracked(u * 2))
+
     @support.cpython_only
     def test_bug7466(self):
         # Trying to untrack an unfinished tuple could crash Python
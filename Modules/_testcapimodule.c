@@ -12,6 +12,7 @@
 #include "structmember.h"
 #include "datetime.h"
 #include "marshal.h"
+#include "frameobject.h"
 #include <signal.h>
 
 #ifdef MS_WINDOWS
@@ -3111,7 +3112,7 @@ slot_tp_del(PyObject *self)
         self->ob_refcnt = refcnt;
     }
     assert(!PyType_IS_GC(Py_TYPE(self)) ||
-           _Py_AS_GC(self)->gc.gc_refs != _PyGC_REFS_UNTRACKED);
+           _PyObject_GC_IS_TRACKED(self));
     /* If Py_REF_DEBUG, _Py_NewReference bumped _Py_RefTotal, so
      * we need to undo that. */
     _Py_DEC_REFTOTAL;
@@ -4350,6 +4351,32 @@ stack_pointer(PyObject *self, PyObject *args)
 }
 
 
+/* Call func while a frame created by PyFrame_New() for code is the current
+   frame, as the profiling hooks of some extension modules do. */
+static PyObject *
+call_in_new_frame(PyObject *self, PyObject *args)
+{
+    PyThreadState *tstate = PyThreadState_GET();
+    PyObject *code, *func, *result;
+    PyFrameObject *back = tstate->frame, *frame;
+
+    if (!PyArg_ParseTuple(args, "O!O:call_in_new_frame",
+                          &PyCode_Type, &code, &func)) {
+        return NULL;
+    }
+    frame = PyFrame_New(tstate, (PyCodeObject *)code, PyEval_GetGlobals(),
+                        NULL);
+    if (frame == NULL) {
+        return NULL;
+    }
+    tstate->frame = frame;
+    result = _PyObject_CallNoArg(func);
+    tstate->frame = back;
+    Py_DECREF(frame);
+    return result;
+}
+
+
 #ifdef W_STOPCODE
 static PyObject*
 py_w_stopcode(PyObject *self, PyObject *args)
@@ -4648,6 +4675,7 @@ static PyMethodDef TestMethods[] = {
     {"pyobject_fastcalldict", test_pyobject_fastcalldict, METH_VARARGS},
     {"pyobject_fastcallkeywords", test_pyobject_fastcallkeywords, METH_VARARGS},
     {"stack_pointer", stack_pointer, METH_NOARGS},
+    {"call_in_new_frame", call_in_new_frame, METH_VARARGS},
 #ifdef W_STOPCODE
     {"W_STOPCODE", py_w_stopcode, METH_VARARGS},
 #endif
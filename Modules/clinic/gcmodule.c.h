@@ -191,6 +191,125 @@ gc_get_threshold(PyObject *module, PyObject *Py_UNUSED(ignored))
     return gc_get_threshold_impl(module);
 }
 
+PyDoc_STRVAR(gc_set_incremental__doc__,
+"set_incremental($module, budget, /)\n"
+"--\n"
+"\n"
+"Enable or disable incremental collection of the oldest generation.\n"
+"\n"
+"A positive budget enables it: automatic collections of the oldest\n"
+"generation are then split into slices which try to pause the program\n"
+"for at most budget seconds.  Zero disables it.");
+
+#define GC_SET_INCREMENTAL_METHODDEF    \
+    {"set_incremental", (PyCFunction)gc_set_incremental, METH_O, gc_set_incremental__doc__},
+
+static PyObject *
+gc_set_incremental_impl(PyObject *module, double budget);
+
+static PyObject *
+gc_set_incremental(PyObject *module, PyObject *arg)
+{
+    PyObject *return_value = NULL;
+    double budget;
+
+    if (!PyArg_Parse(arg, "d:set_incremental", &budget)) {
+        goto exit;
+    }
+    return_value = gc_set_incremental_impl(module, budget);
+
+exit:
+    return return_value;
+}
+
+PyDoc_STRVAR(gc_get_incremental__doc__,
+"get_incremental($module, /)\n"
+"--\n"
+"\n"
+"Return the pause budget of incremental collections, or 0.0 if disabled.");
+
+#define GC_GET_INCREMENTAL_METHODDEF    \
+    {"get_incremental", (PyCFunction)gc_get_incremental, METH_NOARGS, gc_get_incremental__doc__},
+
+static double
+gc_get_incremental_impl(PyObject *module);
+
+static PyObject *
+gc_get_incremental(PyObject *module, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *return_value = NULL;
+    double _return_value;
+
+    _return_value = gc_get_incremental_impl(module);
+    if ((_return_value == -1.0) && PyErr_Occurred()) {
+        goto exit;
+    }
+    return_value = PyFloat_FromDouble(_return_value);
+
+exit:
+    return return_value;
+}
+
+PyDoc_STRVAR(gc_set_adaptive_threshold__doc__,
+"set_adaptive_threshold($module, maximum, /)\n"
+"--\n"
+"\n"
+"Enable or disable the adaptive threshold of the youngest generation.\n"
+"\n"
+"A positive maximum enables it: the threshold of generation 0 then grows\n"
+"up to maximum while collections find little garbage, and shrinks back to\n"
+"the threshold set with set_threshold() when they find much.  Zero\n"
+"disables it.");
+
+#define GC_SET_ADAPTIVE_THRESHOLD_METHODDEF    \
+    {"set_adaptive_threshold", (PyCFunction)gc_set_adaptive_threshold, METH_O, gc_set_adaptive_threshold__doc__},
+
+static PyObject *
+gc_set_adaptive_threshold_impl(PyObject *module, int maximum);
+
+static PyObject *
+gc_set_adaptive_threshold(PyObject *module, PyObject *arg)
+{
+    PyObject *return_value = NULL;
+    int maximum;
+
+    if (!PyArg_Parse(arg, "i:set_adaptive_threshold", &maximum)) {
+        goto exit;
+    }
+    return_value = gc_set_adaptive_threshold_impl(module, maximum);
+
+exit:
+    return return_value;
+}
+
+PyDoc_STRVAR(gc_get_adaptive_threshold__doc__,
+"get_adaptive_threshold($module, /)\n"
+"--\n"
+"\n"
+"Return the maximum adaptive threshold of generation 0, or 0 if disabled.");
+
+#define GC_GET_ADAPTIVE_THRESHOLD_METHODDEF    \
+    {"get_adaptive_threshold", (PyCFunction)gc_get_adaptive_threshold, METH_NOARGS, gc_get_adaptive_threshold__doc__},
+
+static int
+gc_get_adaptive_threshold_impl(PyObject *module);
+
+static PyObject *
+gc_get_adaptive_threshold(PyObject *module, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *return_value = NULL;
+    int _return_value;
+
+    _return_value = gc_get_adaptive_threshold_impl(module);
+    if ((_return_value == -1) && PyErr_Occurred()) {
+        goto exit;
+    }
+    return_value = PyLong_FromLong((long)_return_value);
+
+exit:
+    return return_value;
+}
+
 PyDoc_STRVAR(gc_get_count__doc__,
 "get_count($module, /)\n"
 "--\n"
@@ -325,4 +444,35 @@ gc_get_freeze_count(PyObject *module, PyObject *Py_UNUSED(ignored))
 exit:
     return return_value;
 }
-/*[clinic end generated code: output=6f9ee4d8dd1f36c1 input=a9049054013a1b77]*/
+
+PyDoc_STRVAR(gc_get_untracked_count__doc__,
+"get_untracked_count($module, /)\n"
+"--\n"
+"\n"
+"Return the number of tuples and frozensets untracked when created.\n"
+"\n"
+"These only contained atomic objects, and were never examined by the\n"
+"collector.");
+
+#define GC_GET_UNTRACKED_COUNT_METHODDEF    \
+    {"get_untracked_count", (PyCFunction)gc_get_untracked_count, METH_NOARGS, gc_get_untracked_count__doc__},
+
+static Py_ssize_t
+gc_get_untracked_count_impl(PyObject *module);
+
+static PyObject *
+gc_get_untracked_count(PyObject *module, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *return_value = NULL;
+    Py_ssize_t _return_value;
+
+    _return_value = gc_get_untracked_count_impl(module);
+    if ((_return_value == -1) && PyErr_Occurred()) {
+        goto exit;
+    }
+    return_value = PyLong_FromSsize_t(_return_value);
+
+exit:
+    return return_value;
+}
+/*[clinic end generated code: output=1b68428b926314ee input=a9049054013a1b77]*/
@@ -55,111 +55,213 @@ static PyObject *gc_str = NULL;
 
 #define GEN_HEAD(n) (&_PyRuntime.gc.generations[n].head)
 
+/* Number of objects examined by the first slices of an incremental
+   collection, and lower bound once it adapts to the pause budget */
+#define GC_INITIAL_INCREMENT    10000
+#define GC_MIN_INCREMENT        1000
+
+/* In adaptive threshold mode, the threshold of generation 0 doubles when
+   less than 1/GC_ADAPTIVE_GROW_YIELD of the objects examined by a young
+   collection are garbage, and halves when more than
+   1/GC_ADAPTIVE_SHRINK_YIELD of them are */
+#define GC_ADAPTIVE_GROW_YIELD      100
+#define GC_ADAPTIVE_SHRINK_YIELD    10
+
+/* Spaces of the objects outside of collections, see build_increment() */
+#define GC_SPACE_PENDING        0
+#define GC_OLD_SPACE_0          1
+#define GC_OLD_SPACE_1          2
+#define GC_FROZEN               3
+
 void
 _PyGC_Initialize(struct _gc_runtime_state *state)
 {
     state->enabled = 1; /* automatic collection enabled? */
 
-#define _GEN_HEAD(n) (&state->generations[n].head)
+#define _GEN_HEAD(n) ((uintptr_t)&state->generations[n].head)
     struct gc_generation generations[NUM_GENERATIONS] = {
-        /* PyGC_Head,                                 threshold,      count */
-        {{{_GEN_HEAD(0), _GEN_HEAD(0), 0}},           700,            0},
-        {{{_GEN_HEAD(1), _GEN_HEAD(1), 0}},           10,             0},
-        {{{_GEN_HEAD(2), _GEN_HEAD(2), 0}},           10,             0},
+        /* PyGC_Head,                             threshold,      count */
+        {{_GEN_HEAD(0), _GEN_HEAD(0)},            700,            0},
+        {{_GEN_HEAD(1), _GEN_HEAD(1)},            10,             0},
+        {{_GEN_HEAD(2), _GEN_HEAD(2)},            10,             0},
     };
     for (int i = 0; i < NUM_GENERATIONS; i++) {
         state->generations[i] = generations[i];
     };
     state->generation0 = GEN_HEAD(0);
+    state->base_threshold = state->generations[0].threshold;
     struct gc_generation permanent_generation = {
-          {{&state->permanent_generation.head, &state->permanent_generation.head, 0}}, 0, 0
+          {(uintptr_t)&state->permanent_generation.head,
+           (uintptr_t)&state->permanent_generation.head}, 0, 0
     };
     state->permanent_generation = permanent_generation;
+    state->old_visited._gc_next = (uintptr_t)&state->old_visited;
+    state->old_visited._gc_prev = (uintptr_t)&state->old_visited;
+    state->visited_space = GC_OLD_SPACE_0;
+    state->increment_size = GC_INITIAL_INCREMENT;
 }
 
 /*--------------------------------------------------------------------------
-gc_refs values.
+The GC header.
+
+A tracked object is in a doubly linked list: _gc_next and _gc_prev point to
+the GC headers of its neighbours.  The headers are aligned, which leaves the
+two lowest bits of each word free for flags:
+
+_gc_prev bit 0: _PyGC_PREV_MASK_FINALIZED
+    Set when tp_finalize was called on the object.
+
+_gc_prev bit 1: PREV_MASK_COLLECTING
+    Set by update_refs() for all objects of the generation being collected.
+    subtract_refs() and move_unreachable() use it to tell whether an object
+    is part of the collection.  move_unreachable() clears it on reachable
+    objects, so that only the unreachable objects have it afterwards, until
+    they are either deleted or check_garbage() finds they were resurrected.
+    No object has this flag outside of collections.
 
-Between collections, every gc'ed object has one of two gc_refs values:
+_gc_next bits 0-1: the space of the object
+    Outside of collections, incremental collections of the oldest
+    generation mark objects with:
 
-GC_UNTRACKED
-    The initial state; objects returned by PyObject_GC_Malloc are in this
-    state.  The object doesn't live in any generation list, and its
-    tp_traverse slot must not be called.
+    GC_SPACE_PENDING
+        The default.  The object may be added to the next increment.
 
-GC_REACHABLE
-    The object lives in some generation list, and its tp_traverse is safe to
-    call.  An object transitions to GC_REACHABLE when PyObject_GC_Track
-    is called.
+    GC_OLD_SPACE_0, GC_OLD_SPACE_1
+        The object was examined by a slice of the current incremental pass
+        if its space is _PyRuntime.gc.visited_space, and is pending again
+        otherwise.
 
-During a collection, gc_refs can temporarily take on other states:
+    GC_FROZEN
+        The object lives in the permanent generation (see gc.freeze()) and
+        must not be added to an increment.
+
+    update_refs() resets the space of the objects being collected.
+
+_gc_next bit 0: NEXT_MASK_UNREACHABLE
+    During a collection, set by move_unreachable() on the objects it moves
+    to the unreachable list, which is then singly linked.
+    move_legacy_finalizers() clears it.
+
+During a collection, the pointer bits of _gc_prev hold gc_refs instead:
 
->= 0
     At the start of a collection, update_refs() copies the true refcount
     to gc_refs, for each object in the generation being collected.
     subtract_refs() then adjusts gc_refs so that it equals the number of
     times an object is referenced directly from outside the generation
-    being collected.
-    gc_refs remains >= 0 throughout these steps.
-
-GC_TENTATIVELY_UNREACHABLE
-    move_unreachable() then moves objects not reachable (whether directly or
-    indirectly) from outside the generation into an "unreachable" set.
-    Objects that are found to be reachable have gc_refs set to GC_REACHABLE
-    again.  Objects that are found to be unreachable have gc_refs set to
-    GC_TENTATIVELY_UNREACHABLE.  It's "tentatively" because the pass doing
-    this can't be sure until it ends, and GC_TENTATIVELY_UNREACHABLE may
-    transition back to GC_REACHABLE.
-
-    Only objects with GC_TENTATIVELY_UNREACHABLE still set are candidates
-    for collection.  If it's decided not to collect such an object (e.g.,
-    it has a __del__ method), its gc_refs is restored to GC_REACHABLE again.
+    being collected.  move_unreachable() restores the _gc_prev pointers.
+    check_garbage() uses gc_refs again, and restores the pointers too.
 ----------------------------------------------------------------------------
 */
-#define GC_UNTRACKED                    _PyGC_REFS_UNTRACKED
-#define GC_REACHABLE                    _PyGC_REFS_REACHABLE
-#define GC_TENTATIVELY_UNREACHABLE      _PyGC_REFS_TENTATIVELY_UNREACHABLE
+#define GC_NEXT _PyGCHead_NEXT
+#define GC_PREV _PyGCHead_PREV
+
+#define PREV_MASK_COLLECTING   _PyGC_PREV_MASK_COLLECTING
+#define NEXT_MASK_UNREACHABLE  (1)
+
+#define IS_TRACKED(o) _PyObject_GC_IS_TRACKED(o)
+
+static inline int
+gc_is_collecting(PyGC_Head *g)
+{
+    return (g->_gc_prev & PREV_MASK_COLLECTING) != 0;
+}
+
+static inline void
+gc_clear_collecting(PyGC_Head *g)
+{
+    g->_gc_prev &= ~PREV_MASK_COLLECTING;
+}
+
+static inline Py_ssize_t
+gc_get_refs(PyGC_Head *g)
+{
+    return (Py_ssize_t)(g->_gc_prev >> _PyGC_PREV_SHIFT);
+}
+
+static inline void
+gc_set_refs(PyGC_Head *g, Py_ssize_t refs)
+{
+    g->_gc_prev = (g->_gc_prev & ~_PyGC_PREV_MASK)
+        | ((uintptr_t)(refs) << _PyGC_PREV_SHIFT);
+}
+
+/* Make `g` part of the collection, with gc_refs = refs */
+static inline void
+gc_reset_refs(PyGC_Head *g, Py_ssize_t refs)
+{
+    g->_gc_prev = (g->_gc_prev & _PyGC_PREV_MASK_FINALIZED)
+        | PREV_MASK_COLLECTING
+        | ((uintptr_t)(refs) << _PyGC_PREV_SHIFT);
+    g->_gc_next &= ~(uintptr_t)_PyGC_NEXT_MASK_FLAGS;
+}
+
+static inline void
+gc_decref(PyGC_Head *g)
+{
+    assert(gc_get_refs(g) > 0);
+    g->_gc_prev -= 1 << _PyGC_PREV_SHIFT;
+}
+
+static inline uintptr_t
+gc_get_space(PyGC_Head *g)
+{
+    return g->_gc_next & _PyGC_NEXT_MASK_FLAGS;
+}
 
-#define IS_TRACKED(o) (_PyGC_REFS(o) != GC_UNTRACKED)
-#define IS_REACHABLE(o) (_PyGC_REFS(o) == GC_REACHABLE)
-#define IS_TENTATIVELY_UNREACHABLE(o) ( \
-    _PyGC_REFS(o) == GC_TENTATIVELY_UNREACHABLE)
+/* True if `g` is tracked, not being collected and may be added to an
+   increment */
+static inline int
+gc_is_old_pending(PyGC_Head *g)
+{
+    uintptr_t space = gc_get_space(g);
+    return (g->_gc_next != 0 && !gc_is_collecting(g)
+            && (space == GC_SPACE_PENDING
+                || space == (uintptr_t)(GC_OLD_SPACE_0 + GC_OLD_SPACE_1
+                                        - _PyRuntime.gc.visited_space)));
+}
 
 /*** list functions ***/
 
 static void
 gc_list_init(PyGC_Head *list)
 {
-    list->gc.gc_prev = list;
-    list->gc.gc_next = list;
+    /* List heads have no flags: assign the pointers directly. */
+    list->_gc_prev = (uintptr_t)list;
+    list->_gc_next = (uintptr_t)list;
 }
 
 static int
 gc_list_is_empty(PyGC_Head *list)
 {
-    return (list->gc.gc_next == list);
+    return (list->_gc_next == (uintptr_t)list);
 }
 
-#if 0
-/* This became unused after gc_list_move() was introduced. */
 /* Append `node` to `list`. */
 static void
 gc_list_append(PyGC_Head *node, PyGC_Head *list)
 {
-    node->gc.gc_next = list;
-    node->gc.gc_prev = list->gc.gc_prev;
-    node->gc.gc_prev->gc.gc_next = node;
-    list->gc.gc_prev = node;
+    PyGC_Head *last = (PyGC_Head *)list->_gc_prev;
+
+    /* last <-> node */
+    _PyGCHead_SET_PREV(node, last);
+    _PyGCHead_SET_NEXT(last, node);
+
+    /* node <-> list */
+    _PyGCHead_SET_NEXT(node, list);
+    list->_gc_prev = (uintptr_t)node;
 }
-#endif
 
 /* Remove `node` from the gc list it's currently in. */
 static void
 gc_list_remove(PyGC_Head *node)
 {
-    node->gc.gc_prev->gc.gc_next = node->gc.gc_next;
-    node->gc.gc_next->gc.gc_prev = node->gc.gc_prev;
-    node->gc.gc_next = NULL; /* object is not currently tracked */
+    PyGC_Head *prev = GC_PREV(node);
+    PyGC_Head *next = GC_NEXT(node);
+
+    _PyGCHead_SET_NEXT(prev, next);
+    _PyGCHead_SET_PREV(next, prev);
+
+    node->_gc_next = 0; /* object is not currently tracked */
 }
 
 /* Move `node` from the gc list it's currently in (which is not explicitly
@@ -169,30 +271,37 @@ gc_list_remove(PyGC_Head *node)
 static void
 gc_list_move(PyGC_Head *node, PyGC_Head *list)
 {
-    PyGC_Head *new_prev;
-    PyGC_Head *current_prev = node->gc.gc_prev;
-    PyGC_Head *current_next = node->gc.gc_next;
     /* Unlink from current list. */
-    current_prev->gc.gc_next = current_next;
-    current_next->gc.gc_prev = current_prev;
+    PyGC_Head *from_prev = GC_PREV(node);
+    PyGC_Head *from_next = GC_NEXT(node);
+    _PyGCHead_SET_NEXT(from_prev, from_next);
+    _PyGCHead_SET_PREV(from_next, from_prev);
+
     /* Relink at end of new list. */
-    new_prev = node->gc.gc_prev = list->gc.gc_prev;
-    new_prev->gc.gc_next = list->gc.gc_prev = node;
-    node->gc.gc_next = list;
+    PyGC_Head *to_prev = (PyGC_Head *)list->_gc_prev;
+    _PyGCHead_SET_PREV(node, to_prev);
+    _PyGCHead_SET_NEXT(to_prev, node);
+    list->_gc_prev = (uintptr_t)node;
+    _PyGCHead_SET_NEXT(node, list);
 }
 
 /* append list `from` onto list `to`; `from` becomes an empty list */
 static void
 gc_list_merge(PyGC_Head *from, PyGC_Head *to)
 {
-    PyGC_Head *tail;
     assert(from != to);
     if (!gc_list_is_empty(from)) {
-        tail = to->gc.gc_prev;
-        tail->gc.gc_next = from->gc.gc_next;
-        tail->gc.gc_next->gc.gc_prev = tail;
-        to->gc.gc_prev = from->gc.gc_prev;
-        to->gc.gc_prev->gc.gc_next = to;
+        PyGC_Head *to_tail = GC_PREV(to);
+        PyGC_Head *from_head = GC_NEXT(from);
+        PyGC_Head *from_tail = GC_PREV(from);
+        assert(from_head != from);
+        assert(from_tail != from);
+
+        _PyGCHead_SET_NEXT(to_tail, from_head);
+        _PyGCHead_SET_PREV(from_head, to_tail);
+
+        _PyGCHead_SET_NEXT(from_tail, to);
+        _PyGCHead_SET_PREV(to, from_tail);
     }
     gc_list_init(from);
 }
@@ -202,12 +311,23 @@ gc_list_size(PyGC_Head *list)
 {
     PyGC_Head *gc;
     Py_ssize_t n = 0;
-    for (gc = list->gc.gc_next; gc != list; gc = gc->gc.gc_next) {
+    for (gc = GC_NEXT(list); gc != list; gc = GC_NEXT(gc)) {
         n++;
     }
     return n;
 }
 
+/* Set the space of all objects in a list */
+static void
+gc_list_set_space(PyGC_Head *list, uintptr_t space)
+{
+    PyGC_Head *gc;
+    for (gc = GC_NEXT(list); gc != list; gc = GC_NEXT(gc)) {
+        gc->_gc_next = (gc->_gc_next & ~(uintptr_t)_PyGC_NEXT_MASK_FLAGS)
+            | space;
+    }
+}
+
 /* Append objects in a GC list to a Python list.
  * Return 0 if all OK, < 0 if error (out of memory for list).
  */
@@ -215,7 +335,7 @@ static int
 append_objects(PyObject *py_list, PyGC_Head *gc_list)
 {
     PyGC_Head *gc;
-    for (gc = gc_list->gc.gc_next; gc != gc_list; gc = gc->gc.gc_next) {
+    for (gc = GC_NEXT(gc_list); gc != gc_list; gc = GC_NEXT(gc)) {
         PyObject *op = FROM_GC(gc);
         if (op != py_list) {
             if (PyList_Append(py_list, op)) {
@@ -226,20 +346,19 @@ append_objects(PyObject *py_list, PyGC_Head *gc_list)
     return 0;
 }
 
-/*** end of list stuff ***/
-
-
-/* Set all gc_refs = ob_refcnt.  After this, gc_refs is > 0 for all objects
- * in containers, and is GC_REACHABLE for all tracked gc objects not in
- * containers.
+/* Set all gc_refs = ob_refcnt and set PREV_MASK_COLLECTING.  After this,
+ * gc_refs is > 0 for all objects in containers.  The _gc_prev pointers of
+ * the objects are lost until move_unreachable() restores them.
+ * Return the number of objects in containers.
  */
-static void
+static Py_ssize_t
 update_refs(PyGC_Head *containers)
 {
-    PyGC_Head *gc = containers->gc.gc_next;
-    for (; gc != containers; gc = gc->gc.gc_next) {
-        assert(_PyGCHead_REFS(gc) == GC_REACHABLE);
-        _PyGCHead_SET_REFS(gc, Py_REFCNT(FROM_GC(gc)));
+    Py_ssize_t n = 0;
+    PyGC_Head *gc = GC_NEXT(containers);
+    for (; gc != containers; gc = GC_NEXT(gc)) {
+        n++;
+        gc_reset_refs(gc, Py_REFCNT(FROM_GC(gc)));
         /* Python's cyclic gc should never see an incoming refcount
          * of 0:  if something decref'ed to 0, it should have been
          * deallocated immediately at that time.
@@ -258,8 +377,9 @@ update_refs(PyGC_Head *containers)
          * so serious that maybe this should be a release-build
          * check instead of an assert?
          */
-        assert(_PyGCHead_REFS(gc) != 0);
+        assert(gc_get_refs(gc) != 0);
     }
+    return n;
 }
 
 /* A traversal callback for subtract_refs. */
@@ -271,26 +391,25 @@ visit_decref(PyObject *op, void *data)
         PyGC_Head *gc = AS_GC(op);
         /* We're only interested in gc_refs for objects in the
          * generation being collected, which can be recognized
-         * because only they have positive gc_refs.
+         * because only they have PREV_MASK_COLLECTING.
          */
-        assert(_PyGCHead_REFS(gc) != 0); /* else refcount was too small */
-        if (_PyGCHead_REFS(gc) > 0)
-            _PyGCHead_DECREF(gc);
+        if (gc_is_collecting(gc)) {
+            gc_decref(gc);
+        }
     }
     return 0;
 }
 
 /* Subtract internal references from gc_refs.  After this, gc_refs is >= 0
- * for all objects in containers, and is GC_REACHABLE for all tracked gc
- * objects not in containers.  The ones with gc_refs > 0 are directly
+ * for all objects in containers.  The ones with gc_refs > 0 are directly
  * reachable from outside containers, and so can't be collected.
  */
 static void
 subtract_refs(PyGC_Head *containers)
 {
     traverseproc traverse;
-    PyGC_Head *gc = containers->gc.gc_next;
-    for (; gc != containers; gc=gc->gc.gc_next) {
+    PyGC_Head *gc = GC_NEXT(containers);
+    for (; gc != containers; gc = GC_NEXT(gc)) {
         traverse = Py_TYPE(FROM_GC(gc))->tp_traverse;
         (void) traverse(FROM_GC(gc),
                        (visitproc)visit_decref,
@@ -302,71 +421,87 @@ subtract_refs(PyGC_Head *containers)
 static int
 visit_reachable(PyObject *op, PyGC_Head *reachable)
 {
-    if (PyObject_IS_GC(op)) {
-        PyGC_Head *gc = AS_GC(op);
-        const Py_ssize_t gc_refs = _PyGCHead_REFS(gc);
+    PyGC_Head *gc;
+    Py_ssize_t gc_refs;
 
-        if (gc_refs == 0) {
-            /* This is in move_unreachable's 'young' list, but
-             * the traversal hasn't yet gotten to it.  All
-             * we need to do is tell move_unreachable that it's
-             * reachable.
-             */
-            _PyGCHead_SET_REFS(gc, 1);
-        }
-        else if (gc_refs == GC_TENTATIVELY_UNREACHABLE) {
-            /* This had gc_refs = 0 when move_unreachable got
-             * to it, but turns out it's reachable after all.
-             * Move it back to move_unreachable's 'young' list,
-             * and move_unreachable will eventually get to it
-             * again.
-             */
-            gc_list_move(gc, reachable);
-            _PyGCHead_SET_REFS(gc, 1);
-        }
-        /* Else there's nothing to do.
-         * If gc_refs > 0, it must be in move_unreachable's 'young'
-         * list, and move_unreachable will eventually get to it.
-         * If gc_refs == GC_REACHABLE, it's either in some other
-         * generation so we don't care about it, or move_unreachable
-         * already dealt with it.
-         * If gc_refs == GC_UNTRACKED, it must be ignored.
+    if (!PyObject_IS_GC(op)) {
+        return 0;
+    }
+
+    gc = AS_GC(op);
+    /* Ignore untracked objects and objects in other generations. */
+    if (gc->_gc_next == 0 || !gc_is_collecting(gc)) {
+        return 0;
+    }
+
+    gc_refs = gc_get_refs(gc);
+    if (gc->_gc_next & NEXT_MASK_UNREACHABLE) {
+        /* This had gc_refs = 0 when move_unreachable got
+         * to it, but turns out it's reachable after all.
+         * Move it back to move_unreachable's 'young' list,
+         * and move_unreachable will eventually get to it
+         * again.
          */
-         else {
-            assert(gc_refs > 0
-                   || gc_refs == GC_REACHABLE
-                   || gc_refs == GC_UNTRACKED);
-         }
+        /* The unreachable list is singly linked by _gc_next, with
+         * NEXT_MASK_UNREACHABLE set: unlink gc by hand.
+         */
+        PyGC_Head *prev = GC_PREV(gc);
+        PyGC_Head *next = (PyGC_Head *)(gc->_gc_next & ~NEXT_MASK_UNREACHABLE);
+        assert(prev->_gc_next & NEXT_MASK_UNREACHABLE);
+        assert(next->_gc_next & NEXT_MASK_UNREACHABLE);
+        prev->_gc_next = gc->_gc_next;  /* copy NEXT_MASK_UNREACHABLE */
+        _PyGCHead_SET_PREV(next, prev);
+
+        gc->_gc_next = 0;
+        gc_list_append(gc, reachable);
+        gc_set_refs(gc, 1);
+    }
+    else if (gc_refs == 0) {
+        /* This is in move_unreachable's 'young' list, but
+         * the traversal hasn't yet gotten to it.  All
+         * we need to do is tell move_unreachable that it's
+         * reachable.
+         */
+        gc_set_refs(gc, 1);
+    }
+    /* Else there's nothing to do.
+     * If gc_refs > 0, it must be in move_unreachable's 'young'
+     * list, and move_unreachable will eventually get to it.
+     */
+    else {
+        assert(gc_refs > 0);
     }
     return 0;
 }
 
 /* Move the unreachable objects from young to unreachable.  After this,
- * all objects in young have gc_refs = GC_REACHABLE, and all objects in
- * unreachable have gc_refs = GC_TENTATIVELY_UNREACHABLE.  All tracked
- * gc objects not in young or unreachable still have gc_refs = GC_REACHABLE.
+ * all objects in young don't have PREV_MASK_COLLECTING flag and
+ * unreachable have the flag.
  * All objects in young after this are directly or indirectly reachable
  * from outside the original young; and all objects in unreachable are
  * not.
+ *
+ * This function restores the _gc_prev pointers of the objects in young.
+ * The unreachable list is singly linked by _gc_next, which has
+ * NEXT_MASK_UNREACHABLE set, until move_legacy_finalizers() runs.
  */
 static void
 move_unreachable(PyGC_Head *young, PyGC_Head *unreachable)
 {
-    PyGC_Head *gc = young->gc.gc_next;
+    /* previous elem in the young list, used to restore gc_prev */
+    PyGC_Head *prev = young;
+    PyGC_Head *gc = GC_NEXT(young);
 
-    /* Invariants:  all objects "to the left" of us in young have gc_refs
-     * = GC_REACHABLE, and are indeed reachable (directly or indirectly)
-     * from outside the young list as it was at entry.  All other objects
-     * from the original young "to the left" of us are in unreachable now,
-     * and have gc_refs = GC_TENTATIVELY_UNREACHABLE.  All objects to the
-     * left of us in 'young' now have been scanned, and no objects here
-     * or to the right have been scanned yet.
+    /* Invariants:  all objects "to the left" of us in young are reachable
+     * (directly or indirectly) from outside the young list as it was at
+     * entry.  All other objects from the original young "to the left" of
+     * us are in unreachable now, and have NEXT_MASK_UNREACHABLE.  All
+     * objects to the left of us in 'young' now have been scanned, and no
+     * objects here or to the right have been scanned yet.
      */
 
     while (gc != young) {
-        PyGC_Head *next;
-
-        if (_PyGCHead_REFS(gc)) {
+        if (gc_get_refs(gc)) {
             /* gc is definitely reachable from outside the
              * original 'young'.  Mark it as such, and traverse
              * its pointers to find any other objects that may
@@ -377,15 +512,18 @@ move_unreachable(PyGC_Head *young, PyGC_Head *unreachable)
              */
             PyObject *op = FROM_GC(gc);
             traverseproc traverse = Py_TYPE(op)->tp_traverse;
-            assert(_PyGCHead_REFS(gc) > 0);
-            _PyGCHead_SET_REFS(gc, GC_REACHABLE);
+            assert(gc_get_refs(gc) > 0);
+            /* NOTE: visit_reachable may change gc->_gc_next when
+             * young->_gc_prev == gc.  Don't do gc = GC_NEXT(gc) before!
+             */
             (void) traverse(op,
                             (visitproc)visit_reachable,
                             (void *)young);
-            next = gc->gc.gc_next;
-            if (PyTuple_CheckExact(op)) {
-                _PyTuple_MaybeUntrack(op);
-            }
+            /* relink gc_prev to prev element */
+            _PyGCHead_SET_PREV(gc, prev);
+            /* gc is not COLLECTING state after here */
+            gc_clear_collecting(gc);
+            prev = gc;
         }
         else {
             /* This *may* be unreachable.  To make progress,
@@ -395,22 +533,207 @@ move_unreachable(PyGC_Head *young, PyGC_Head *unreachable)
              * visit_reachable will eventually move gc back into
              * young if that's so, and we'll see it again.
              */
-            next = gc->gc.gc_next;
-            gc_list_move(gc, unreachable);
-            _PyGCHead_SET_REFS(gc, GC_TENTATIVELY_UNREACHABLE);
+            /* Move gc to unreachable.  No need to set gc->next->prev,
+             * young is singly linked until this function returns.
+             */
+            prev->_gc_next = gc->_gc_next;
+
+            /* gc_list_append() can't be used because of
+             * NEXT_MASK_UNREACHABLE.  Since all objects in unreachable
+             * have it, it's set unconditionally: this pollutes the next
+             * pointer of the list head too, which is repaired when this
+             * function ends.
+             */
+            PyGC_Head *last = GC_PREV(unreachable);
+            last->_gc_next = (NEXT_MASK_UNREACHABLE | (uintptr_t)gc);
+            _PyGCHead_SET_PREV(gc, last);
+            gc->_gc_next = (NEXT_MASK_UNREACHABLE | (uintptr_t)unreachable);
+            unreachable->_gc_prev = (uintptr_t)gc;
+        }
+        gc = (PyGC_Head *)prev->_gc_next;
+    }
+    /* young->_gc_prev must be last element remained in the list */
+    young->_gc_prev = (uintptr_t)prev;
+    /* don't let the pollution of the list head's next pointer leak */
+    unreachable->_gc_next &= ~NEXT_MASK_UNREACHABLE;
+}
+
+/* Try to untrack all currently tracked tuples.  This can't be done by
+ * move_unreachable() since the list is singly linked at that time.
+ */
+static void
+untrack_tuples(PyGC_Head *head)
+{
+    PyGC_Head *next, *gc = GC_NEXT(head);
+    while (gc != head) {
+        PyObject *op = FROM_GC(gc);
+        next = GC_NEXT(gc);
+        if (PyTuple_CheckExact(op)) {
+            _PyTuple_MaybeUntrack(op);
         }
         gc = next;
     }
 }
 
+struct increment {
+    PyGC_Head *head;        /* the objects of the increment */
+    PyGC_Head *carry;       /* pending referents left to the next slice */
+    Py_ssize_t size;        /* number of objects in head */
+    Py_ssize_t limit;       /* stop adding pending objects at this size */
+};
+
+/* Add a pending object of the oldest generation to an increment, with
+ * gc_refs = ob_refcnt as update_refs() does.
+ */
+static void
+increment_add(PyGC_Head *gc, struct increment *inc)
+{
+    gc_list_move(gc, inc->head);
+    gc_reset_refs(gc, Py_REFCNT(FROM_GC(gc)));
+    assert(gc_get_refs(gc) != 0);
+    inc->size++;
+}
+
+/* A traversal callback for build_increment. */
+static int
+visit_increment(PyObject *op, struct increment *inc)
+{
+    if (PyObject_IS_GC(op)) {
+        PyGC_Head *gc = AS_GC(op);
+        if (gc_is_old_pending(gc)) {
+            if (inc->size < inc->limit)
+                increment_add(gc, inc);
+            else
+                gc_list_move(gc, inc->carry);
+        }
+    }
+    return 0;
+}
+
+/* Build the set of objects examined by a slice of an incremental
+ * collection: the younger generations, then pending objects of the oldest
+ * generation and the pending objects they refer to, until there are
+ * _PyRuntime.gc.increment_size objects.  The pending objects referred to
+ * by the increment but left out of it are moved to the front of the
+ * oldest generation, to be examined by the next slice, and a pass may
+ * then end with a full collection (see collect_generations()).  All
+ * objects of the increment get gc_refs = ob_refcnt, and subtract_refs()
+ * can run next.
+ * Start a new pass first if all objects of the oldest generation were
+ * already examined; *new_pass is set to 1 in that case.
+ * Return the number of objects of the increment.
+ */
+static Py_ssize_t
+build_increment(PyGC_Head *increment, int *new_pass)
+{
+    PyGC_Head *pending = GEN_HEAD(NUM_GENERATIONS-1);
+    PyGC_Head carry;
+    PyGC_Head *gc;
+    struct increment inc;
+    int i, seeded = 0;
+
+    *new_pass = 0;
+    if (gc_list_is_empty(pending)) {
+        /* The visited objects are pending again.  Swapping the meaning of
+           the spaces avoids resetting them one by one. */
+        gc_list_merge(&_PyRuntime.gc.old_visited, pending);
+        _PyRuntime.gc.visited_space = (GC_OLD_SPACE_0 + GC_OLD_SPACE_1
+                                       - _PyRuntime.gc.visited_space);
+        *new_pass = 1;
+    }
+
+    for (i = 0; i < NUM_GENERATIONS-1; i++) {
+        gc_list_merge(GEN_HEAD(i), increment);
+    }
+    gc_list_init(&carry);
+    inc.head = increment;
+    inc.carry = &carry;
+    inc.size = update_refs(increment);
+    inc.limit = _PyRuntime.gc.increment_size;
+
+    gc = GC_NEXT(increment);
+    for (;;) {
+        /* Add what the objects of the increment refer to.  Note that
+         * the traversal may append objects to the increment.
+         */
+        for (; gc != increment; gc = GC_NEXT(gc)) {
+            traverseproc traverse = Py_TYPE(FROM_GC(gc))->tp_traverse;
+            (void) traverse(FROM_GC(gc),
+                            (visitproc)visit_increment,
+                            (void *)&inc);
+        }
+        /* Always take one pending object, to make progress even if the
+           younger generations fill the increment. */
+        if ((inc.size >= inc.limit && seeded) || gc_list_is_empty(pending))
+            break;
+        increment_add(GC_NEXT(pending), &inc);
+        seeded = 1;
+        gc = (PyGC_Head *)increment->_gc_prev;
+    }
+    if (!gc_list_is_empty(&carry)) {
+        gc_list_merge(pending, &carry);
+        gc_list_merge(&carry, pending);
+        _PyRuntime.gc.incremental_rescan = 1;
+    }
+    return inc.size;
+}
+
+/* Adapt the size of the next increments to the pause budget, knowing that
+ * examining `size` objects took `elapsed` time.  The estimate is at most
+ * twice `size`: the timing of a small slice, for example when there are
+ * few pending objects, says little about larger ones.
+ */
+static void
+update_increment_size(Py_ssize_t size, _PyTime_t elapsed)
+{
+    double seconds = _PyTime_AsSecondsDouble(elapsed);
+    double target = 2.0 * size;
+
+    if (seconds > 0.0
+        && size * _PyRuntime.gc.incremental_budget < target * seconds)
+        target = size * (_PyRuntime.gc.incremental_budget / seconds);
+    /* Average with the current size to smooth out noisy timings */
+    target = (target + _PyRuntime.gc.increment_size) / 2.0;
+    if (target < GC_MIN_INCREMENT)
+        target = GC_MIN_INCREMENT;
+    else if (target > PY_SSIZE_T_MAX / 2)
+        target = PY_SSIZE_T_MAX / 2;
+    _PyRuntime.gc.increment_size = (Py_ssize_t)target;
+}
+
+/* Adapt the threshold of generation 0 to the yield of a collection of the
+ * younger generations, which examined `scanned` objects and found `garbage`
+ * unreachable ones.  The threshold stays between the one set by the user
+ * and _PyRuntime.gc.adaptive_max.
+ */
+static void
+adapt_young_threshold(Py_ssize_t scanned, Py_ssize_t garbage)
+{
+    int base = _PyRuntime.gc.base_threshold;
+    int maximum = Py_MAX(_PyRuntime.gc.adaptive_max, base);
+    int threshold = _PyRuntime.gc.generations[0].threshold;
+
+    if (_PyRuntime.gc.adaptive_max == 0 || base == 0)
+        return;
+    if (garbage * GC_ADAPTIVE_GROW_YIELD < scanned) {
+        /* Mostly live objects: collect less often */
+        threshold = (threshold > maximum / 2) ? maximum : threshold * 2;
+    }
+    else if (garbage * GC_ADAPTIVE_SHRINK_YIELD > scanned) {
+        /* Much garbage: collect more often */
+        threshold = Py_MAX(threshold / 2, base);
+    }
+    _PyRuntime.gc.generations[0].threshold = threshold;
+}
+
 /* Try to untrack all currently tracked dictionaries */
 static void
 untrack_dicts(PyGC_Head *head)
 {
-    PyGC_Head *next, *gc = head->gc.gc_next;
+    PyGC_Head *next, *gc = GC_NEXT(head);
     while (gc != head) {
         PyObject *op = FROM_GC(gc);
-        next = gc->gc.gc_next;
+        next = GC_NEXT(gc);
         if (PyDict_CheckExact(op))
             _PyDict_MaybeUntrack(op);
         gc = next;
@@ -425,27 +748,29 @@ has_legacy_finalizer(PyObject *op)
 }
 
 /* Move the objects in unreachable with tp_del slots into `finalizers`.
- * Objects moved into `finalizers` have gc_refs set to GC_REACHABLE; the
- * objects remaining in unreachable are left at GC_TENTATIVELY_UNREACHABLE.
+ *
+ * This function also removes NEXT_MASK_UNREACHABLE flag
+ * from _gc_next in unreachable.
  */
 static void
 move_legacy_finalizers(PyGC_Head *unreachable, PyGC_Head *finalizers)
 {
-    PyGC_Head *gc;
-    PyGC_Head *next;
+    PyGC_Head *gc, *next;
+    unreachable->_gc_next &= ~NEXT_MASK_UNREACHABLE;
 
     /* March over unreachable.  Move objects with finalizers into
      * `finalizers`.
      */
-    for (gc = unreachable->gc.gc_next; gc != unreachable; gc = next) {
+    for (gc = GC_NEXT(unreachable); gc != unreachable; gc = next) {
         PyObject *op = FROM_GC(gc);
 
-        assert(IS_TENTATIVELY_UNREACHABLE(op));
-        next = gc->gc.gc_next;
+        assert(gc->_gc_next & NEXT_MASK_UNREACHABLE);
+        gc->_gc_next &= ~NEXT_MASK_UNREACHABLE;
+        next = (PyGC_Head*)gc->_gc_next;
 
         if (has_legacy_finalizer(op)) {
+            gc_clear_collecting(gc);
             gc_list_move(gc, finalizers);
-            _PyGCHead_SET_REFS(gc, GC_REACHABLE);
         }
     }
 }
@@ -455,10 +780,10 @@ static int
 visit_move(PyObject *op, PyGC_Head *tolist)
 {
     if (PyObject_IS_GC(op)) {
-        if (IS_TENTATIVELY_UNREACHABLE(op)) {
-            PyGC_Head *gc = AS_GC(op);
+        PyGC_Head *gc = AS_GC(op);
+        if (gc_is_collecting(gc)) {
             gc_list_move(gc, tolist);
-            _PyGCHead_SET_REFS(gc, GC_REACHABLE);
+            gc_clear_collecting(gc);
         }
     }
     return 0;
@@ -471,8 +796,8 @@ static void
 move_legacy_finalizer_reachable(PyGC_Head *finalizers)
 {
     traverseproc traverse;
-    PyGC_Head *gc = finalizers->gc.gc_next;
-    for (; gc != finalizers; gc = gc->gc.gc_next) {
+    PyGC_Head *gc = GC_NEXT(finalizers);
+    for (; gc != finalizers; gc = GC_NEXT(gc)) {
         /* Note that the finalizers list may grow during this. */
         traverse = Py_TYPE(FROM_GC(gc))->tp_traverse;
         (void) traverse(FROM_GC(gc),
@@ -487,10 +812,8 @@ move_legacy_finalizer_reachable(PyGC_Head *finalizers)
  * the weakrefs whose callbacks must be invoked.  See gc_weakref.txt for
  * overview & some details.  Some weakrefs with callbacks may be reclaimed
  * directly by this routine; the number reclaimed is the return value.  Other
- * weakrefs with callbacks may be moved into the `old` generation.  Objects
- * moved into `old` have gc_refs set to GC_REACHABLE; the objects remaining in
- * unreachable are left at GC_TENTATIVELY_UNREACHABLE.  When this returns,
- * no object in `unreachable` is weakly referenced anymore.
+ * weakrefs with callbacks may be moved into the `old` generation.  When this
+ * returns, no object in `unreachable` is weakly referenced anymore.
  */
 static int
 handle_weakrefs(PyGC_Head *unreachable, PyGC_Head *old)
@@ -512,12 +835,11 @@ handle_weakrefs(PyGC_Head *unreachable, PyGC_Head *old)
      * make another pass over wrcb_to_call, invoking callbacks, after this
      * pass completes.
      */
-    for (gc = unreachable->gc.gc_next; gc != unreachable; gc = next) {
+    for (gc = GC_NEXT(unreachable); gc != unreachable; gc = next) {
         PyWeakReference **wrlist;
 
         op = FROM_GC(gc);
-        assert(IS_TENTATIVELY_UNREACHABLE(op));
-        next = gc->gc.gc_next;
+        next = GC_NEXT(gc);
 
         if (! PyType_SUPPORTS_WEAKREFS(Py_TYPE(op)))
             continue;
@@ -571,9 +893,9 @@ handle_weakrefs(PyGC_Head *unreachable, PyGC_Head *old)
      * to imagine how calling it later could create a problem for us.  wr
      * is moved to wrcb_to_call in this case.
      */
-            if (IS_TENTATIVELY_UNREACHABLE(wr))
+            if (gc_is_collecting(AS_GC(wr))) {
                 continue;
-            assert(IS_REACHABLE(wr));
+            }
 
             /* Create a new reference so that wr can't go away
              * before we can process it again.
@@ -596,9 +918,8 @@ handle_weakrefs(PyGC_Head *unreachable, PyGC_Head *old)
         PyObject *temp;
         PyObject *callback;
 
-        gc = wrcb_to_call.gc.gc_next;
+        gc = GC_NEXT(&wrcb_to_call);
         op = FROM_GC(gc);
-        assert(IS_REACHABLE(op));
         assert(PyWeakref_Check(op));
         wr = (PyWeakReference *)op;
         callback = wr->wr_callback;
@@ -623,7 +944,7 @@ handle_weakrefs(PyGC_Head *unreachable, PyGC_Head *old)
          * ours).
          */
         Py_DECREF(op);
-        if (wrcb_to_call.gc.gc_next == gc) {
+        if (wrcb_to_call._gc_next == (uintptr_t)gc) {
             /* object is still alive -- move it */
             gc_list_move(gc, old);
         }
@@ -653,14 +974,14 @@ debug_cycle(const char *msg, PyObject *op)
 static int
 handle_legacy_finalizers(PyGC_Head *finalizers, PyGC_Head *old)
 {
-    PyGC_Head *gc = finalizers->gc.gc_next;
+    PyGC_Head *gc = GC_NEXT(finalizers);
 
     if (_PyRuntime.gc.garbage == NULL) {
         _PyRuntime.gc.garbage = PyList_New(0);
         if (_PyRuntime.gc.garbage == NULL)
             Py_FatalError("gc couldn't create gc.garbage list");
     }
-    for (; gc != finalizers; gc = gc->gc.gc_next) {
+    for (; gc != finalizers; gc = GC_NEXT(gc)) {
         PyObject *op = FROM_GC(gc);
 
         if ((_PyRuntime.gc.debug & DEBUG_SAVEALL) || has_legacy_finalizer(op)) {
@@ -694,7 +1015,7 @@ finalize_garbage(PyGC_Head *collectable)
     gc_list_init(&seen);
 
     while (!gc_list_is_empty(collectable)) {
-        PyGC_Head *gc = collectable->gc.gc_next;
+        PyGC_Head *gc = GC_NEXT(collectable);
         PyObject *op = FROM_GC(gc);
         gc_list_move(gc, &seen);
         if (!_PyGCHead_FINALIZED(gc) &&
@@ -715,30 +1036,26 @@ finalize_garbage(PyGC_Head *collectable)
 static int
 check_garbage(PyGC_Head *collectable)
 {
+    int ret = 0;
     PyGC_Head *gc;
-    for (gc = collectable->gc.gc_next; gc != collectable;
-         gc = gc->gc.gc_next) {
-        _PyGCHead_SET_REFS(gc, Py_REFCNT(FROM_GC(gc)));
-        assert(_PyGCHead_REFS(gc) != 0);
+    for (gc = GC_NEXT(collectable); gc != collectable; gc = GC_NEXT(gc)) {
+        /* Use gc_refs and break gc_prev again. */
+        gc_set_refs(gc, Py_REFCNT(FROM_GC(gc)));
+        assert(gc_get_refs(gc) != 0);
     }
     subtract_refs(collectable);
-    for (gc = collectable->gc.gc_next; gc != collectable;
-         gc = gc->gc.gc_next) {
-        assert(_PyGCHead_REFS(gc) >= 0);
-        if (_PyGCHead_REFS(gc) != 0)
-            return -1;
-    }
-    return 0;
-}
-
-static void
-revive_garbage(PyGC_Head *collectable)
-{
-    PyGC_Head *gc;
-    for (gc = collectable->gc.gc_next; gc != collectable;
-         gc = gc->gc.gc_next) {
-        _PyGCHead_SET_REFS(gc, GC_REACHABLE);
+    PyGC_Head *prev = collectable;
+    for (gc = GC_NEXT(collectable); gc != collectable; gc = GC_NEXT(gc)) {
+        assert(gc_get_refs(gc) >= 0);
+        if (gc_get_refs(gc) != 0) {
+            ret = -1;
+        }
+        /* Restore gc_prev here. */
+        _PyGCHead_SET_PREV(gc, prev);
+        gc_clear_collecting(gc);
+        prev = gc;
     }
+    return ret;
 }
 
 /* Break reference cycles by clearing the containers involved.  This is
@@ -751,7 +1068,7 @@ delete_garbage(PyGC_Head *collectable, PyGC_Head *old)
     inquiry clear;
 
     while (!gc_list_is_empty(collectable)) {
-        PyGC_Head *gc = collectable->gc.gc_next;
+        PyGC_Head *gc = GC_NEXT(collectable);
         PyObject *op = FROM_GC(gc);
 
         if (_PyRuntime.gc.debug & DEBUG_SAVEALL) {
@@ -764,10 +1081,9 @@ delete_garbage(PyGC_Head *collectable, PyGC_Head *old)
                 Py_DECREF(op);
             }
         }
-        if (collectable->gc.gc_next == gc) {
+        if (GC_NEXT(collectable) == gc) {
             /* object is still alive, move it, it may die later */
             gc_list_move(gc, old);
-            _PyGCHead_SET_REFS(gc, GC_REACHABLE);
         }
     }
 }
@@ -792,31 +1108,58 @@ clear_freelists(void)
     (void)PyAsyncGen_ClearFreeLists();
 }
 
+/* Record a collection pause in the pause time histogram */
+static void
+record_pause(_PyTime_t pause)
+{
+    _PyTime_t bound = 1000 * 1000;  /* 1 ms */
+    int i = 0;
+
+    while (i < NUM_PAUSE_BUCKETS - 1 && pause >= bound) {
+        i++;
+        bound *= 2;
+    }
+    _PyRuntime.gc.pause_histogram[i]++;
+}
+
 /* This is the main function.  Read this to understand how the
- * collection process works. */
+ * collection process works.
+ * If info is not NULL, it is filled with the statistics of this collection
+ * alone. */
 static Py_ssize_t
-collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
-        int nofail)
+collect(int generation, struct gc_generation_stats *info, int nofail,
+        int incremental)
 {
     int i;
     Py_ssize_t m = 0; /* # objects collected */
     Py_ssize_t n = 0; /* # unreachable objects that couldn't be collected */
+    Py_ssize_t scanned; /* # objects examined */
     PyGC_Head *young; /* the generation we are examining */
     PyGC_Head *old; /* next older generation */
     PyGC_Head unreachable; /* non-problematic unreachable trash */
     PyGC_Head finalizers;  /* objects with, & reachable from, __del__ */
+    PyGC_Head increment;   /* objects examined by an incremental slice */
     PyGC_Head *gc;
+    int new_pass = 0;
     _PyTime_t t1 = 0;   /* initialize to prevent a compiler warning */
+    _PyTime_t t0, t_phase, t_end;
+    struct gc_generation_stats current = {1, 0, 0, 0, 0, 0, 0, 0, 0};
 
     struct gc_generation_stats *stats = &_PyRuntime.gc.generation_stats[generation];
 
+    assert(!incremental || generation == NUM_GENERATIONS-1);
+    t0 = _PyTime_GetMonotonicClock();
+
     if (_PyRuntime.gc.debug & DEBUG_STATS) {
-        PySys_WriteStderr("gc: collecting generation %d...\n",
-                          generation);
+        PySys_WriteStderr("gc: collecting %sgeneration %d...\n",
+                          incremental ? "a slice of " : "", generation);
         PySys_WriteStderr("gc: objects in each generation:");
-        for (i = 0; i < NUM_GENERATIONS; i++)
-            PySys_FormatStderr(" %zd",
-                              gc_list_size(GEN_HEAD(i)));
+        for (i = 0; i < NUM_GENERATIONS; i++) {
+            Py_ssize_t size = gc_list_size(GEN_HEAD(i));
+            if (i == NUM_GENERATIONS-1)
+                size += gc_list_size(&_PyRuntime.gc.old_visited);
+            PySys_FormatStderr(" %zd", size);
+        }
         PySys_WriteStderr("\ngc: objects in permanent generation: %zd",
                          gc_list_size(&_PyRuntime.gc.permanent_generation.head));
         t1 = _PyTime_GetMonotonicClock();
@@ -833,24 +1176,47 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
     for (i = 0; i <= generation; i++)
         _PyRuntime.gc.generations[i].count = 0;
 
-    /* merge younger generations with one we are currently collecting */
-    for (i = 0; i < generation; i++) {
-        gc_list_merge(GEN_HEAD(i), GEN_HEAD(generation));
+    if (incremental) {
+        /* Examine the younger generations and a part of the oldest one.
+         * The survivors are moved to the visited list.
+         */
+        gc_list_init(&increment);
+        scanned = build_increment(&increment, &new_pass);
+        young = &increment;
+        old = &_PyRuntime.gc.old_visited;
     }
+    else {
+        /* merge younger generations with one we are currently collecting */
+        for (i = 0; i < generation; i++) {
+            gc_list_merge(GEN_HEAD(i), GEN_HEAD(generation));
+        }
+        /* a full collection also examines the objects already visited by
+         * the current incremental pass */
+        if (generation == NUM_GENERATIONS-1) {
+            gc_list_merge(&_PyRuntime.gc.old_visited, GEN_HEAD(generation));
+        }
 
-    /* handy references */
-    young = GEN_HEAD(generation);
-    if (generation < NUM_GENERATIONS-1)
-        old = GEN_HEAD(generation+1);
-    else
-        old = young;
+        /* handy references */
+        young = GEN_HEAD(generation);
+        if (generation < NUM_GENERATIONS-1)
+            old = GEN_HEAD(generation+1);
+        else
+            old = young;
+        /* In incremental mode, the survivors join the objects visited by
+         * the current pass, so that the slices empty the pending objects
+         * and the pass ends.  They are pending again in the next pass.
+         */
+        if (generation == NUM_GENERATIONS-2
+            && _PyRuntime.gc.incremental_budget > 0.0)
+            old = &_PyRuntime.gc.old_visited;
+        scanned = update_refs(young);
+    }
 
     /* Using ob_refcnt and gc_refs, calculate which objects in the
      * container set are reachable from outside the set (i.e., have a
      * refcount greater than 0 when all the references within the
      * set are taken into account).
      */
-    update_refs(young);
     subtract_refs(young);
 
     /* Leave everything reachable from outside young in young, and move
@@ -862,11 +1228,20 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
     gc_list_init(&unreachable);
     move_unreachable(young, &unreachable);
 
+    untrack_tuples(young);
     /* Move reachable objects to next generation. */
-    if (young != old) {
+    if (incremental) {
+        untrack_dicts(young);
+        gc_list_set_space(young, _PyRuntime.gc.visited_space);
+        gc_list_merge(young, old);
+    }
+    else if (young != old) {
         if (generation == NUM_GENERATIONS - 2) {
             _PyRuntime.gc.long_lived_pending += gc_list_size(young);
         }
+        if (old == &_PyRuntime.gc.old_visited) {
+            gc_list_set_space(young, _PyRuntime.gc.visited_space);
+        }
         gc_list_merge(young, old);
     }
     else {
@@ -875,6 +1250,7 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
         untrack_dicts(young);
         _PyRuntime.gc.long_lived_pending = 0;
         _PyRuntime.gc.long_lived_total = gc_list_size(young);
+        _PyRuntime.gc.incremental_rescan = 0;
     }
 
     /* All objects in unreachable are trash, but objects reachable from
@@ -891,8 +1267,7 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
     /* Collect statistics on collectable objects found and print
      * debugging information.
      */
-    for (gc = unreachable.gc.gc_next; gc != &unreachable;
-                    gc = gc->gc.gc_next) {
+    for (gc = GC_NEXT(&unreachable); gc != &unreachable; gc = GC_NEXT(gc)) {
         m++;
         if (_PyRuntime.gc.debug & DEBUG_COLLECTABLE) {
             debug_cycle("collectable", FROM_GC(gc));
@@ -900,13 +1275,18 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
     }
 
     /* Clear weakrefs and invoke callbacks as necessary. */
+    t_phase = _PyTime_GetMonotonicClock();
     m += handle_weakrefs(&unreachable, old);
+    t_end = _PyTime_GetMonotonicClock();
+    current.weakrefs_time = t_end - t_phase;
 
     /* Call tp_finalize on objects which have one. */
+    t_phase = t_end;
     finalize_garbage(&unreachable);
+    t_end = _PyTime_GetMonotonicClock();
+    current.finalize_time = t_end - t_phase;
 
     if (check_garbage(&unreachable)) {
-        revive_garbage(&unreachable);
         gc_list_merge(&unreachable, old);
     }
     else {
@@ -914,14 +1294,14 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
          * the reference cycles to be broken.  It may also cause some objects
          * in finalizers to be freed.
          */
+        t_phase = _PyTime_GetMonotonicClock();
         delete_garbage(&unreachable, old);
+        current.delete_time = _PyTime_GetMonotonicClock() - t_phase;
     }
 
     /* Collect statistics on uncollectable objects found and print
      * debugging information. */
-    for (gc = finalizers.gc.gc_next;
-         gc != &finalizers;
-         gc = gc->gc.gc_next) {
+    for (gc = GC_NEXT(&finalizers); gc != &finalizers; gc = GC_NEXT(gc)) {
         n++;
         if (_PyRuntime.gc.debug & DEBUG_UNCOLLECTABLE)
             debug_cycle("uncollectable", FROM_GC(gc));
@@ -946,8 +1326,8 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
     (void)handle_legacy_finalizers(&finalizers, old);
 
     /* Clear free list only during the collection of the highest
-     * generation */
-    if (generation == NUM_GENERATIONS-1) {
+     * generation, or once per incremental pass */
+    if (generation == NUM_GENERATIONS-1 && (!incremental || new_pass)) {
         clear_freelists();
     }
 
@@ -964,13 +1344,31 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
     }
 
     /* Update stats */
-    if (n_collected)
-        *n_collected = m;
-    if (n_uncollectable)
-        *n_uncollectable = n;
+    current.collected = m;
+    current.uncollectable = n;
+    current.scanned = scanned;
+    current.pause = current.max_pause = _PyTime_GetMonotonicClock() - t0;
+    record_pause(current.pause);
+
     stats->collections++;
     stats->collected += m;
     stats->uncollectable += n;
+    stats->scanned += scanned;
+    stats->pause += current.pause;
+    if (current.pause > stats->max_pause)
+        stats->max_pause = current.pause;
+    stats->weakrefs_time += current.weakrefs_time;
+    stats->finalize_time += current.finalize_time;
+    stats->delete_time += current.delete_time;
+    if (info)
+        *info = current;
+
+    if (incremental) {
+        update_increment_size(scanned, current.pause);
+    }
+    else if (generation < NUM_GENERATIONS-1) {
+        adapt_young_threshold(scanned, m + n);
+    }
 
     if (PyDTrace_GC_DONE_ENABLED())
         PyDTrace_GC_DONE(n+m);
@@ -978,12 +1376,29 @@ collect(int generation, Py_ssize_t *n_collected, Py_ssize_t *n_uncollectable,
     return n+m;
 }
 
+static PyObject *
+pause_histogram_as_tuple(void)
+{
+    PyObject *result = PyTuple_New(NUM_PAUSE_BUCKETS);
+    if (result == NULL)
+        return NULL;
+    for (int i = 0; i < NUM_PAUSE_BUCKETS; i++) {
+        PyObject *count = PyLong_FromSsize_t(_PyRuntime.gc.pause_histogram[i]);
+        if (count == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(result, i, count);
+    }
+    return result;
+}
+
 /* Invoke progress callbacks to notify clients that garbage collection
  * is starting or stopping
  */
 static void
-invoke_gc_callback(const char *phase, int generation,
-                   Py_ssize_t collected, Py_ssize_t uncollectable)
+invoke_gc_callback(const char *phase, int generation, int incremental,
+                   struct gc_generation_stats *st)
 {
     Py_ssize_t i;
     PyObject *info = NULL;
@@ -994,10 +1409,22 @@ invoke_gc_callback(const char *phase, int generation,
     /* The local variable cannot be rebound, check it for sanity */
     assert(_PyRuntime.gc.callbacks != NULL && PyList_CheckExact(_PyRuntime.gc.callbacks));
     if (PyList_GET_SIZE(_PyRuntime.gc.callbacks) != 0) {
-        info = Py_BuildValue("{sisnsn}",
+        PyObject *histogram = pause_histogram_as_tuple();
+        if (histogram == NULL) {
+            PyErr_WriteUnraisable(NULL);
+            return;
+        }
+        info = Py_BuildValue("{sisnsnsOsdsNsnsdsdsd}",
             "generation", generation,
-            "collected", collected,
-            "uncollectable", uncollectable);
+            "collected", st->collected,
+            "uncollectable", st->uncollectable,
+            "incremental", incremental ? Py_True : Py_False,
+            "pause", _PyTime_AsSecondsDouble(st->pause),
+            "pause_histogram", histogram,
+            "scanned", st->scanned,
+            "weakrefs_time", _PyTime_AsSecondsDouble(st->weakrefs_time),
+            "finalize_time", _PyTime_AsSecondsDouble(st->finalize_time),
+            "delete_time", _PyTime_AsSecondsDouble(st->delete_time));
         if (info == NULL) {
             PyErr_WriteUnraisable(NULL);
             return;
@@ -1015,16 +1442,17 @@ invoke_gc_callback(const char *phase, int generation,
     Py_XDECREF(info);
 }
 
-/* Perform garbage collection of a generation and invoke
- * progress callbacks.
+/* Perform garbage collection of a generation, or a slice of an
+ * incremental collection, and invoke progress callbacks.
  */
 static Py_ssize_t
-collect_with_callback(int generation)
+collect_with_callback(int generation, int incremental)
 {
-    Py_ssize_t result, collected, uncollectable;
-    invoke_gc_callback("start", generation, 0, 0);
-    result = collect(generation, &collected, &uncollectable, 0);
-    invoke_gc_callback("stop", generation, collected, uncollectable);
+    Py_ssize_t result;
+    struct gc_generation_stats info = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    invoke_gc_callback("start", generation, incremental, &info);
+    result = collect(generation, &info, 0, incremental);
+    invoke_gc_callback("stop", generation, incremental, &info);
     return result;
 }
 
@@ -1039,6 +1467,21 @@ collect_generations(void)
      * generations younger than it will be collected. */
     for (i = NUM_GENERATIONS-1; i >= 0; i--) {
         if (_PyRuntime.gc.generations[i].count > _PyRuntime.gc.generations[i].threshold) {
+            /* In incremental mode, collect a slice of the oldest
+               generation instead.  If a slice was cut by its size since
+               the last full collection, a pass may end with a full
+               collection, to find the garbage cycles the slices could
+               not (see build_increment()).  It is subject to the same
+               condition as below. */
+            if (i == NUM_GENERATIONS - 1
+                && _PyRuntime.gc.incremental_budget > 0.0) {
+                int rescan = (_PyRuntime.gc.incremental_rescan
+                              && gc_list_is_empty(GEN_HEAD(i))
+                              && _PyRuntime.gc.long_lived_pending
+                                 >= _PyRuntime.gc.long_lived_total / 4);
+                n = collect_with_callback(i, !rescan);
+                break;
+            }
             /* Avoid quadratic performance degradation in number
                of tracked objects. See comments at the beginning
                of this file, and issue #4074.
@@ -1046,7 +1489,7 @@ collect_generations(void)
             if (i == NUM_GENERATIONS - 1
                 && _PyRuntime.gc.long_lived_pending < _PyRuntime.gc.long_lived_total / 4)
                 continue;
-            n = collect_with_callback(i);
+            n = collect_with_callback(i, 0);
             break;
         }
     }
@@ -1125,7 +1568,7 @@ gc_collect_impl(PyObject *module, int generation)
         n = 0; /* already collecting, don't do anything */
     else {
         _PyRuntime.gc.collecting = 1;
-        n = collect_with_callback(generation);
+        n = collect_with_callback(generation, 0);
         _PyRuntime.gc.collecting = 0;
     }
 
@@ -1191,6 +1634,8 @@ gc_set_thresh(PyObject *self, PyObject *args)
         /* generations higher than 2 get the same threshold */
         _PyRuntime.gc.generations[i].threshold = _PyRuntime.gc.generations[2].threshold;
     }
+    /* the adaptive threshold restarts from the new one */
+    _PyRuntime.gc.base_threshold = _PyRuntime.gc.generations[0].threshold;
 
     Py_RETURN_NONE;
 }
@@ -1206,11 +1651,101 @@ gc_get_threshold_impl(PyObject *module)
 /*[clinic end generated code: output=7902bc9f41ecbbd8 input=286d79918034d6e6]*/
 {
     return Py_BuildValue("(iii)",
-                         _PyRuntime.gc.generations[0].threshold,
+                         _PyRuntime.gc.base_threshold,
                          _PyRuntime.gc.generations[1].threshold,
                          _PyRuntime.gc.generations[2].threshold);
 }
 
+/*[clinic input]
+gc.set_incremental
+
+    budget: double
+    /
+
+Enable or disable incremental collection of the oldest generation.
+
+A positive budget enables it: automatic collections of the oldest
+generation are then split into slices which try to pause the program
+for at most budget seconds.  Zero disables it.
+[clinic start generated code]*/
+
+static PyObject *
+gc_set_incremental_impl(PyObject *module, double budget)
+/*[clinic end generated code: output=bc503a6ec89b6c5b input=6197b1992d0435c6]*/
+{
+    if (!(budget >= 0.0)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "budget must be a non-negative number");
+        return NULL;
+    }
+    if (budget > 0.0 && _PyRuntime.gc.incremental_budget == 0.0) {
+        /* Objects frozen before are not marked yet */
+        gc_list_set_space(&_PyRuntime.gc.permanent_generation.head,
+                         GC_FROZEN);
+    }
+    else if (budget == 0.0) {
+        gc_list_merge(&_PyRuntime.gc.old_visited,
+                      GEN_HEAD(NUM_GENERATIONS-1));
+        _PyRuntime.gc.incremental_rescan = 0;
+    }
+    _PyRuntime.gc.incremental_budget = budget;
+    Py_RETURN_NONE;
+}
+
+/*[clinic input]
+gc.get_incremental -> double
+
+Return the pause budget of incremental collections, or 0.0 if disabled.
+[clinic start generated code]*/
+
+static double
+gc_get_incremental_impl(PyObject *module)
+/*[clinic end generated code: output=a4ff9b83a08a764e input=68fd5b8d157e561e]*/
+{
+    return _PyRuntime.gc.incremental_budget;
+}
+
+/*[clinic input]
+gc.set_adaptive_threshold
+
+    maximum: int
+    /
+
+Enable or disable the adaptive threshold of the youngest generation.
+
+A positive maximum enables it: the threshold of generation 0 then grows
+up to maximum while collections find little garbage, and shrinks back to
+the threshold set with set_threshold() when they find much.  Zero
+disables it.
+[clinic start generated code]*/
+
+static PyObject *
+gc_set_adaptive_threshold_impl(PyObject *module, int maximum)
+/*[clinic end generated code: output=e38e501ee6a51b2c input=646c1040b09bf8ef]*/
+{
+    if (maximum < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "maximum must be a non-negative number");
+        return NULL;
+    }
+    _PyRuntime.gc.adaptive_max = maximum;
+    _PyRuntime.gc.generations[0].threshold = _PyRuntime.gc.base_threshold;
+    Py_RETURN_NONE;
+}
+
+/*[clinic input]
+gc.get_adaptive_threshold -> int
+
+Return the maximum adaptive threshold of generation 0, or 0 if disabled.
+[clinic start generated code]*/
+
+static int
+gc_get_adaptive_threshold_impl(PyObject *module)
+/*[clinic end generated code: output=8a56f9135efb906c input=25cce23e77e30bb2]*/
+{
+    return _PyRuntime.gc.adaptive_max;
+}
+
 /*[clinic input]
 gc.get_count
 
@@ -1243,7 +1778,7 @@ gc_referrers_for(PyObject *objs, PyGC_Head *list, PyObject *resultlist)
     PyGC_Head *gc;
     PyObject *obj;
     traverseproc traverse;
-    for (gc = list->gc.gc_next; gc != list; gc = gc->gc.gc_next) {
+    for (gc = GC_NEXT(list); gc != list; gc = GC_NEXT(gc)) {
         obj = FROM_GC(gc);
         traverse = Py_TYPE(obj)->tp_traverse;
         if (obj == objs || obj == resultlist)
@@ -1273,6 +1808,10 @@ gc_get_referrers(PyObject *self, PyObject *args)
             return NULL;
         }
     }
+    if (!(gc_referrers_for(args, &_PyRuntime.gc.old_visited, result))) {
+        Py_DECREF(result);
+        return NULL;
+    }
     return result;
 }
 
@@ -1335,6 +1874,10 @@ gc_get_objects_impl(PyObject *module)
             return NULL;
         }
     }
+    if (append_objects(result, &_PyRuntime.gc.old_visited)) {
+        Py_DECREF(result);
+        return NULL;
+    }
     return result;
 }
 
@@ -1365,10 +1908,19 @@ gc_get_stats_impl(PyObject *module)
     for (i = 0; i < NUM_GENERATIONS; i++) {
         PyObject *dict;
         st = &stats[i];
-        dict = Py_BuildValue("{snsnsn}",
+        dict = Py_BuildValue("{snsnsnsnsdsdsdsdsd}",
                              "collections", st->collections,
                              "collected", st->collected,
-                             "uncollectable", st->uncollectable
+                             "uncollectable", st->uncollectable,
+                             "scanned", st->scanned,
+                             "total_pause", _PyTime_AsSecondsDouble(st->pause),
+                             "max_pause", _PyTime_AsSecondsDouble(st->max_pause),
+                             "weakrefs_time",
+                             _PyTime_AsSecondsDouble(st->weakrefs_time),
+                             "finalize_time",
+                             _PyTime_AsSecondsDouble(st->finalize_time),
+                             "delete_time",
+                             _PyTime_AsSecondsDouble(st->delete_time)
                             );
         if (dict == NULL)
             goto error;
@@ -1425,10 +1977,18 @@ static PyObject *
 gc_freeze_impl(PyObject *module)
 /*[clinic end generated code: output=502159d9cdc4c139 input=b602b16ac5febbe5]*/
 {
+    PyGC_Head frozen;
+
+    gc_list_init(&frozen);
     for (int i = 0; i < NUM_GENERATIONS; ++i) {
-        gc_list_merge(GEN_HEAD(i), &_PyRuntime.gc.permanent_generation.head);
+        gc_list_merge(GEN_HEAD(i), &frozen);
         _PyRuntime.gc.generations[i].count = 0;
     }
+    gc_list_merge(&_PyRuntime.gc.old_visited, &frozen);
+    /* Keep the frozen objects out of the increments */
+    if (_PyRuntime.gc.incremental_budget > 0.0)
+        gc_list_set_space(&frozen, GC_FROZEN);
+    gc_list_merge(&frozen, &_PyRuntime.gc.permanent_generation.head);
     Py_RETURN_NONE;
 }
 
@@ -1444,6 +2004,9 @@ static PyObject *
 gc_unfreeze_impl(PyObject *module)
 /*[clinic end generated code: output=1c15f2043b25e169 input=2dd52b170f4cef6c]*/
 {
+    /* Make the objects pending again for the incremental collection */
+    gc_list_set_space(&_PyRuntime.gc.permanent_generation.head,
+                      GC_SPACE_PENDING);
     gc_list_merge(&_PyRuntime.gc.permanent_generation.head, GEN_HEAD(NUM_GENERATIONS-1));
     Py_RETURN_NONE;
 }
@@ -1461,6 +2024,21 @@ gc_get_freeze_count_impl(PyObject *module)
     return gc_list_size(&_PyRuntime.gc.permanent_generation.head);
 }
 
+/*[clinic input]
+gc.get_untracked_count -> Py_ssize_t
+
+Return the number of tuples and frozensets untracked when created.
+
+These only contained atomic objects, and were never examined by the
+collector.
+[clinic start generated code]*/
+
+static Py_ssize_t
+gc_get_untracked_count_impl(PyObject *module)
+/*[clinic end generated code: output=2427e13345f835b6 input=8729ff28e0aee638]*/
+{
+    return _PyRuntime.gc.untracked_at_creation;
+}
 
 PyDoc_STRVAR(gc__doc__,
 "This module provides access to the garbage collector for reference cycles.\n"
@@ -1475,13 +2053,18 @@ PyDoc_STRVAR(gc__doc__,
 "get_debug() -- Get debugging flags.\n"
 "set_threshold() -- Set the collection thresholds.\n"
 "get_threshold() -- Return the current the collection thresholds.\n"
+"set_incremental() -- Enable or disable incremental collection.\n"
+"get_incremental() -- Return the pause budget of incremental collections.\n"
+"set_adaptive_threshold() -- Enable or disable the adaptive threshold.\n"
+"get_adaptive_threshold() -- Return the maximum adaptive threshold.\n"
 "get_objects() -- Return a list of all objects tracked by the collector.\n"
 "is_tracked() -- Returns true if a given object is tracked.\n"
 "get_referrers() -- Return the list of objects that refer to an object.\n"
 "get_referents() -- Return the list of objects that an object refers to.\n"
 "freeze() -- Freeze all tracked objects and ignore them for future collections.\n"
 "unfreeze() -- Unfreeze all objects in the permanent generation.\n"
-"get_freeze_count() -- Return the number of objects in the permanent generation.\n");
+"get_freeze_count() -- Return the number of objects in the permanent generation.\n"
+"get_untracked_count() -- Return the number of containers untracked when created.\n");
 
 static PyMethodDef GcMethods[] = {
     GC_ENABLE_METHODDEF
@@ -1492,6 +2075,10 @@ static PyMethodDef GcMethods[] = {
     GC_GET_COUNT_METHODDEF
     {"set_threshold",  gc_set_thresh, METH_VARARGS, gc_set_thresh__doc__},
     GC_GET_THRESHOLD_METHODDEF
+    GC_SET_INCREMENTAL_METHODDEF
+    GC_GET_INCREMENTAL_METHODDEF
+    GC_SET_ADAPTIVE_THRESHOLD_METHODDEF
+    GC_GET_ADAPTIVE_THRESHOLD_METHODDEF
     GC_COLLECT_METHODDEF
     GC_GET_OBJECTS_METHODDEF
     GC_GET_STATS_METHODDEF
@@ -1503,6 +2090,7 @@ static PyMethodDef GcMethods[] = {
     GC_FREEZE_METHODDEF
     GC_UNFREEZE_METHODDEF
     GC_GET_FREEZE_COUNT_METHODDEF
+    GC_GET_UNTRACKED_COUNT_METHODDEF
     {NULL,      NULL}           /* Sentinel */
 };
 
@@ -1566,7 +2154,7 @@ PyGC_Collect(void)
         n = 0; /* already collecting, don't do anything */
     else {
         _PyRuntime.gc.collecting = 1;
-        n = collect_with_callback(NUM_GENERATIONS - 1);
+        n = collect_with_callback(NUM_GENERATIONS - 1, 0);
         _PyRuntime.gc.collecting = 0;
     }
 
@@ -1597,7 +2185,7 @@ _PyGC_CollectNoFail(void)
         n = 0;
     else {
         _PyRuntime.gc.collecting = 1;
-        n = collect(NUM_GENERATIONS - 1, NULL, NULL, 1);
+        n = collect(NUM_GENERATIONS - 1, NULL, 1, 0);
         _PyRuntime.gc.collecting = 0;
     }
     return n;
@@ -1691,8 +2279,8 @@ _PyObject_GC_Alloc(int use_calloc, size_t basicsize)
         g = (PyGC_Head *)PyObject_Malloc(size);
     if (g == NULL)
         return PyErr_NoMemory();
-    g->gc.gc_refs = 0;
-    _PyGCHead_SET_REFS(g, GC_UNTRACKED);
+    g->_gc_next = 0;
+    g->_gc_prev = 0;
     _PyRuntime.gc.generations[0].count++; /* number of allocated GC objects */
     if (_PyRuntime.gc.generations[0].count > _PyRuntime.gc.generations[0].threshold &&
         _PyRuntime.gc.enabled &&
@@ -1712,6 +1712,45 @@ pymain_init_tracemalloc(_PyCoreConfig *config)
 }
 
 
+static _PyInitError
+pymain_init_arenas(_PyCoreConfig *config)
+{
+    const wchar_t *xoption = config_get_xoption(config, L"arenasize");
+    if (xoption) {
+        const wchar_t *sep = wcschr(xoption, L'=');
+        if (sep == NULL) {
+            return _Py_INIT_USER_ERR("-X arenasize=SIZE: missing size");
+        }
+        errno = 0;
+        wchar_t *endptr;
+        unsigned long long size = wcstoull(sep + 1, &endptr, 10);
+        switch (*endptr) {
+        case L'k': case L'K':
+            size <<= 10;
+            endptr++;
+            break;
+        case L'm': case L'M':
+            size <<= 20;
+            endptr++;
+            break;
+        case L'g': case L'G':
+            size <<= 30;
+            endptr++;
+            break;
+        }
+        if (*endptr != L'\0' || endptr == sep + 1 || errno == ERANGE
+            || size == 0 || size > PY_SIZE_MAX) {
+            return _Py_INIT_USER_ERR("-X arenasize=SIZE: invalid size");
+        }
+        config->arena_size = (size_t)size;
+    }
+    if (config_get_xoption(config, L"hugepages")) {
+        config->hugepages = 1;
+    }
+    return _Py_INIT_OK();
+}
+
+
 static void
 get_env_flag(int *flag, const char *name)
 {
@@ -1905,6 +1944,26 @@ config_read_complex_options(_PyCoreConfig *config)
     if (_Py_INIT_FAILED(err)) {
         return err;
     }
+
+    err = pymain_init_arenas(config);
+    if (_Py_INIT_FAILED(err)) {
+        return err;
+    }
+
+    const wchar_t *xoption = config_get_xoption(config, L"opcodeprofile");
+    if (xoption) {
+        const wchar_t *sep = wcschr(xoption, L'=');
+        if (sep == NULL) {
+            config->opcode_profile = 1;
+        }
+        else if (wcscmp(sep + 1, L"code") == 0) {
+            config->opcode_profile = 2;
+        }
+        else {
+            return _Py_INIT_USER_ERR("-X opcodeprofile=code: "
+                                     "invalid value");
+        }
+    }
     return _Py_INIT_OK();
 }
 
@@ -2202,6 +2261,9 @@ _PyCoreConfig_Copy(_PyCoreConfig *config, const _PyCoreConfig *config2)
     COPY_ATTR(import_time);
     COPY_ATTR(show_ref_count);
     COPY_ATTR(show_alloc_count);
+    COPY_ATTR(opcode_profile);
+    COPY_ATTR(arena_size);
+    COPY_ATTR(hugepages);
     COPY_ATTR(dump_refs);
     COPY_ATTR(malloc_stats);
     COPY_ATTR(utf8_mode);
@@ -55,6 +55,26 @@ bool_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     return PyBool_FromLong(ok);
 }
 
+/* Call bool() without a tuple of the arguments */
+static PyObject *
+bool_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+                PyObject *kwnames)
+{
+    long ok;
+
+    assert(type == (PyObject *)&PyBool_Type);
+    if (kwnames != NULL || nargs > 1) {
+        return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+    }
+    if (nargs == 0) {
+        Py_RETURN_FALSE;
+    }
+    ok = PyObject_IsTrue(args[0]);
+    if (ok < 0)
+        return NULL;
+    return PyBool_FromLong(ok);
+}
+
 /* Arithmetic operations redefined to return bool if both args are bool. */
 
 static PyObject *
@@ -170,6 +190,18 @@ PyTypeObject PyBool_Type = {
     0,                                          /* tp_init */
     0,                                          /* tp_alloc */
     bool_new,                                   /* tp_new */
+    0,                                          /* tp_free */
+    0,                                          /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    0,                                          /* tp_vectorcall_offset */
+    bool_vectorcall,                            /* tp_vectorcall */
 };
 
 /* The objects representing bool values False and True */
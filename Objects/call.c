@@ -14,7 +14,8 @@ _PyObject_HasFastCall(PyObject *callable)
     }
     else {
         assert (PyCallable_Check(callable));
-        return 0;
+        return PyType_HasFeature(Py_TYPE(callable),
+                                 Py_TPFLAGS_HAVE_VECTORCALL);
     }
 }
 
@@ -80,6 +81,39 @@ _Py_CheckFunctionResult(PyObject *callable, PyObject *result, const char *where)
 
 /* --- Core PyObject call functions ------------------------------- */
 
+/* Return the vectorcallfunc of callable, or NULL if it must be called
+   through tp_call */
+static vectorcallfunc
+vectorcall_function(PyObject *callable)
+{
+    PyTypeObject *tp = Py_TYPE(callable);
+
+    if (!PyType_HasFeature(tp, Py_TPFLAGS_HAVE_VECTORCALL)) {
+        return NULL;
+    }
+    assert(tp->tp_vectorcall_offset > 0);
+    return *(vectorcallfunc *)((char *)callable + tp->tp_vectorcall_offset);
+}
+
+static PyObject *
+vectorcall_dict(vectorcallfunc func, PyObject *callable,
+                PyObject *const *args, Py_ssize_t nargs, PyObject *kwargs)
+{
+    PyObject *const *stack;
+    PyObject *kwnames;
+    PyObject *result;
+
+    if (_PyStack_UnpackDict(args, nargs, kwargs, &stack, &kwnames) < 0) {
+        return NULL;
+    }
+    result = func(callable, stack, nargs, kwnames);
+    if (stack != args) {
+        PyMem_Free((PyObject **)stack);
+    }
+    Py_XDECREF(kwnames);
+    return _Py_CheckFunctionResult(callable, result, NULL);
+}
+
 PyObject *
 _PyObject_FastCallDict(PyObject *callable, PyObject *const *args, Py_ssize_t nargs,
                        PyObject *kwargs)
@@ -103,6 +137,11 @@ _PyObject_FastCallDict(PyObject *callable, PyObject *const *args, Py_ssize_t nar
     else {
         PyObject *argstuple, *result;
         ternaryfunc call;
+        vectorcallfunc func = vectorcall_function(callable);
+
+        if (func != NULL) {
+            return vectorcall_dict(func, callable, args, nargs, kwargs);
+        }
 
         /* Slow-path: build a temporary tuple */
         call = callable->ob_type->tp_call;
@@ -156,56 +195,75 @@ _PyObject_FastCallKeywords(PyObject *callable, PyObject *const *stack, Py_ssize_
         return _PyCFunction_FastCallKeywords(callable, stack, nargs, kwnames);
     }
     else {
-        /* Slow-path: build a temporary tuple for positional arguments and a
-           temporary dictionary for keyword arguments (if any) */
+        vectorcallfunc func = vectorcall_function(callable);
 
-        ternaryfunc call;
-        PyObject *argstuple;
-        PyObject *kwdict, *result;
-        Py_ssize_t nkwargs;
-
-        nkwargs = (kwnames == NULL) ? 0 : PyTuple_GET_SIZE(kwnames);
-        assert((nargs == 0 && nkwargs == 0) || stack != NULL);
+        if (func != NULL) {
+            PyObject *result;
 
-        call = callable->ob_type->tp_call;
-        if (call == NULL) {
-            PyErr_Format(PyExc_TypeError, "'%.200s' object is not callable",
-                         callable->ob_type->tp_name);
-            return NULL;
+            if (kwnames != NULL && PyTuple_GET_SIZE(kwnames) == 0) {
+                kwnames = NULL;
+            }
+            result = func(callable, stack, nargs, kwnames);
+            return _Py_CheckFunctionResult(callable, result, NULL);
         }
+        return _PyObject_MakeTpCall(callable, stack, nargs, kwnames);
+    }
+}
 
-        argstuple = _PyStack_AsTuple(stack, nargs);
-        if (argstuple == NULL) {
-            return NULL;
-        }
 
-        if (nkwargs > 0) {
-            kwdict = _PyStack_AsDict(stack + nargs, kwnames);
-            if (kwdict == NULL) {
-                Py_DECREF(argstuple);
-                return NULL;
-            }
-        }
-        else {
-            kwdict = NULL;
-        }
+PyObject *
+_PyObject_MakeTpCall(PyObject *callable, PyObject *const *stack,
+                     Py_ssize_t nargs, PyObject *kwnames)
+{
+    /* Slow-path: build a temporary tuple for positional arguments and a
+       temporary dictionary for keyword arguments (if any) */
 
-        if (Py_EnterRecursiveCall(" while calling a Python object")) {
+    ternaryfunc call;
+    PyObject *argstuple;
+    PyObject *kwdict, *result;
+    Py_ssize_t nkwargs;
+
+    nkwargs = (kwnames == NULL) ? 0 : PyTuple_GET_SIZE(kwnames);
+    assert((nargs == 0 && nkwargs == 0) || stack != NULL);
+
+    call = callable->ob_type->tp_call;
+    if (call == NULL) {
+        PyErr_Format(PyExc_TypeError, "'%.200s' object is not callable",
+                     callable->ob_type->tp_name);
+        return NULL;
+    }
+
+    argstuple = _PyStack_AsTuple(stack, nargs);
+    if (argstuple == NULL) {
+        return NULL;
+    }
+
+    if (nkwargs > 0) {
+        kwdict = _PyStack_AsDict(stack + nargs, kwnames);
+        if (kwdict == NULL) {
             Py_DECREF(argstuple);
-            Py_XDECREF(kwdict);
             return NULL;
         }
+    }
+    else {
+        kwdict = NULL;
+    }
 
-        result = (*call)(callable, argstuple, kwdict);
-
-        Py_LeaveRecursiveCall();
-
+    if (Py_EnterRecursiveCall(" while calling a Python object")) {
         Py_DECREF(argstuple);
         Py_XDECREF(kwdict);
-
-        result = _Py_CheckFunctionResult(callable, result, NULL);
-        return result;
+        return NULL;
     }
+
+    result = (*call)(callable, argstuple, kwdict);
+
+    Py_LeaveRecursiveCall();
+
+    Py_DECREF(argstuple);
+    Py_XDECREF(kwdict);
+
+    result = _Py_CheckFunctionResult(callable, result, NULL);
+    return result;
 }
 
 
@@ -265,11 +323,11 @@ function_code_fastcall(PyCodeObject *co, PyObject *const *args, Py_ssize_t nargs
 
     assert(globals != NULL);
     /* XXX Perhaps we should create a specialized
-       _PyFrame_New_NoTrack() that doesn't take locals, but does
+       _PyFrame_New_OnStack() that doesn't take locals, but does
        take builtins without sanity checking them.
        */
     assert(tstate != NULL);
-    f = _PyFrame_New_NoTrack(tstate, co, globals, NULL);
+    f = _PyFrame_New_OnStack(tstate, co, globals, NULL);
     if (f == NULL) {
         return NULL;
     }
@@ -282,15 +340,9 @@ function_code_fastcall(PyCodeObject *co, PyObject *const *args, Py_ssize_t nargs
     }
     result = PyEval_EvalFrameEx(f,0);
 
-    if (Py_REFCNT(f) > 1) {
-        Py_DECREF(f);
-        _PyObject_GC_TRACK(f);
-    }
-    else {
-        ++tstate->recursion_depth;
-        Py_DECREF(f);
-        --tstate->recursion_depth;
-    }
+    ++tstate->recursion_depth;
+    _PyFrame_Clear_OnStack(tstate, f);
+    --tstate->recursion_depth;
     return result;
 }
 
@@ -871,6 +923,44 @@ _PyObject_FastCall_Prepend(PyObject *callable, PyObject *obj,
 }
 
 
+/* Call callable(obj, *args, **kwargs), where the arguments are given in
+   the format of _PyObject_FastCallKeywords() */
+PyObject *
+_PyObject_FastCallKeywords_Prepend(PyObject *callable, PyObject *obj,
+                                   PyObject *const *args, Py_ssize_t nargs,
+                                   PyObject *kwnames)
+{
+    PyObject *small_stack[_PY_FASTCALL_SMALL_STACK];
+    PyObject **args2;
+    PyObject *result;
+    Py_ssize_t nkwargs = (kwnames == NULL) ? 0 : PyTuple_GET_SIZE(kwnames);
+    Py_ssize_t n = nargs + nkwargs + 1;
+
+    if (n <= (Py_ssize_t)Py_ARRAY_LENGTH(small_stack)) {
+        args2 = small_stack;
+    }
+    else {
+        args2 = PyMem_Malloc(n * sizeof(PyObject *));
+        if (args2 == NULL) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+    }
+
+    /* use borrowed references */
+    args2[0] = obj;
+    if (n > 1) {
+        memcpy(&args2[1], args, (n - 1) * sizeof(PyObject *));
+    }
+
+    result = _PyObject_FastCallKeywords(callable, args2, nargs + 1, kwnames);
+    if (args2 != small_stack) {
+        PyMem_Free(args2);
+    }
+    return result;
+}
+
+
 /* Call callable(obj, *args, **kwargs). */
 PyObject *
 _PyObject_Call_Prepend(PyObject *callable,
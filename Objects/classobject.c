@@ -44,6 +44,9 @@ PyMethod_Self(PyObject *im)
    function.
 */
 
+static PyObject *method_vectorcall(PyObject *, PyObject *const *,
+                                   Py_ssize_t, PyObject *);
+
 PyObject *
 PyMethod_New(PyObject *func, PyObject *self)
 {
@@ -68,6 +71,7 @@ PyMethod_New(PyObject *func, PyObject *self)
     im->im_func = func;
     Py_XINCREF(self);
     im->im_self = self;
+    im->vectorcall = method_vectorcall;
     _PyObject_GC_TRACK(im);
     return (PyObject *)im;
 }
@@ -319,6 +323,18 @@ method_call(PyObject *method, PyObject *args, PyObject *kwargs)
     return _PyObject_Call_Prepend(func, self, args, kwargs);
 }
 
+static PyObject *
+method_vectorcall(PyObject *method, PyObject *const *args,
+                  Py_ssize_t nargs, PyObject *kwnames)
+{
+    PyObject *self, *func;
+
+    self = PyMethod_GET_SELF(method);
+    func = PyMethod_GET_FUNCTION(method);
+
+    return _PyObject_FastCallKeywords_Prepend(func, self, args, nargs, kwnames);
+}
+
 static PyObject *
 method_descr_get(PyObject *meth, PyObject *obj, PyObject *cls)
 {
@@ -353,7 +369,8 @@ PyTypeObject PyMethod_Type = {
     method_getattro,                            /* tp_getattro */
     PyObject_GenericSetAttr,                    /* tp_setattro */
     0,                                          /* tp_as_buffer */
-    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, /* tp_flags */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC |
+        Py_TPFLAGS_HAVE_VECTORCALL,             /* tp_flags */
     method_doc,                                 /* tp_doc */
     (traverseproc)method_traverse,              /* tp_traverse */
     0,                                          /* tp_clear */
@@ -372,6 +389,17 @@ PyTypeObject PyMethod_Type = {
     0,                                          /* tp_init */
     0,                                          /* tp_alloc */
     method_new,                                 /* tp_new */
+    0,                                          /* tp_free */
+    0,                                          /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    offsetof(PyMethodObject, vectorcall),       /* tp_vectorcall_offset */
 };
 
 /* Clear out the free list */
@@ -2,7 +2,9 @@
 
 #include "Python.h"
 #include "code.h"
+#include "opcode.h"
 #include "structmember.h"
+#include "internal/code.h"
 
 /* Holder for co_extra information */
 typedef struct {
@@ -206,9 +208,88 @@ PyCode_New(int argcount, int kwonlyargcount,
     co->co_zombieframe = NULL;
     co->co_weakreflist = NULL;
     co->co_extra = NULL;
+
+    co->co_opcache_map = NULL;
+    co->co_opcache = NULL;
+    co->co_opcache_flag = 0;
+    co->co_opcache_size = 0;
+    co->co_quickened = NULL;
     return co;
 }
 
+int
+_PyCode_InitOpcache(PyCodeObject *co)
+{
+    Py_ssize_t co_size = PyBytes_Size(co->co_code) / sizeof(_Py_CODEUNIT);
+    co->co_opcache_map = (unsigned char *)PyMem_Calloc(co_size + 1, 1);
+    if (co->co_opcache_map == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    const _Py_CODEUNIT *opcodes = (const _Py_CODEUNIT*)PyBytes_AS_STRING(co->co_code);
+    Py_ssize_t opts = 0;
+    int specializable = 0;
+
+    for (Py_ssize_t i = 0; i < co_size;) {
+        unsigned char opcode = _Py_OPCODE(opcodes[i]);
+        i++;  /* 'i' is now aligned to (next_instr - first_instr) */
+
+        switch (opcode) {
+        case BINARY_ADD:
+        case BINARY_SUBTRACT:
+        case BINARY_MULTIPLY:
+        case COMPARE_OP:
+            specializable = 1;
+            /* fall through */
+        case LOAD_GLOBAL:
+        case LOAD_ATTR:
+        case LOAD_METHOD:
+            opts++;
+            co->co_opcache_map[i] = (unsigned char)opts;
+            break;
+        default:
+            continue;
+        }
+        if (opts > 254) {
+            break;
+        }
+    }
+
+    if (opts) {
+        co->co_opcache = (_PyOpcache *)PyMem_Calloc(opts, sizeof(_PyOpcache));
+        if (co->co_opcache == NULL) {
+            PyMem_FREE(co->co_opcache_map);
+            co->co_opcache_map = NULL;
+            PyErr_NoMemory();
+            return -1;
+        }
+        if (specializable) {
+            /* Specialized instructions are written into a private copy
+               of the bytecode: co_code must stay unchanged. */
+            co->co_quickened = (_Py_CODEUNIT *)PyMem_Malloc(
+                co_size * sizeof(_Py_CODEUNIT));
+            if (co->co_quickened == NULL) {
+                PyMem_FREE(co->co_opcache);
+                co->co_opcache = NULL;
+                PyMem_FREE(co->co_opcache_map);
+                co->co_opcache_map = NULL;
+                PyErr_NoMemory();
+                return -1;
+            }
+            memcpy(co->co_quickened, opcodes, co_size * sizeof(_Py_CODEUNIT));
+        }
+    }
+    else {
+        PyMem_FREE(co->co_opcache_map);
+        co->co_opcache_map = NULL;
+        co->co_opcache = NULL;
+    }
+
+    co->co_opcache_size = (unsigned char)opts;
+    return 0;
+}
+
 PyCodeObject *
 PyCode_NewEmpty(const char *filename, const char *funcname, int firstlineno)
 {
@@ -415,6 +496,18 @@ code_new(PyTypeObject *type, PyObject *args, PyObject *kw)
 static void
 code_dealloc(PyCodeObject *co)
 {
+    if (co->co_opcache != NULL) {
+        PyMem_FREE(co->co_opcache);
+    }
+    if (co->co_opcache_map != NULL) {
+        PyMem_FREE(co->co_opcache_map);
+    }
+    if (co->co_quickened != NULL) {
+        PyMem_FREE(co->co_quickened);
+    }
+    co->co_opcache_flag = 0;
+    co->co_opcache_size = 0;
+
     if (co->co_extra != NULL) {
         PyInterpreterState *interp = PyThreadState_Get()->interp;
         _PyCodeObjectExtra *co_extra = co->co_extra;
@@ -461,6 +554,16 @@ code_sizeof(PyCodeObject *co, void *unused)
         res += sizeof(_PyCodeObjectExtra) +
                (co_extra->ce_size-1) * sizeof(co_extra->ce_extras[0]);
     }
+    if (co->co_opcache != NULL) {
+        assert(co->co_opcache_map != NULL);
+        /* co_opcache_map */
+        res += PyBytes_GET_SIZE(co->co_code) / sizeof(_Py_CODEUNIT) + 1;
+        /* co_opcache */
+        res += co->co_opcache_size * sizeof(_PyOpcache);
+    }
+    if (co->co_quickened != NULL) {
+        res += PyBytes_GET_SIZE(co->co_code);
+    }
     return PyLong_FromSsize_t(res);
 }
 
@@ -870,6 +973,7 @@ _PyCode_SetExtra(PyObject *code, Py_ssize_t index, void *extra)
                 sizeof(_PyCodeObjectExtra) +
                 (interp->co_extra_user_count-1) * sizeof(void*));
         if (co_extra == NULL) {
+            PyErr_NoMemory();
             return -1;
         }
         for (; i < interp->co_extra_user_count; i++) {
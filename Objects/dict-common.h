@@ -58,6 +58,9 @@ struct _dictkeysobject {
        - 4 bytes if dk_size <= 0xffffffff (int32_t*)
        - 8 bytes otherwise (int64_t*)
 
+       Large tables also have a tag byte per index, stored by groups
+       before the indices: see the tag bytes in dictobject.c.
+
        Dynamically sized, 8 is minimum. */
     union {
         int8_t as_1[8];
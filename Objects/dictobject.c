@@ -115,6 +115,15 @@ converting the dict to the combined table.
 #include "dict-common.h"
 #include "stringlib/eq.h"    /* to get unicode_eq() */
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define DK_HAVE_SSE2
+#  include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
 /*[clinic input]
 class dict "PyDictObject *" "&PyDict_Type"
 [clinic start generated code]*/
@@ -251,6 +260,30 @@ static int numfree = 0;
 static PyDictKeysObject *keys_free_list[PyDict_MAXFREELIST];
 static int numfreekeys = 0;
 
+/* Statistics on the split tables, see _PyDict_GetSharingStats().
+ * A split table is "unshared" when it is converted to a combined table. */
+enum {
+    UNSHARE_ORDER,          /* key inserted out of the shared order */
+    UNSHARE_DELETION,       /* del, pop() or popitem() */
+    UNSHARE_NON_STR,        /* key which is not an exact str */
+    UNSHARE_FULL,           /* shared keys full, and shared by other dicts */
+    UNSHARE_NREASONS
+};
+
+static struct {
+    Py_ssize_t created;         /* dicts created with the keys of a type */
+    Py_ssize_t unshared;        /* split tables converted, for any reason */
+    Py_ssize_t reasons[UNSHARE_NREASONS];
+    Py_ssize_t variants_created;
+    Py_ssize_t variant_switches;
+} sharing_stats;
+
+#define COUNT_UNSHARE(mp, reason) \
+    do { \
+        if (_PyDict_HasSplitTable(mp)) \
+            sharing_stats.reasons[reason]++; \
+    } while (0)
+
 #include "clinic/dictobject.c.h"
 
 int
@@ -278,6 +311,28 @@ _PyDict_DebugMallocStats(FILE *out)
 }
 
 
+PyObject *
+_PyDict_GetSharingStats(void)
+{
+    Py_ssize_t other = sharing_stats.unshared;
+    int i;
+
+    for (i = 0; i < UNSHARE_NREASONS; i++) {
+        other -= sharing_stats.reasons[i];
+    }
+    return Py_BuildValue("{snsnsnsnsnsnsnsnsn}",
+                         "created", sharing_stats.created,
+                         "unshared", sharing_stats.unshared,
+                         "order", sharing_stats.reasons[UNSHARE_ORDER],
+                         "deletion", sharing_stats.reasons[UNSHARE_DELETION],
+                         "non_str", sharing_stats.reasons[UNSHARE_NON_STR],
+                         "full", sharing_stats.reasons[UNSHARE_FULL],
+                         "other", other,
+                         "variants_created", sharing_stats.variants_created,
+                         "variant_switches", sharing_stats.variant_switches);
+}
+
+
 void
 PyDict_Fini(void)
 {
@@ -297,8 +352,40 @@ PyDict_Fini(void)
         1 : DK_SIZE(dk) <= 0xffff ?            \
             2 : sizeof(int32_t))
 #endif
+/* Tag bytes.
+ *
+ * The tables of at least DK_TAGS_MINSIZE slots have a tag byte for each
+ * slot of dk_indices: DK_TAG_EMPTY, DK_TAG_DUMMY, or 7 bits of the hash of
+ * the key of the slot.  Their slots are probed by groups of DK_GROUP_SIZE
+ * instead of one at a time: the tags of a whole group are compared with
+ * the tag of the hash (with SSE2 when available), and only the entries of
+ * the matching slots are read.  Each group is stored as its DK_GROUP_SIZE
+ * tags followed by its DK_GROUP_SIZE indices, so that the index of a
+ * matching slot is usually in the cache line of the tags.  The groups
+ * follow the same perturbed sequence as the slots of the smaller tables, so
+ * the lookups which miss stop at the first group with an empty slot.  The
+ * entries, and so the iteration order, don't change.
+ */
+#define DK_TAGS_MINSIZE     (1 << 14)
+#define DK_GROUP_SIZE       16
+#define DK_TAG_EMPTY        0xff    /* like the bytes of DKIX_EMPTY */
+#define DK_TAG_DUMMY        0x80
+
+#if DK_TAGS_MINSIZE <= 0xff
+#  error "the tables with 1-byte indices can't have tag bytes"
+#endif
+
+#define DK_HAS_TAGS(dk) (DK_SIZE(dk) >= DK_TAGS_MINSIZE)
+/* Position of slot i in the array of indices of es bytes */
+#define DK_TAGGED_POS(i, es) \
+    ((i) + ((i) / DK_GROUP_SIZE + 1) * (DK_GROUP_SIZE / (es)))
+/* Size in bytes of a group and of its tags */
+#define DK_GROUP_BYTES(dk) (DK_GROUP_SIZE * (1 + DK_IXSIZE(dk)))
+#define DK_GROUP_MASK(dk) (DK_MASK(dk) / DK_GROUP_SIZE)
+
 #define DK_ENTRIES(dk) \
-    ((PyDictKeyEntry*)(&(dk)->dk_indices.as_1[DK_SIZE(dk) * DK_IXSIZE(dk)]))
+    ((PyDictKeyEntry*)(&(dk)->dk_indices.as_1[ \
+        DK_SIZE(dk) * (DK_IXSIZE(dk) + DK_HAS_TAGS(dk))]))
 
 #define DK_DEBUG_INCREF _Py_INC_REFTOTAL _Py_REF_DEBUG_COMMA
 #define DK_DEBUG_DECREF _Py_DEC_REFTOTAL _Py_REF_DEBUG_COMMA
@@ -321,16 +408,22 @@ dk_get_index(PyDictKeysObject *keys, Py_ssize_t i)
     }
     else if (s <= 0xffff) {
         int16_t *indices = keys->dk_indices.as_2;
+        if (s >= DK_TAGS_MINSIZE) {
+            i = DK_TAGGED_POS(i, 2);
+        }
         ix = indices[i];
     }
 #if SIZEOF_VOID_P > 4
     else if (s > 0xffffffff) {
         int64_t *indices = keys->dk_indices.as_8;
-        ix = indices[i];
+        ix = indices[DK_TAGGED_POS(i, 8)];
     }
 #endif
     else {
         int32_t *indices = keys->dk_indices.as_4;
+        if (s >= DK_TAGS_MINSIZE) {
+            i = DK_TAGGED_POS(i, 4);
+        }
         ix = indices[i];
     }
     assert(ix >= DKIX_DUMMY);
@@ -353,17 +446,23 @@ dk_set_index(PyDictKeysObject *keys, Py_ssize_t i, Py_ssize_t ix)
     else if (s <= 0xffff) {
         int16_t *indices = keys->dk_indices.as_2;
         assert(ix <= 0x7fff);
+        if (s >= DK_TAGS_MINSIZE) {
+            i = DK_TAGGED_POS(i, 2);
+        }
         indices[i] = (int16_t)ix;
     }
 #if SIZEOF_VOID_P > 4
     else if (s > 0xffffffff) {
         int64_t *indices = keys->dk_indices.as_8;
-        indices[i] = ix;
+        indices[DK_TAGGED_POS(i, 8)] = ix;
     }
 #endif
     else {
         int32_t *indices = keys->dk_indices.as_4;
         assert(ix <= 0x7fffffff);
+        if (s >= DK_TAGS_MINSIZE) {
+            i = DK_TAGGED_POS(i, 4);
+        }
         indices[i] = (int32_t)ix;
     }
 }
@@ -408,6 +507,95 @@ dk_set_index(PyDictKeysObject *keys, Py_ssize_t i, Py_ssize_t ix)
  */
 #define GROWTH_RATE(d) (((d)->ma_used*2)+((d)->ma_keys->dk_size>>1))
 
+/* Small ints are their own hash: mix in the high bits, so that the tags of
+   other keys don't depend on their group. */
+#define DK_TAG(hash) \
+    ((uint8_t)(((size_t)(hash) ^ \
+                ((size_t)(hash) >> (8 * SIZEOF_SIZE_T - 7))) & 0x7f))
+
+/* Return the bit mask of the slots of the group starting at tags which
+   have the given tag. */
+static inline unsigned int
+dk_group_match(const uint8_t *tags, uint8_t tag)
+{
+#ifdef DK_HAVE_SSE2
+    __m128i group = _mm_loadu_si128((const __m128i *)tags);
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+#else
+    unsigned int mask = 0;
+    for (int k = 0; k < DK_GROUP_SIZE; k++) {
+        if (tags[k] == tag) {
+            mask |= 1U << k;
+        }
+    }
+    return mask;
+#endif
+}
+
+/* Return the bit mask of the empty and dummy slots of the group starting
+   at tags: the only tags with the high bit set. */
+static inline unsigned int
+dk_group_free(const uint8_t *tags)
+{
+#ifdef DK_HAVE_SSE2
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)tags));
+#else
+    unsigned int mask = 0;
+    for (int k = 0; k < DK_GROUP_SIZE; k++) {
+        if (tags[k] & 0x80) {
+            mask |= 1U << k;
+        }
+    }
+    return mask;
+#endif
+}
+
+/* Return the index of the lowest bit set in mask, which isn't 0. */
+static inline unsigned int
+dk_first_slot(unsigned int mask)
+{
+    assert(mask != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long k;
+    _BitScanForward(&k, mask);
+    return (unsigned int)k;
+#else
+    unsigned int k = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        k++;
+    }
+    return k;
+#endif
+}
+
+/* Set slot i to the entry ix, whose key has the given hash. */
+static inline void
+dk_set_entry(PyDictKeysObject *keys, Py_ssize_t i, Py_ssize_t ix,
+             Py_hash_t hash)
+{
+    dk_set_index(keys, i, ix);
+    if (DK_HAS_TAGS(keys)) {
+        keys->dk_indices.as_1[i / DK_GROUP_SIZE * DK_GROUP_BYTES(keys)
+                              + i % DK_GROUP_SIZE] = DK_TAG(hash);
+    }
+}
+
+/* Set slot i to DKIX_DUMMY. */
+static inline void
+dk_set_dummy(PyDictKeysObject *keys, Py_ssize_t i)
+{
+    dk_set_index(keys, i, DKIX_DUMMY);
+    if (DK_HAS_TAGS(keys)) {
+        keys->dk_indices.as_1[i / DK_GROUP_SIZE * DK_GROUP_BYTES(keys)
+                              + i % DK_GROUP_SIZE] = DK_TAG_DUMMY;
+    }
+}
+
 #define ENSURE_ALLOWS_DELETIONS(d) \
     if ((d)->ma_keys->dk_lookup == lookdict_unicode_nodummy) { \
         (d)->ma_keys->dk_lookup = lookdict_unicode; \
@@ -533,6 +721,7 @@ static PyDictKeysObject *new_keys_object(Py_ssize_t size)
         dk = PyObject_MALLOC(sizeof(PyDictKeysObject)
                              - Py_MEMBER_SIZE(PyDictKeysObject, dk_indices)
                              + es * size
+                             + (size >= DK_TAGS_MINSIZE ? size : 0)
                              + sizeof(PyDictKeyEntry) * usable);
         if (dk == NULL) {
             PyErr_NoMemory();
@@ -544,7 +733,9 @@ static PyDictKeysObject *new_keys_object(Py_ssize_t size)
     dk->dk_usable = usable;
     dk->dk_lookup = lookdict_unicode_nodummy;
     dk->dk_nentries = 0;
-    memset(&dk->dk_indices.as_1[0], 0xff, es * size);
+    /* The tags are DK_TAG_EMPTY */
+    memset(&dk->dk_indices.as_1[0], 0xff,
+           (es + (size >= DK_TAGS_MINSIZE)) * size);
     memset(DK_ENTRIES(dk), 0, sizeof(PyDictKeyEntry) * usable);
     return dk;
 }
@@ -612,6 +803,7 @@ new_dict_with_shared_keys(PyDictKeysObject *keys)
     for (i = 0; i < size; i++) {
         values[i] = NULL;
     }
+    sharing_stats.created++;
     return new_dict(keys, values);
 }
 
@@ -624,10 +816,149 @@ PyDict_New(void)
     return new_dict(keys, NULL);
 }
 
+/* Versions of the lookup functions for the tables with tag bytes. */
+
+static Py_ssize_t
+lookdict_index_tagged(PyDictKeysObject *k, Py_hash_t hash, Py_ssize_t index)
+{
+    const uint8_t *tags = (const uint8_t *)k->dk_indices.as_1;
+    size_t stride = DK_GROUP_BYTES(k);
+    const uint8_t tag = DK_TAG(hash);
+    size_t gmask = DK_GROUP_MASK(k);
+    size_t perturb = (size_t)hash;
+    size_t g = ((size_t)hash / DK_GROUP_SIZE) & gmask;
+
+    for (;;) {
+        const uint8_t *group = &tags[g * stride];
+        unsigned int match = dk_group_match(group, tag);
+        while (match) {
+            size_t i = g * DK_GROUP_SIZE + dk_first_slot(match);
+            if (dk_get_index(k, i) == index) {
+                return i;
+            }
+            match &= match - 1;
+        }
+        if (dk_group_match(group, DK_TAG_EMPTY)) {
+            return DKIX_EMPTY;
+        }
+        perturb >>= PERTURB_SHIFT;
+        g = (g*5 + perturb + 1) & gmask;
+    }
+    Py_UNREACHABLE();
+}
+
+static Py_ssize_t
+lookdict_tagged(PyDictObject *mp, PyObject *key,
+                Py_hash_t hash, PyObject **value_addr)
+{
+    PyDictKeysObject *dk = mp->ma_keys;
+    PyDictKeyEntry *ep0 = DK_ENTRIES(dk);
+    const uint8_t *tags = (const uint8_t *)dk->dk_indices.as_1;
+    size_t stride = DK_GROUP_BYTES(dk);
+    const uint8_t tag = DK_TAG(hash);
+    size_t gmask = DK_GROUP_MASK(dk);
+    size_t perturb = (size_t)hash;
+    size_t g = ((size_t)hash / DK_GROUP_SIZE) & gmask;
+
+    for (;;) {
+        const uint8_t *group = &tags[g * stride];
+        unsigned int match = dk_group_match(group, tag);
+        while (match) {
+            size_t i = g * DK_GROUP_SIZE + dk_first_slot(match);
+            Py_ssize_t ix = dk_get_index(dk, i);
+            PyDictKeyEntry *ep = &ep0[ix];
+            assert(ix >= 0 && ep->me_key != NULL);
+            if (ep->me_key == key) {
+                *value_addr = ep->me_value;
+                return ix;
+            }
+            if (ep->me_hash == hash) {
+                PyObject *startkey = ep->me_key;
+                Py_INCREF(startkey);
+                int cmp = PyObject_RichCompareBool(startkey, key, Py_EQ);
+                Py_DECREF(startkey);
+                if (cmp < 0) {
+                    *value_addr = NULL;
+                    return DKIX_ERROR;
+                }
+                if (dk == mp->ma_keys && ep->me_key == startkey) {
+                    if (cmp > 0) {
+                        *value_addr = ep->me_value;
+                        return ix;
+                    }
+                }
+                else {
+                    /* The dict was mutated, restart */
+                    return lookdict(mp, key, hash, value_addr);
+                }
+            }
+            match &= match - 1;
+        }
+        if (dk_group_match(group, DK_TAG_EMPTY)) {
+            *value_addr = NULL;
+            return DKIX_EMPTY;
+        }
+        perturb >>= PERTURB_SHIFT;
+        g = (g*5 + perturb + 1) & gmask;
+    }
+    Py_UNREACHABLE();
+}
+
+/* Used by lookdict_unicode(), lookdict_unicode_nodummy() and
+   lookdict_split() for str keys: the tags of the dummy slots never match. */
+static Py_ssize_t
+lookdict_unicode_tagged(PyDictObject *mp, PyObject *key,
+                        Py_hash_t hash, PyObject **value_addr)
+{
+    PyDictKeysObject *dk = mp->ma_keys;
+    PyDictKeyEntry *ep0 = DK_ENTRIES(dk);
+    const uint8_t *tags = (const uint8_t *)dk->dk_indices.as_1;
+    size_t stride = DK_GROUP_BYTES(dk);
+    const uint8_t tag = DK_TAG(hash);
+    size_t gmask = DK_GROUP_MASK(dk);
+    size_t perturb = (size_t)hash;
+    size_t g = ((size_t)hash / DK_GROUP_SIZE) & gmask;
+
+    assert(PyUnicode_CheckExact(key));
+    for (;;) {
+        const uint8_t *group = &tags[g * stride];
+        unsigned int match = dk_group_match(group, tag);
+        while (match) {
+            size_t i = g * DK_GROUP_SIZE + dk_first_slot(match);
+            Py_ssize_t ix = dk_get_index(dk, i);
+            PyDictKeyEntry *ep = &ep0[ix];
+            assert(ix >= 0 && ep->me_key != NULL);
+            assert(PyUnicode_CheckExact(ep->me_key));
+            if (ep->me_key == key ||
+                    (ep->me_hash == hash && unicode_eq(ep->me_key, key))) {
+                if (mp->ma_values != NULL) {
+                    *value_addr = mp->ma_values[ix];
+                }
+                else {
+                    *value_addr = ep->me_value;
+                }
+                return ix;
+            }
+            match &= match - 1;
+        }
+        if (dk_group_match(group, DK_TAG_EMPTY)) {
+            *value_addr = NULL;
+            return DKIX_EMPTY;
+        }
+        perturb >>= PERTURB_SHIFT;
+        g = (g*5 + perturb + 1) & gmask;
+    }
+    Py_UNREACHABLE();
+}
+
 /* Search index of hash table from offset of entry table */
 static Py_ssize_t
 lookdict_index(PyDictKeysObject *k, Py_hash_t hash, Py_ssize_t index)
 {
+    if (DK_HAS_TAGS(k)) {
+        return lookdict_index_tagged(k, hash, index);
+    }
+
     size_t mask = DK_MASK(k);
     size_t perturb = (size_t)hash;
     size_t i = (size_t)hash & mask;
@@ -680,6 +1011,9 @@ lookdict(PyDictObject *mp, PyObject *key,
 
 top:
     dk = mp->ma_keys;
+    if (DK_HAS_TAGS(dk)) {
+        return lookdict_tagged(mp, key, hash, value_addr);
+    }
     ep0 = DK_ENTRIES(dk);
     mask = DK_MASK(dk);
     perturb = hash;
@@ -739,6 +1073,9 @@ lookdict_unicode(PyDictObject *mp, PyObject *key,
         mp->ma_keys->dk_lookup = lookdict;
         return lookdict(mp, key, hash, value_addr);
     }
+    if (DK_HAS_TAGS(mp->ma_keys)) {
+        return lookdict_unicode_tagged(mp, key, hash, value_addr);
+    }
 
     PyDictKeyEntry *ep0 = DK_ENTRIES(mp->ma_keys);
     size_t mask = DK_MASK(mp->ma_keys);
@@ -782,6 +1119,9 @@ lookdict_unicode_nodummy(PyDictObject *mp, PyObject *key,
         mp->ma_keys->dk_lookup = lookdict;
         return lookdict(mp, key, hash, value_addr);
     }
+    if (DK_HAS_TAGS(mp->ma_keys)) {
+        return lookdict_unicode_tagged(mp, key, hash, value_addr);
+    }
 
     PyDictKeyEntry *ep0 = DK_ENTRIES(mp->ma_keys);
     size_t mask = DK_MASK(mp->ma_keys);
@@ -827,6 +1167,9 @@ lookdict_split(PyDictObject *mp, PyObject *key,
         }
         return ix;
     }
+    if (DK_HAS_TAGS(mp->ma_keys)) {
+        return lookdict_unicode_tagged(mp, key, hash, value_addr);
+    }
 
     PyDictKeyEntry *ep0 = DK_ENTRIES(mp->ma_keys);
     size_t mask = DK_MASK(mp->ma_keys);
@@ -924,6 +1267,20 @@ find_empty_slot(PyDictKeysObject *keys, Py_hash_t hash)
 {
     assert(keys != NULL);
 
+    if (DK_HAS_TAGS(keys)) {
+        const uint8_t *tags = (const uint8_t *)keys->dk_indices.as_1;
+        size_t stride = DK_GROUP_BYTES(keys);
+        size_t gmask = DK_GROUP_MASK(keys);
+        size_t perturb = (size_t)hash;
+        size_t g = ((size_t)hash / DK_GROUP_SIZE) & gmask;
+        unsigned int free;
+        while (!(free = dk_group_free(&tags[g * stride]))) {
+            perturb >>= PERTURB_SHIFT;
+            g = (g*5 + perturb + 1) & gmask;
+        }
+        return g * DK_GROUP_SIZE + dk_first_slot(free);
+    }
+
     const size_t mask = DK_MASK(keys);
     size_t i = hash & mask;
     Py_ssize_t ix = dk_get_index(keys, i);
@@ -955,6 +1312,7 @@ insertdict(PyDictObject *mp, PyObject *key, Py_hash_t hash, PyObject *value)
     Py_INCREF(key);
     Py_INCREF(value);
     if (mp->ma_values != NULL && !PyUnicode_CheckExact(key)) {
+        COUNT_UNSHARE(mp, UNSHARE_NON_STR);
         if (insertion_resize(mp) < 0)
             goto Fail;
     }
@@ -972,6 +1330,7 @@ insertdict(PyDictObject *mp, PyObject *key, Py_hash_t hash, PyObject *value)
     if (_PyDict_HasSplitTable(mp) &&
         ((ix >= 0 && old_value == NULL && mp->ma_used != ix) ||
          (ix == DKIX_EMPTY && mp->ma_used != mp->ma_keys->dk_nentries))) {
+        sharing_stats.reasons[UNSHARE_ORDER]++;
         if (insertion_resize(mp) < 0)
             goto Fail;
         ix = DKIX_EMPTY;
@@ -982,12 +1341,13 @@ insertdict(PyDictObject *mp, PyObject *key, Py_hash_t hash, PyObject *value)
         assert(old_value == NULL);
         if (mp->ma_keys->dk_usable <= 0) {
             /* Need to resize. */
+            COUNT_UNSHARE(mp, UNSHARE_FULL);
             if (insertion_resize(mp) < 0)
                 goto Fail;
         }
         Py_ssize_t hashpos = find_empty_slot(mp->ma_keys, hash);
         ep = &DK_ENTRIES(mp->ma_keys)[mp->ma_keys->dk_nentries];
-        dk_set_index(mp->ma_keys, hashpos, mp->ma_keys->dk_nentries);
+        dk_set_entry(mp->ma_keys, hashpos, mp->ma_keys->dk_nentries, hash);
         ep->me_key = key;
         ep->me_hash = hash;
         if (mp->ma_values) {
@@ -1038,6 +1398,13 @@ static void
 build_indices(PyDictKeysObject *keys, PyDictKeyEntry *ep, Py_ssize_t n)
 {
     size_t mask = (size_t)DK_SIZE(keys) - 1;
+    if (DK_HAS_TAGS(keys)) {
+        for (Py_ssize_t ix = 0; ix != n; ix++, ep++) {
+            Py_ssize_t i = find_empty_slot(keys, ep->me_hash);
+            dk_set_entry(keys, i, ix, ep->me_hash);
+        }
+        return;
+    }
     for (Py_ssize_t ix = 0; ix != n; ix++, ep++) {
         Py_hash_t hash = ep->me_hash;
         size_t i = hash & mask;
@@ -1104,6 +1471,7 @@ dictresize(PyDictObject *mp, Py_ssize_t minsize)
          * We must incref keys; we can transfer values.
          * Note that values of split table is always dense.
          */
+        sharing_stats.unshared++;
         for (Py_ssize_t i = 0; i < numentries; i++) {
             assert(oldvalues[i] != NULL);
             PyDictKeyEntry *ep = &oldentries[i];
@@ -1223,6 +1591,74 @@ _PyDict_NewPresized(Py_ssize_t minused)
     return new_dict(new_keys, NULL);
 }
 
+/* Number of items of a length hint trusted before inserting any */
+#define DICT_PRESIZE_SAMPLE 1024
+
+/* Grow an exact dict ahead of inserting `hint` more keys.  If the table
+ * can't be allocated, carry on without presizing.  Returns 1 if the table
+ * was grown, 0 if not, -1 on error.
+ */
+static int
+dict_grow_for(PyDictObject *mp, Py_ssize_t hint)
+{
+    if (hint <= 0 || mp->ma_values != NULL ||
+            mp->ma_keys->dk_usable >= hint ||
+            hint > (PY_SSIZE_T_MAX / 3 - mp->ma_used))
+        return 0;
+    if (dictresize(mp, ESTIMATE_SIZE(mp->ma_used + hint))) {
+        if (!PyErr_ExceptionMatches(PyExc_MemoryError))
+            return -1;
+        PyErr_Clear();
+        return 0;
+    }
+    return 1;
+}
+
+/* Presize an exact dict for the items announced by a length hint, to
+ * spare the resizes of building it from an iterator.  A hint counts
+ * repeated keys too, so it is trusted in two steps, which bounds the
+ * table to about the number of keys when they repeat evenly:
+ *
+ * - dict_presize() grows the table for at most DICT_PRESIZE_SAMPLE items
+ *   before any is inserted;
+ * - once DICT_PRESIZE_SAMPLE items were inserted, dict_presize_rest()
+ *   grows it for the rest of the hint, scaled by the fraction of these
+ *   items which added a key.
+ *
+ * So a dict of distinct keys is resized at most twice, and one built
+ * from a few repeated keys stays small.  Both return 1 if the table was
+ * grown, 0 if not, -1 on error.
+ */
+static int
+dict_presize(PyDictObject *mp, Py_ssize_t hint)
+{
+    return dict_grow_for(mp, Py_MIN(hint, DICT_PRESIZE_SAMPLE));
+}
+
+static int
+dict_presize_rest(PyDictObject *mp, Py_ssize_t hint, Py_ssize_t added)
+{
+    Py_ssize_t rest = hint - DICT_PRESIZE_SAMPLE;
+
+    if (rest <= 0)
+        return 0;
+    /* rest * added / DICT_PRESIZE_SAMPLE, without overflow */
+    rest = (rest / DICT_PRESIZE_SAMPLE * added
+            + rest % DICT_PRESIZE_SAMPLE * added / DICT_PRESIZE_SAMPLE);
+    return dict_grow_for(mp, rest);
+}
+
+/* Undo dict_presize() when the hint turned out far too large, typically
+   because the iterable repeated keys. */
+static int
+dict_trim_presized(PyDictObject *mp)
+{
+    if (mp->ma_keys->dk_size > PyDict_MINSIZE &&
+            mp->ma_used * 8 < mp->ma_keys->dk_size)
+        return dictresize(mp, ESTIMATE_SIZE(mp->ma_used));
+    return 0;
+}
+
 /* Note that, for historical reasons, PyDict_GetItem() suppresses all errors
  * that may occur (originally dicts supported only string keys, and exceptions
  * weren't possible).  So, while the original intent was that a NULL return
@@ -1380,6 +1816,55 @@ _PyDict_LoadGlobal(PyDictObject *globals, PyDictObject *builtins, PyObject *key)
     return value;
 }
 
+/* Lookup a string key, trying first the entry at index 'hint'.
+ *
+ * Used by the LOAD_ATTR opcode cache: the index of an attribute in the
+ * instance dictionaries of a given type rarely changes, and checking the
+ * entry at that index avoids probing the hash table.
+ *
+ * Return the index of the entry and set *value if the key exists.  Return
+ * DKIX_EMPTY and set *value to NULL if it doesn't.
+ */
+Py_ssize_t
+_PyDict_GetItemHint(PyDictObject *mp, PyObject *key,
+                    Py_ssize_t hint, PyObject **value)
+{
+    Py_hash_t hash;
+
+    assert(*value == NULL);
+    assert(PyDict_CheckExact((PyObject*)mp));
+    assert(PyUnicode_CheckExact(key));
+
+    if (hint >= 0 && hint < mp->ma_keys->dk_nentries) {
+        PyObject *res = NULL;
+
+        PyDictKeyEntry *ep = DK_ENTRIES(mp->ma_keys) + (size_t)hint;
+        if (ep->me_key == key) {
+            if (mp->ma_keys->dk_lookup == lookdict_split) {
+                assert(mp->ma_values != NULL);
+                res = mp->ma_values[(size_t)hint];
+            }
+            else {
+                res = ep->me_value;
+            }
+            if (res != NULL) {
+                *value = res;
+                return hint;
+            }
+        }
+    }
+
+    hash = ((PyASCIIObject *) key)->hash;
+    if (hash == -1) {
+        hash = PyObject_Hash(key);
+        if (hash == -1) {
+            return DKIX_ERROR;
+        }
+    }
+
+    return (mp->ma_keys->dk_lookup)(mp, key, hash, value);
+}
+
 /* CAUTION: PyDict_SetItem() must guarantee that it won't resize the
  * dictionary if it's merely replacing the value for an existing key.
  * This means that it's safe to loop over a dictionary with PyDict_Next()
@@ -1442,7 +1927,7 @@ delitem_common(PyDictObject *mp, Py_hash_t hash, Py_ssize_t ix,
     mp->ma_used--;
     mp->ma_version_tag = DICT_NEXT_VERSION();
     ep = &DK_ENTRIES(mp->ma_keys)[ix];
-    dk_set_index(mp->ma_keys, hashpos, DKIX_DUMMY);
+    dk_set_dummy(mp->ma_keys, hashpos);
     ENSURE_ALLOWS_DELETIONS(mp);
     old_key = ep->me_key;
     ep->me_key = NULL;
@@ -1493,6 +1978,7 @@ _PyDict_DelItem_KnownHash(PyObject *op, PyObject *key, Py_hash_t hash)
 
     // Split table doesn't allow deletion.  Combine it.
     if (_PyDict_HasSplitTable(mp)) {
+        sharing_stats.reasons[UNSHARE_DELETION]++;
         if (dictresize(mp, DK_SIZE(mp->ma_keys))) {
             return -1;
         }
@@ -1536,6 +2022,7 @@ _PyDict_DelItemIf(PyObject *op, PyObject *key,
 
     // Split table doesn't allow deletion.  Combine it.
     if (_PyDict_HasSplitTable(mp)) {
+        sharing_stats.reasons[UNSHARE_DELETION]++;
         if (dictresize(mp, DK_SIZE(mp->ma_keys))) {
             return -1;
         }
@@ -1700,6 +2187,7 @@ _PyDict_Pop_KnownHash(PyObject *dict, PyObject *key, Py_hash_t hash, PyObject *d
 
     // Split table doesn't allow deletion.  Combine it.
     if (_PyDict_HasSplitTable(mp)) {
+        sharing_stats.reasons[UNSHARE_DELETION]++;
         if (dictresize(mp, DK_SIZE(mp->ma_keys))) {
             return NULL;
         }
@@ -1712,7 +2200,7 @@ _PyDict_Pop_KnownHash(PyObject *dict, PyObject *key, Py_hash_t hash, PyObject *d
     assert(old_value != NULL);
     mp->ma_used--;
     mp->ma_version_tag = DICT_NEXT_VERSION();
-    dk_set_index(mp->ma_keys, hashpos, DKIX_DUMMY);
+    dk_set_dummy(mp->ma_keys, hashpos);
     ep = &DK_ENTRIES(mp->ma_keys)[ix];
     ENSURE_ALLOWS_DELETIONS(mp);
     old_key = ep->me_key;
@@ -1753,7 +2241,8 @@ _PyDict_FromKeys(PyObject *cls, PyObject *iterable, PyObject *value)
     PyObject *it;       /* iter(iterable) */
     PyObject *key;
     PyObject *d;
-    int status;
+    Py_ssize_t hint;
+    int status, presized = 0;
 
     d = _PyObject_CallNoArg(cls);
     if (d == NULL)
@@ -1808,11 +2297,26 @@ _PyDict_FromKeys(PyObject *cls, PyObject *iterable, PyObject *value)
     }
 
     if (PyDict_CheckExact(d)) {
+        PyDictObject *mp = (PyDictObject *)d;
+        Py_ssize_t i = 0, used = mp->ma_used;
+
+        hint = PyObject_LengthHint(iterable, 0);
+        if (hint < 0)
+            goto Fail;
+        presized = dict_presize(mp, hint);
+        if (presized < 0)
+            goto Fail;
         while ((key = PyIter_Next(it)) != NULL) {
             status = PyDict_SetItem(d, key, value);
             Py_DECREF(key);
             if (status < 0)
                 goto Fail;
+            if (++i == DICT_PRESIZE_SAMPLE) {
+                status = dict_presize_rest(mp, hint, mp->ma_used - used);
+                if (status < 0)
+                    goto Fail;
+                presized |= status;
+            }
         }
     } else {
         while ((key = PyIter_Next(it)) != NULL) {
@@ -1825,6 +2329,8 @@ _PyDict_FromKeys(PyObject *cls, PyObject *iterable, PyObject *value)
 
     if (PyErr_Occurred())
         goto Fail;
+    if (presized && dict_trim_presized((PyDictObject *)d) < 0)
+        goto Fail;
     Py_DECREF(it);
     return d;
 
@@ -2176,6 +2682,23 @@ dict_fromkeys_impl(PyTypeObject *type, PyObject *iterable, PyObject *value)
     return _PyDict_FromKeys((PyObject *)type, iterable, value);
 }
 
+/* Merge the mapping or the iterable of pairs arg into self */
+static int
+dict_update_arg(PyObject *self, PyObject *arg)
+{
+    _Py_IDENTIFIER(keys);
+    PyObject *func = _PyObject_GetAttrId(arg, &PyId_keys);
+    if (func != NULL) {
+        Py_DECREF(func);
+        return PyDict_Merge(self, arg, 1);
+    }
+    else if (PyErr_ExceptionMatches(PyExc_AttributeError)) {
+        PyErr_Clear();
+        return PyDict_MergeFromSeq2(self, arg, 1);
+    }
+    return -1;
+}
+
 static int
 dict_update_common(PyObject *self, PyObject *args, PyObject *kwds,
                    const char *methname)
@@ -2187,19 +2710,7 @@ dict_update_common(PyObject *self, PyObject *args, PyObject *kwds,
         result = -1;
     }
     else if (arg != NULL) {
-        _Py_IDENTIFIER(keys);
-        PyObject *func = _PyObject_GetAttrId(arg, &PyId_keys);
-        if (func != NULL) {
-            Py_DECREF(func);
-            result = PyDict_Merge(self, arg, 1);
-        }
-        else if (PyErr_ExceptionMatches(PyExc_AttributeError)) {
-            PyErr_Clear();
-            result = PyDict_MergeFromSeq2(self, arg, 1);
-        }
-        else {
-            result = -1;
-        }
+        result = dict_update_arg(self, arg);
     }
 
     if (result == 0 && kwds != NULL) {
@@ -2239,6 +2750,8 @@ PyDict_MergeFromSeq2(PyObject *d, PyObject *seq2, int override)
     Py_ssize_t i;       /* index into seq2 of current element */
     PyObject *item;     /* seq2[i] */
     PyObject *fast;     /* item as a 2-tuple or 2-list */
+    Py_ssize_t hint = 0, used = 0;
+    int presized = 0;
 
     assert(d != NULL);
     assert(PyDict_Check(d));
@@ -2248,6 +2761,20 @@ PyDict_MergeFromSeq2(PyObject *d, PyObject *seq2, int override)
     if (it == NULL)
         return -1;
 
+    if (PyDict_CheckExact(d)) {
+        hint = PyObject_LengthHint(seq2, 0);
+        if (hint < 0) {
+            Py_DECREF(it);
+            return -1;
+        }
+        used = ((PyDictObject *)d)->ma_used;
+        presized = dict_presize((PyDictObject *)d, hint);
+        if (presized < 0) {
+            Py_DECREF(it);
+            return -1;
+        }
+    }
+
     for (i = 0; ; ++i) {
         PyObject *key, *value;
         Py_ssize_t n;
@@ -2296,8 +2823,20 @@ PyDict_MergeFromSeq2(PyObject *d, PyObject *seq2, int override)
         Py_DECREF(value);
         Py_DECREF(fast);
         Py_DECREF(item);
+
+        if (i + 1 == DICT_PRESIZE_SAMPLE && PyDict_CheckExact(d)) {
+            PyDictObject *mp = (PyDictObject *)d;
+            int status = dict_presize_rest(mp, hint, mp->ma_used - used);
+            if (status < 0) {
+                item = fast = NULL;
+                goto Fail;
+            }
+            presized |= status;
+        }
     }
 
+    if (presized && dict_trim_presized((PyDictObject *)d) < 0)
+        goto Fail;
     i = 0;
     assert(_PyDict_CheckConsistency((PyDictObject *)d));
     goto Return;
@@ -2716,6 +3255,7 @@ PyDict_SetDefault(PyObject *d, PyObject *key, PyObject *defaultobj)
     }
 
     if (mp->ma_values != NULL && !PyUnicode_CheckExact(key)) {
+        COUNT_UNSHARE(mp, UNSHARE_NON_STR);
         if (insertion_resize(mp) < 0)
             return NULL;
     }
@@ -2727,6 +3267,7 @@ PyDict_SetDefault(PyObject *d, PyObject *key, PyObject *defaultobj)
     if (_PyDict_HasSplitTable(mp) &&
         ((ix >= 0 && value == NULL && mp->ma_used != ix) ||
          (ix == DKIX_EMPTY && mp->ma_used != mp->ma_keys->dk_nentries))) {
+        sharing_stats.reasons[UNSHARE_ORDER]++;
         if (insertion_resize(mp) < 0) {
             return NULL;
         }
@@ -2737,6 +3278,7 @@ PyDict_SetDefault(PyObject *d, PyObject *key, PyObject *defaultobj)
         PyDictKeyEntry *ep, *ep0;
         value = defaultobj;
         if (mp->ma_keys->dk_usable <= 0) {
+            COUNT_UNSHARE(mp, UNSHARE_FULL);
             if (insertion_resize(mp) < 0) {
                 return NULL;
             }
@@ -2744,7 +3286,7 @@ PyDict_SetDefault(PyObject *d, PyObject *key, PyObject *defaultobj)
         Py_ssize_t hashpos = find_empty_slot(mp->ma_keys, hash);
         ep0 = DK_ENTRIES(mp->ma_keys);
         ep = &ep0[mp->ma_keys->dk_nentries];
-        dk_set_index(mp->ma_keys, hashpos, mp->ma_keys->dk_nentries);
+        dk_set_entry(mp->ma_keys, hashpos, mp->ma_keys->dk_nentries, hash);
         Py_INCREF(key);
         Py_INCREF(value);
         MAINTAIN_TRACKING(mp, key, value);
@@ -2847,6 +3389,7 @@ dict_popitem(PyDictObject *mp)
     }
     /* Convert split table to combined table */
     if (mp->ma_keys->dk_lookup == lookdict_split) {
+        sharing_stats.reasons[UNSHARE_DELETION]++;
         if (dictresize(mp, DK_SIZE(mp->ma_keys))) {
             Py_DECREF(res);
             return NULL;
@@ -2866,7 +3409,7 @@ dict_popitem(PyDictObject *mp)
     j = lookdict_index(mp->ma_keys, ep->me_hash, i);
     assert(j >= 0);
     assert(dk_get_index(mp->ma_keys, j) == i);
-    dk_set_index(mp->ma_keys, j, DKIX_DUMMY);
+    dk_set_dummy(mp->ma_keys, j);
 
     PyTuple_SET_ITEM(res, 0, ep->me_key);
     PyTuple_SET_ITEM(res, 1, ep->me_value);
@@ -2936,7 +3479,7 @@ _PyDict_SizeOf(PyDictObject *mp)
     if (mp->ma_keys->dk_refcnt == 1)
         res += (sizeof(PyDictKeysObject)
                 - Py_MEMBER_SIZE(PyDictKeysObject, dk_indices)
-                + DK_IXSIZE(mp->ma_keys) * size
+                + (DK_IXSIZE(mp->ma_keys) + DK_HAS_TAGS(mp->ma_keys)) * size
                 + sizeof(PyDictKeyEntry) * usable);
     return res;
 }
@@ -2946,7 +3489,7 @@ _PyDict_KeysSize(PyDictKeysObject *keys)
 {
     return (sizeof(PyDictKeysObject)
             - Py_MEMBER_SIZE(PyDictKeysObject, dk_indices)
-            + DK_IXSIZE(keys) * DK_SIZE(keys)
+            + (DK_IXSIZE(keys) + DK_HAS_TAGS(keys)) * DK_SIZE(keys)
             + USABLE_FRACTION(DK_SIZE(keys)) * sizeof(PyDictKeyEntry));
 }
 
@@ -3103,6 +3646,44 @@ dict_init(PyObject *self, PyObject *args, PyObject *kwds)
     return dict_update_common(self, args, kwds, "dict");
 }
 
+/* Call dict() without a tuple and a dict of the arguments */
+static PyObject *
+dict_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+                PyObject *kwnames)
+{
+    PyObject *self;
+    Py_ssize_t i, nkwargs;
+
+    assert(type == (PyObject *)&PyDict_Type);
+    nkwargs = (kwnames == NULL) ? 0 : PyTuple_GET_SIZE(kwnames);
+    if (nargs > 1) {
+        return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+    }
+    for (i = 0; i < nkwargs; i++) {
+        if (!PyUnicode_Check(PyTuple_GET_ITEM(kwnames, i))) {
+            return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+        }
+    }
+
+    self = dict_new(&PyDict_Type, NULL, NULL);
+    if (self == NULL)
+        return NULL;
+    if (nargs == 1) {
+        if (dict_update_arg(self, args[0]) < 0) {
+            Py_DECREF(self);
+            return NULL;
+        }
+    }
+    for (i = 0; i < nkwargs; i++) {
+        if (PyDict_SetItem(self, PyTuple_GET_ITEM(kwnames, i),
+                           args[nargs + i]) < 0) {
+            Py_DECREF(self);
+            return NULL;
+        }
+    }
+    return self;
+}
+
 static PyObject *
 dict_iter(PyDictObject *dict)
 {
@@ -3161,6 +3742,17 @@ PyTypeObject PyDict_Type = {
     PyType_GenericAlloc,                        /* tp_alloc */
     dict_new,                                   /* tp_new */
     PyObject_GC_Del,                            /* tp_free */
+    0,                                          /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    0,                                          /* tp_vectorcall_offset */
+    dict_vectorcall,                            /* tp_vectorcall */
 };
 
 PyObject *
@@ -4214,6 +4806,117 @@ PyObject_GenericGetDict(PyObject *obj, void *context)
     return dict;
 }
 
+/* Return the slot of the heap type tp holding keys, or NULL if the
+   instances of tp don't share keys. */
+static PyDictKeysObject **
+shared_keys_slot(PyTypeObject *tp, PyDictKeysObject *keys)
+{
+    PyHeapTypeObject *et = (PyHeapTypeObject *)tp;
+    int i;
+
+    if (et->ht_cached_keys == keys) {
+        return &et->ht_cached_keys;
+    }
+    for (i = 0; i < _PyHeapType_KEYS_VARIANTS; i++) {
+        if (et->ht_keys_variants[i] == keys) {
+            return &et->ht_keys_variants[i];
+        }
+    }
+    return NULL;
+}
+
+/* Return 1 if inserting key into the split table mp would convert it to a
+ * combined table, because key comes out of the order of the shared keys, or
+ * they are full.  The shared keys can't contain key after the position of
+ * the next value, if key was already set. */
+static int
+split_insert_diverges(PyDictObject *mp, PyObject *key)
+{
+    PyDictKeysObject *keys = mp->ma_keys;
+    PyObject *value;
+    Py_hash_t hash;
+    Py_ssize_t ix;
+
+    if (mp->ma_used < keys->dk_nentries) {
+        if (DK_ENTRIES(keys)[mp->ma_used].me_key == key) {
+            return 0;
+        }
+    }
+    else if (keys->dk_usable > 0) {
+        return 0;
+    }
+    hash = ((PyASCIIObject *)key)->hash;
+    if (hash == -1) {
+        hash = PyUnicode_Type.tp_hash(key);
+        if (hash == -1) {
+            PyErr_Clear();
+            return 0;
+        }
+    }
+    ix = lookdict_split(mp, key, hash, &value);
+    return (ix == DKIX_EMPTY || (ix >= 0 && value == NULL &&
+                                 ix != mp->ma_used));
+}
+
+/* Make the split table mp use another key order shared by the instances of
+ * tp, in which the keys already set come first, in the same order, followed
+ * by key or by room for it.  Return 1 if mp was changed, 0 otherwise. */
+static int
+switch_keys_variant(PyTypeObject *tp, PyDictObject *mp, PyObject *key)
+{
+    PyHeapTypeObject *et = (PyHeapTypeObject *)tp;
+    PyDictKeysObject *oldkeys = mp->ma_keys;
+    PyDictKeyEntry *oldentries = DK_ENTRIES(oldkeys);
+    Py_ssize_t n = mp->ma_used;
+    Py_ssize_t i, size, oldsize;
+    int j;
+
+    for (j = -1; j < _PyHeapType_KEYS_VARIANTS; j++) {
+        PyDictKeysObject *keys = (j < 0 ? et->ht_cached_keys :
+                                  et->ht_keys_variants[j]);
+        PyDictKeyEntry *entries;
+
+        if (keys == NULL || keys == oldkeys || keys->dk_nentries < n) {
+            continue;
+        }
+        entries = DK_ENTRIES(keys);
+        if (keys->dk_nentries > n) {
+            if (entries[n].me_key != key)
+                continue;
+        }
+        else if (keys->dk_usable <= 0) {
+            continue;
+        }
+        for (i = 0; i < n; i++) {
+            if (entries[i].me_key != oldentries[i].me_key)
+                break;
+        }
+        if (i < n) {
+            continue;
+        }
+
+        size = USABLE_FRACTION(DK_SIZE(keys));
+        oldsize = USABLE_FRACTION(DK_SIZE(oldkeys));
+        if (size > oldsize) {
+            PyObject **values = PyMem_RESIZE(mp->ma_values, PyObject *, size);
+            if (values == NULL) {
+                /* mp->ma_values is left unchanged */
+                return 0;
+            }
+            for (i = oldsize; i < size; i++) {
+                values[i] = NULL;
+            }
+            mp->ma_values = values;
+        }
+        DK_INCREF(keys);
+        mp->ma_keys = keys;
+        DK_DECREF(oldkeys);
+        sharing_stats.variant_switches++;
+        return 1;
+    }
+    return 0;
+}
+
 int
 _PyObjectDict_SetItem(PyTypeObject *tp, PyObject **dictptr,
                       PyObject *key, PyObject *value)
@@ -4234,20 +4937,27 @@ _PyObjectDict_SetItem(PyTypeObject *tp, PyObject **dictptr,
             *dictptr = dict;
         }
         if (value == NULL) {
-            res = PyDict_DelItem(dict, key);
             // Since key sharing dict doesn't allow deletion, PyDict_DelItem()
-            // always converts dict to combined form.
-            if ((cached = CACHED_KEYS(tp)) != NULL) {
-                CACHED_KEYS(tp) = NULL;
-                DK_DECREF(cached);
-            }
+            // always converts dict to combined form.  The type still shares
+            // its keys with the other instances.
+            res = PyDict_DelItem(dict, key);
         }
         else {
-            int was_shared = (cached == ((PyDictObject *)dict)->ma_keys);
+            PyDictObject *mp = (PyDictObject *)dict;
+            PyDictKeysObject **slot = NULL;
+            int diverges = 0;
+            if (PyDict_CheckExact(dict) && _PyDict_HasSplitTable(mp)) {
+                slot = shared_keys_slot(tp, mp->ma_keys);
+            }
+            if (slot != NULL && PyUnicode_CheckExact(key) &&
+                    split_insert_diverges(mp, key)) {
+                /* Try the other key orders before giving up sharing */
+                diverges = !switch_keys_variant(tp, mp, key);
+                slot = shared_keys_slot(tp, mp->ma_keys);
+            }
             res = PyDict_SetItem(dict, key, value);
-            if (was_shared &&
-                    (cached = CACHED_KEYS(tp)) != NULL &&
-                    cached != ((PyDictObject *)dict)->ma_keys) {
+            if (slot != NULL && (cached = *slot) != NULL &&
+                    cached != mp->ma_keys) {
                 /* PyDict_SetItem() may call dictresize and convert split table
                  * into combined table.  In such case, convert it to split
                  * table again and update type's shared key only when this is
@@ -4261,16 +4971,35 @@ _PyObjectDict_SetItem(PyTypeObject *tp, PyObject **dictptr,
                  *             self.a, self.b, self.c = 1, 2, 3
                  *             self.d, self.e, self.f = 4, 5, 6
                  *     a = C()
+                 *
+                 * Otherwise, the key order of this dict becomes a new variant
+                 * shared by the next instances following it, if the type
+                 * has room for one.
                  */
                 if (cached->dk_refcnt == 1) {
-                    CACHED_KEYS(tp) = make_keys_shared(dict);
+                    *slot = make_keys_shared(dict);
+                    DK_DECREF(cached);
+                    if (*slot == NULL && PyErr_Occurred())
+                        return -1;
                 }
-                else {
-                    CACHED_KEYS(tp) = NULL;
+                else if (diverges || mp->ma_keys->dk_nentries > cached->dk_nentries) {
+                    PyHeapTypeObject *et = (PyHeapTypeObject *)tp;
+                    int i;
+                    for (i = 0; i < _PyHeapType_KEYS_VARIANTS; i++) {
+                        if (et->ht_keys_variants[i] == NULL)
+                            break;
+                    }
+                    if (i < _PyHeapType_KEYS_VARIANTS) {
+                        et->ht_keys_variants[i] = make_keys_shared(dict);
+                        if (et->ht_keys_variants[i] == NULL) {
+                            if (PyErr_Occurred())
+                                return -1;
+                        }
+                        else {
+                            sharing_stats.variants_created++;
+                        }
+                    }
                 }
-                DK_DECREF(cached);
-                if (CACHED_KEYS(tp) == NULL && PyErr_Occurred())
-                    return -1;
             }
         }
     } else {
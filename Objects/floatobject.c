@@ -1629,6 +1629,19 @@ float_new_impl(PyTypeObject *type, PyObject *x)
     return PyNumber_Float(x);
 }
 
+/* Call float() without a tuple of the arguments */
+static PyObject *
+float_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+                 PyObject *kwnames)
+{
+    assert(type == (PyObject *)&PyFloat_Type);
+    if (kwnames == NULL && nargs <= 1) {
+        return float_new_impl(&PyFloat_Type,
+                              nargs == 1 ? args[0] : _PyLong_Zero);
+    }
+    return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+}
+
 /* Wimpy, slow approach to tp_new calls for subtypes of float:
    first create a regular float from whatever arguments we got,
    then allocate a subtype instance and initialize its ob_fval
@@ -1947,6 +1960,18 @@ PyTypeObject PyFloat_Type = {
     0,                                          /* tp_init */
     0,                                          /* tp_alloc */
     float_new,                                  /* tp_new */
+    0,                                          /* tp_free */
+    0,                                          /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    0,                                          /* tp_vectorcall_offset */
+    float_vectorcall,                           /* tp_vectorcall */
 };
 
 int
@@ -11,19 +11,74 @@
 #define OFF(x) offsetof(PyFrameObject, x)
 
 static PyMemberDef frame_memberlist[] = {
-    {"f_back",          T_OBJECT,       OFF(f_back),      READONLY},
     {"f_code",          T_OBJECT,       OFF(f_code),      READONLY},
     {"f_builtins",      T_OBJECT,       OFF(f_builtins),  READONLY},
     {"f_globals",       T_OBJECT,       OFF(f_globals),   READONLY},
-    {"f_lasti",         T_INT,          OFF(f_lasti),     READONLY},
-    {"f_trace_lines",   T_BOOL,         OFF(f_trace_lines), 0},
-    {"f_trace_opcodes", T_BOOL,         OFF(f_trace_opcodes), 0},
     {NULL}      /* Sentinel */
 };
 
+/* The state of a frame object that stands for a frame on the data stack
+   is in the latter until the call returns: the getters and setters, and
+   the functions of the C API, work on _PyFrame_LIVE(f). */
+
+static PyObject *
+frame_getback(PyFrameObject *f, void *closure)
+{
+    PyFrameObject *back = _PyFrame_LIVE(f)->f_back;
+
+    if (back == NULL)
+        Py_RETURN_NONE;
+    back = _PyFrame_Materialize(back);
+    Py_XINCREF(back);
+    return (PyObject *)back;
+}
+
+static PyObject *
+frame_getlasti(PyFrameObject *f, void *closure)
+{
+    return PyLong_FromLong(_PyFrame_LIVE(f)->f_lasti);
+}
+
+static PyObject *
+frame_gettracelines(PyFrameObject *f, void *closure)
+{
+    return PyBool_FromLong(_PyFrame_LIVE(f)->f_trace_lines);
+}
+
+static int
+frame_settracelines(PyFrameObject *f, PyObject *v, void *closure)
+{
+    if (v == NULL || !PyBool_Check(v)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "attribute value type must be bool");
+        return -1;
+    }
+    _PyFrame_LIVE(f)->f_trace_lines = (v == Py_True);
+    return 0;
+}
+
+static PyObject *
+frame_gettraceopcodes(PyFrameObject *f, void *closure)
+{
+    return PyBool_FromLong(_PyFrame_LIVE(f)->f_trace_opcodes);
+}
+
+static int
+frame_settraceopcodes(PyFrameObject *f, PyObject *v, void *closure)
+{
+    if (v == NULL || !PyBool_Check(v)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "attribute value type must be bool");
+        return -1;
+    }
+    _PyFrame_LIVE(f)->f_trace_opcodes = (v == Py_True);
+    return 0;
+}
+
 static PyObject *
 frame_getlocals(PyFrameObject *f, void *closure)
 {
+    f = _PyFrame_LIVE(f);
     if (PyFrame_FastToLocalsWithError(f) < 0)
         return NULL;
     Py_INCREF(f->f_locals);
@@ -33,6 +88,7 @@ frame_getlocals(PyFrameObject *f, void *closure)
 int
 PyFrame_GetLineNumber(PyFrameObject *f)
 {
+    f = _PyFrame_LIVE(f);
     if (f->f_trace)
         return f->f_lineno;
     else
@@ -87,6 +143,8 @@ frame_setlineno(PyFrameObject *f, PyObject* p_new_lineno)
     int blockstack_top = 0;             /* (ditto) */
     unsigned char setup_op = 0;         /* (ditto) */
 
+    f = _PyFrame_LIVE(f);
+
     /* f_lineno must be an integer. */
     if (!PyLong_CheckExact(p_new_lineno)) {
         PyErr_SetString(PyExc_ValueError,
@@ -331,7 +389,7 @@ frame_setlineno(PyFrameObject *f, PyObject* p_new_lineno)
 static PyObject *
 frame_gettrace(PyFrameObject *f, void *closure)
 {
-    PyObject* trace = f->f_trace;
+    PyObject* trace = _PyFrame_LIVE(f)->f_trace;
 
     if (trace == NULL)
         trace = Py_None;
@@ -344,6 +402,7 @@ frame_gettrace(PyFrameObject *f, void *closure)
 static int
 frame_settrace(PyFrameObject *f, PyObject* v, void *closure)
 {
+    f = _PyFrame_LIVE(f);
     /* We rely on f_lineno being accurate when f_trace is set. */
     f->f_lineno = PyFrame_GetLineNumber(f);
 
@@ -357,10 +416,16 @@ frame_settrace(PyFrameObject *f, PyObject* v, void *closure)
 
 
 static PyGetSetDef frame_getsetlist[] = {
+    {"f_back",          (getter)frame_getback, NULL, NULL},
+    {"f_lasti",         (getter)frame_getlasti, NULL, NULL},
     {"f_locals",        (getter)frame_getlocals, NULL, NULL},
     {"f_lineno",        (getter)frame_getlineno,
                     (setter)frame_setlineno, NULL},
     {"f_trace",         (getter)frame_gettrace, (setter)frame_settrace, NULL},
+    {"f_trace_lines",   (getter)frame_gettracelines,
+                    (setter)frame_settracelines, NULL},
+    {"f_trace_opcodes", (getter)frame_gettraceopcodes,
+                    (setter)frame_settraceopcodes, NULL},
     {0}
 };
 
@@ -417,6 +482,7 @@ frame_dealloc(PyFrameObject *f)
     PyObject **p, **valuestack;
     PyCodeObject *co;
 
+    assert(!f->f_onstack && f->f_stackframe == NULL);
     if (_PyObject_GC_IS_TRACKED(f))
         _PyObject_GC_UNTRACK(f);
 
@@ -513,7 +579,7 @@ frame_tp_clear(PyFrameObject *f)
 static PyObject *
 frame_clear(PyFrameObject *f)
 {
-    if (f->f_executing) {
+    if (_PyFrame_LIVE(f)->f_executing) {
         PyErr_SetString(PyExc_RuntimeError,
                         "cannot clear an executing frame");
         return NULL;
@@ -600,120 +666,129 @@ int _PyFrame_Init()
     return 1;
 }
 
-PyFrameObject* _Py_HOT_FUNCTION
-_PyFrame_New_NoTrack(PyThreadState *tstate, PyCodeObject *code,
-                     PyObject *globals, PyObject *locals)
+/* Return a new reference to the builtins of a new frame whose globals are
+   globals, called from back. */
+static PyObject *
+frame_get_builtins(PyFrameObject *back, PyObject *globals)
 {
-    PyFrameObject *back = tstate->frame;
-    PyFrameObject *f;
     PyObject *builtins;
-    Py_ssize_t i;
 
-#ifdef Py_DEBUG
-    if (code == NULL || globals == NULL || !PyDict_Check(globals) ||
-        (locals != NULL && !PyMapping_Check(locals))) {
-        PyErr_BadInternalCall();
-        return NULL;
-    }
-#endif
-    if (back == NULL || back->f_globals != globals) {
-        builtins = _PyDict_GetItemId(globals, &PyId___builtins__);
-        if (builtins) {
-            if (PyModule_Check(builtins)) {
-                builtins = PyModule_GetDict(builtins);
-                assert(builtins != NULL);
-            }
-        }
-        if (builtins == NULL) {
-            /* No builtins!              Make up a minimal one
-               Give them 'None', at least. */
-            builtins = PyDict_New();
-            if (builtins == NULL ||
-                PyDict_SetItemString(
-                    builtins, "None", Py_None) < 0)
-                return NULL;
-        }
-        else
-            Py_INCREF(builtins);
-
-    }
-    else {
+    if (back != NULL && back->f_globals == globals) {
         /* If we share the globals, we share the builtins.
            Save a lookup and a call. */
         builtins = back->f_builtins;
         assert(builtins != NULL);
         Py_INCREF(builtins);
+        return builtins;
+    }
+    builtins = _PyDict_GetItemId(globals, &PyId___builtins__);
+    if (builtins) {
+        if (PyModule_Check(builtins)) {
+            builtins = PyModule_GetDict(builtins);
+            assert(builtins != NULL);
+        }
+        Py_INCREF(builtins);
+        return builtins;
+    }
+    /* No builtins!              Make up a minimal one
+       Give them 'None', at least. */
+    builtins = PyDict_New();
+    if (builtins == NULL ||
+        PyDict_SetItemString(builtins, "None", Py_None) < 0) {
+        Py_XDECREF(builtins);
+        return NULL;
     }
+    return builtins;
+}
+
+/* Replace *plocals with a new reference to the f_locals of a new frame of
+   code, or with NULL if PyFrame_FastToLocals() is to create it. */
+static int
+frame_get_locals(PyCodeObject *code, PyObject *globals, PyObject **plocals)
+{
+    PyObject *locals = *plocals;
+
+    /* Most functions have CO_NEWLOCALS and CO_OPTIMIZED set. */
+    if ((code->co_flags & (CO_NEWLOCALS | CO_OPTIMIZED)) ==
+        (CO_NEWLOCALS | CO_OPTIMIZED))
+        locals = NULL;
+    else if (code->co_flags & CO_NEWLOCALS) {
+        locals = PyDict_New();
+        if (locals == NULL)
+            return -1;
+    }
+    else {
+        if (locals == NULL)
+            locals = globals;
+        Py_INCREF(locals);
+    }
+    *plocals = locals;
+    return 0;
+}
+
+/* Return a frame object for code, which is in the state of a zombie frame
+   (see above), but with a reference count of 1. */
+static PyFrameObject *
+frame_alloc(PyCodeObject *code)
+{
+    PyFrameObject *f;
+    Py_ssize_t i, extras, ncells, nfrees;
+
     if (code->co_zombieframe != NULL) {
         f = code->co_zombieframe;
         code->co_zombieframe = NULL;
         _Py_NewReference((PyObject *)f);
         assert(f->f_code == code);
+        return f;
+    }
+
+    ncells = PyTuple_GET_SIZE(code->co_cellvars);
+    nfrees = PyTuple_GET_SIZE(code->co_freevars);
+    extras = code->co_stacksize + code->co_nlocals + ncells + nfrees;
+    if (free_list == NULL) {
+        f = PyObject_GC_NewVar(PyFrameObject, &PyFrame_Type, extras);
+        if (f == NULL)
+            return NULL;
     }
     else {
-        Py_ssize_t extras, ncells, nfrees;
-        ncells = PyTuple_GET_SIZE(code->co_cellvars);
-        nfrees = PyTuple_GET_SIZE(code->co_freevars);
-        extras = code->co_stacksize + code->co_nlocals + ncells +
-            nfrees;
-        if (free_list == NULL) {
-            f = PyObject_GC_NewVar(PyFrameObject, &PyFrame_Type,
-            extras);
-            if (f == NULL) {
-                Py_DECREF(builtins);
+        assert(numfree > 0);
+        --numfree;
+        f = free_list;
+        free_list = free_list->f_back;
+        if (Py_SIZE(f) < extras) {
+            PyFrameObject *new_f = PyObject_GC_Resize(PyFrameObject, f, extras);
+            if (new_f == NULL) {
+                PyObject_GC_Del(f);
                 return NULL;
             }
+            f = new_f;
         }
-        else {
-            assert(numfree > 0);
-            --numfree;
-            f = free_list;
-            free_list = free_list->f_back;
-            if (Py_SIZE(f) < extras) {
-                PyFrameObject *new_f = PyObject_GC_Resize(PyFrameObject, f, extras);
-                if (new_f == NULL) {
-                    PyObject_GC_Del(f);
-                    Py_DECREF(builtins);
-                    return NULL;
-                }
-                f = new_f;
-            }
-            _Py_NewReference((PyObject *)f);
-        }
-
-        f->f_code = code;
-        extras = code->co_nlocals + ncells + nfrees;
-        f->f_valuestack = f->f_localsplus + extras;
-        for (i=0; i<extras; i++)
-            f->f_localsplus[i] = NULL;
-        f->f_locals = NULL;
-        f->f_trace = NULL;
+        _Py_NewReference((PyObject *)f);
     }
+
+    f->f_code = code;
+    extras = code->co_nlocals + ncells + nfrees;
+    f->f_valuestack = f->f_localsplus + extras;
+    for (i=0; i<extras; i++)
+        f->f_localsplus[i] = NULL;
+    f->f_locals = NULL;
+    f->f_trace = NULL;
+    return f;
+}
+
+/* Initialize the fields of a new frame f of code which are not set in a
+   zombie frame.  Steal the references to builtins and locals. */
+static void
+frame_init(PyFrameObject *f, PyCodeObject *code, PyObject *globals,
+           PyObject *builtins, PyObject *locals)
+{
+    f->f_back = NULL;
     f->f_stacktop = f->f_valuestack;
     f->f_builtins = builtins;
-    Py_XINCREF(back);
-    f->f_back = back;
     Py_INCREF(code);
     Py_INCREF(globals);
     f->f_globals = globals;
-    /* Most functions have CO_NEWLOCALS and CO_OPTIMIZED set. */
-    if ((code->co_flags & (CO_NEWLOCALS | CO_OPTIMIZED)) ==
-        (CO_NEWLOCALS | CO_OPTIMIZED))
-        ; /* f_locals = NULL; will be set by PyFrame_FastToLocals() */
-    else if (code->co_flags & CO_NEWLOCALS) {
-        locals = PyDict_New();
-        if (locals == NULL) {
-            Py_DECREF(f);
-            return NULL;
-        }
-        f->f_locals = locals;
-    }
-    else {
-        if (locals == NULL)
-            locals = globals;
-        Py_INCREF(locals);
-        f->f_locals = locals;
-    }
+    f->f_locals = locals;
 
     f->f_lasti = -1;
     f->f_lineno = code->co_firstlineno;
@@ -722,7 +797,42 @@ _PyFrame_New_NoTrack(PyThreadState *tstate, PyCodeObject *code,
     f->f_gen = NULL;
     f->f_trace_opcodes = 0;
     f->f_trace_lines = 1;
+    f->f_onstack = 0;
+    f->f_frameobj = NULL;
+    f->f_stackframe = NULL;
+}
 
+/* Create a frame object which is not tracked by the garbage collector and
+   has no f_back: PyFrame_New() links it to the current frame, generators
+   do it each time they run it. */
+PyFrameObject* _Py_HOT_FUNCTION
+_PyFrame_New_NoTrack(PyThreadState *tstate, PyCodeObject *code,
+                     PyObject *globals, PyObject *locals)
+{
+    PyFrameObject *f;
+    PyObject *builtins;
+
+#ifdef Py_DEBUG
+    if (code == NULL || globals == NULL || !PyDict_Check(globals) ||
+        (locals != NULL && !PyMapping_Check(locals))) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+#endif
+    builtins = frame_get_builtins(tstate->frame, globals);
+    if (builtins == NULL)
+        return NULL;
+    if (frame_get_locals(code, globals, &locals) < 0) {
+        Py_DECREF(builtins);
+        return NULL;
+    }
+    f = frame_alloc(code);
+    if (f == NULL) {
+        Py_DECREF(builtins);
+        Py_XDECREF(locals);
+        return NULL;
+    }
+    frame_init(f, code, globals, builtins, locals);
     return f;
 }
 
@@ -730,12 +840,352 @@ PyFrameObject*
 PyFrame_New(PyThreadState *tstate, PyCodeObject *code,
             PyObject *globals, PyObject *locals)
 {
-    PyFrameObject *f = _PyFrame_New_NoTrack(tstate, code, globals, locals);
-    if (f)
+    PyFrameObject *back = tstate->frame;
+    PyFrameObject *f;
+
+    if (back != NULL) {
+        back = _PyFrame_Materialize(back);
+        if (back == NULL)
+            return NULL;
+    }
+    f = _PyFrame_New_NoTrack(tstate, code, globals, locals);
+    if (f) {
+        Py_XINCREF(back);
+        f->f_back = back;
         _PyObject_GC_TRACK(f);
+    }
+    return f;
+}
+
+
+/* Data stack
+
+   Calls and returns are strictly nested, so the frames of most function
+   calls are allocated on a stack of memory per thread rather than as
+   objects of the heap: pushing and popping a frame is a matter of moving
+   a pointer, and the frames of consecutive calls share the same cache
+   lines.  A frame on the stack is preceded by a PyGC_Head which marks it
+   as untracked, and has a reference count of 1 which is never released:
+   it can be passed where a borrowed reference to a frame is expected, but
+   no reference to it may outlive its call.  Its f_back is a borrowed
+   reference.
+
+   When a reference to such a frame is needed -- sys._getframe(),
+   tracebacks, trace functions -- _PyFrame_Materialize() creates a frame
+   object on the heap for it, which the frame on the stack keeps a
+   reference to.  Until the call returns, the frame object forwards to the
+   frame on the stack (see _PyFrame_LIVE()); then _PyFrame_Clear_OnStack()
+   moves the state of the frame into the frame object if the latter is
+   still referenced.
+
+   C code may walk the raw f_back links from a frame object, for example
+   from a frame created by PyFrame_New() while a call on the data stack
+   executes.  So _PyFrame_Materialize() also creates the frame objects of
+   the callers and links them by f_back, and copies f_lasti and f_lineno
+   of the frames into their frame objects.  The callers stay suspended in
+   their calls until the frame returns, so these copies remain valid for
+   them; the frame itself is copied again each time it is materialized.
+
+   The stack is a list of chunks of DATASTACK_CHUNK_SIZE bytes, or more for
+   frames which don't fit in one.  When the stack shrinks, the chunk above
+   the current one is kept, so that calls and returns at the boundary of a
+   chunk don't call malloc() and free() each time.
+*/
+
+#define DATASTACK_CHUNK_SIZE (32 * 1024)
+
+struct _PyDataStackChunk {
+    struct _PyDataStackChunk *previous;
+    struct _PyDataStackChunk *next;     /* spare chunk, or NULL */
+    PyObject **saved_top;               /* top of the previous chunk */
+    size_t size;                        /* number of items of data */
+    PyObject *data[1];
+};
+
+static void *
+datastack_push_chunk(PyThreadState *tstate, size_t n)
+{
+    struct _PyDataStackChunk *current = tstate->datastack_chunk;
+    struct _PyDataStackChunk *chunk = current ? current->next : NULL;
+
+    if (chunk == NULL || chunk->size < n) {
+        size_t size = DATASTACK_CHUNK_SIZE / sizeof(PyObject *);
+
+        if (size < n)
+            size = n;
+        PyMem_Free(chunk);
+        if (current != NULL)
+            current->next = NULL;
+        chunk = PyMem_Malloc(offsetof(struct _PyDataStackChunk, data)
+                             + size * sizeof(PyObject *));
+        if (chunk == NULL) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        chunk->size = size;
+        chunk->next = NULL;
+        if (current != NULL)
+            current->next = chunk;
+    }
+    chunk->previous = current;
+    chunk->saved_top = tstate->datastack_top;
+    tstate->datastack_chunk = chunk;
+    tstate->datastack_top = chunk->data + n;
+    tstate->datastack_limit = chunk->data + chunk->size;
+    return chunk->data;
+}
+
+/* Allocate size bytes on the data stack of tstate. */
+static inline void *
+datastack_push(PyThreadState *tstate, size_t size)
+{
+    PyObject **top = tstate->datastack_top;
+    size_t n = (size + sizeof(PyObject *) - 1) / sizeof(PyObject *);
+
+    if (top != NULL && (size_t)(tstate->datastack_limit - top) >= n) {
+        tstate->datastack_top = top + n;
+        return top;
+    }
+    return datastack_push_chunk(tstate, n);
+}
+
+/* Free the block at p, the last one allocated on the data stack of
+   tstate, and the blocks allocated after it. */
+static inline void
+datastack_pop(PyThreadState *tstate, void *p)
+{
+    struct _PyDataStackChunk *chunk = tstate->datastack_chunk;
+
+    if ((PyObject **)p == chunk->data && chunk->previous != NULL) {
+        /* Keep the chunk as the spare of the previous one, and free its
+           own spare. */
+        PyMem_Free(chunk->next);
+        chunk->next = NULL;
+        tstate->datastack_chunk = chunk->previous;
+        tstate->datastack_top = chunk->saved_top;
+        tstate->datastack_limit = (chunk->previous->data
+                                   + chunk->previous->size);
+        return;
+    }
+    tstate->datastack_top = (PyObject **)p;
+}
+
+/* Clear the frames of tstate and free its data stack, even if the thread
+   still has frames, for example when a thread is cleared while it runs.
+   The frame objects of the frames on the stack stop forwarding to them,
+   and the references held by these frames are leaked. */
+void
+_PyFrame_ClearDataStack(PyThreadState *tstate)
+{
+    struct _PyDataStackChunk *chunk = tstate->datastack_chunk;
+    PyFrameObject *top = tstate->frame, *f;
+
+    tstate->frame = NULL;
+    for (f = top; f != NULL; f = f->f_back) {
+        f = _PyFrame_LIVE(f);
+        if (f->f_onstack && f->f_frameobj != NULL) {
+            PyFrameObject *fo = f->f_frameobj;
+
+            fo->f_stackframe = NULL;
+            f->f_frameobj = NULL;
+            Py_DECREF(fo);
+        }
+    }
+    /* A frame object at the top is referenced, as it was before the data
+       stack existed. */
+    if (top != NULL && !top->f_onstack)
+        Py_DECREF(top);
+
+    if (chunk == NULL)
+        return;
+    PyMem_Free(chunk->next);
+    while (chunk != NULL) {
+        struct _PyDataStackChunk *previous = chunk->previous;
+        PyMem_Free(chunk);
+        chunk = previous;
+    }
+    tstate->datastack_chunk = NULL;
+    tstate->datastack_top = NULL;
+    tstate->datastack_limit = NULL;
+}
+
+/* Create a frame on the data stack of tstate, to be popped with
+   _PyFrame_Clear_OnStack() when the call returns.  The code must not be a
+   generator or a coroutine: their frames outlive the call. */
+PyFrameObject* _Py_HOT_FUNCTION
+_PyFrame_New_OnStack(PyThreadState *tstate, PyCodeObject *code,
+                     PyObject *globals, PyObject *locals)
+{
+    PyGC_Head *g;
+    PyFrameObject *f;
+    PyObject *builtins;
+    Py_ssize_t i, nlocalsplus;
+
+#ifdef Py_DEBUG
+    if (code == NULL || globals == NULL || !PyDict_Check(globals) ||
+        (locals != NULL && !PyMapping_Check(locals))) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+#endif
+    builtins = frame_get_builtins(tstate->frame, globals);
+    if (builtins == NULL)
+        return NULL;
+    if (frame_get_locals(code, globals, &locals) < 0) {
+        Py_DECREF(builtins);
+        return NULL;
+    }
+    nlocalsplus = code->co_nlocals + PyTuple_GET_SIZE(code->co_cellvars) +
+        PyTuple_GET_SIZE(code->co_freevars);
+    g = datastack_push(tstate, sizeof(PyGC_Head) + sizeof(PyFrameObject) +
+                       (nlocalsplus + code->co_stacksize) * sizeof(PyObject *));
+    if (g == NULL) {
+        Py_DECREF(builtins);
+        Py_XDECREF(locals);
+        return NULL;
+    }
+    g->_gc_next = 0;
+    g->_gc_prev = 0;
+    f = (PyFrameObject *)(g + 1);
+    /* Not _Py_NewReference(): the frame is never deallocated. */
+    Py_TYPE(f) = &PyFrame_Type;
+    Py_REFCNT(f) = 1;
+    Py_SIZE(f) = nlocalsplus + code->co_stacksize;
+#ifdef Py_TRACE_REFS
+    f->ob_base.ob_base._ob_next = NULL;
+    f->ob_base.ob_base._ob_prev = NULL;
+#endif
+    f->f_code = code;
+    f->f_valuestack = f->f_localsplus + nlocalsplus;
+    for (i = 0; i < nlocalsplus; i++)
+        f->f_localsplus[i] = NULL;
+    f->f_trace = NULL;
+    frame_init(f, code, globals, builtins, locals);
+    f->f_back = tstate->frame;
+    f->f_onstack = 1;
     return f;
 }
 
+/* Return a borrowed reference to a frame object for the frame f: f itself,
+   unless it is on the data stack.  The frame objects of its callers on the
+   data stack are created as well, up to the first one which already has
+   one, and linked by f_back (see above).  Return NULL on error. */
+PyFrameObject *
+_PyFrame_Materialize(PyFrameObject *f)
+{
+    PyFrameObject *fo, *result = NULL, *child = NULL;
+
+    while (f != NULL) {
+        if (!f->f_onstack) {
+            fo = f;
+        }
+        else {
+            fo = f->f_frameobj;
+            if (fo == NULL) {
+                fo = frame_alloc(f->f_code);
+                if (fo == NULL)
+                    return NULL;
+                Py_INCREF(f->f_builtins);
+                frame_init(fo, f->f_code, f->f_globals, f->f_builtins, NULL);
+                fo->f_stacktop = NULL;
+                fo->f_stackframe = f;
+                /* The frame on the stack owns the new reference. */
+                f->f_frameobj = fo;
+                _PyObject_GC_TRACK(fo);
+            }
+            fo->f_lasti = f->f_lasti;
+            fo->f_lineno = f->f_lineno;
+        }
+        if (child != NULL) {
+            Py_INCREF(fo);
+            child->f_back = fo;
+        }
+        else {
+            result = fo;
+        }
+        /* The f_back of a frame object for a frame on the heap is the
+           frame itself; the f_back of one which was linked before is
+           still right, since its callers didn't return since then. */
+        if (!f->f_onstack || fo->f_back != NULL)
+            break;
+        child = fo;
+        f = f->f_back;
+    }
+    return result;
+}
+
+/* Move the state of the frame f, whose call returned, into its frame
+   object fo. */
+static void
+frame_take_over(PyFrameObject *fo, PyFrameObject *f)
+{
+    PyObject **p, **q;
+
+    assert(fo->f_code == f->f_code);
+    for (p = f->f_localsplus, q = fo->f_localsplus; p < f->f_valuestack;
+         p++, q++) {
+        *q = *p;
+        *p = NULL;
+    }
+    fo->f_locals = f->f_locals;
+    f->f_locals = NULL;
+    fo->f_trace = f->f_trace;
+    f->f_trace = NULL;
+    fo->f_lasti = f->f_lasti;
+    fo->f_lineno = f->f_lineno;
+    fo->f_iblock = f->f_iblock;
+    memcpy(fo->f_blockstack, f->f_blockstack,
+           f->f_iblock * sizeof(PyTryBlock));
+    fo->f_trace_opcodes = f->f_trace_opcodes;
+    fo->f_trace_lines = f->f_trace_lines;
+
+    /* f_back is already set, unless _PyFrame_Materialize() failed to
+       create the frame objects of the callers */
+    if (fo->f_back == NULL && f->f_back != NULL) {
+        PyObject *error_type, *error_value, *error_traceback;
+        PyFrameObject *back;
+
+        PyErr_Fetch(&error_type, &error_value, &error_traceback);
+        back = _PyFrame_Materialize(f->f_back);
+        if (back == NULL)
+            PyErr_Clear();
+        PyErr_Restore(error_type, error_value, error_traceback);
+        Py_XINCREF(back);
+        fo->f_back = back;
+    }
+}
+
+/* Pop the frame f from the data stack of tstate.  If its frame object is
+   still referenced elsewhere, it takes over the state of f. */
+void
+_PyFrame_Clear_OnStack(PyThreadState *tstate, PyFrameObject *f)
+{
+    PyFrameObject *fo = f->f_frameobj;
+    PyObject **p;
+
+    assert(f->f_onstack && Py_REFCNT(f) == 1);
+    if (fo != NULL) {
+        fo->f_stackframe = NULL;
+        f->f_frameobj = NULL;
+        if (Py_REFCNT(fo) > 1)
+            frame_take_over(fo, f);
+        Py_DECREF(fo);
+    }
+
+    for (p = f->f_localsplus; p < f->f_valuestack; p++)
+        Py_CLEAR(*p);
+    if (f->f_stacktop != NULL) {
+        for (p = f->f_valuestack; p < f->f_stacktop; p++)
+            Py_XDECREF(*p);
+    }
+    Py_DECREF(f->f_builtins);
+    Py_DECREF(f->f_globals);
+    Py_CLEAR(f->f_locals);
+    Py_CLEAR(f->f_trace);
+    Py_DECREF(f->f_code);
+    datastack_pop(tstate, _Py_AS_GC(f));
+}
+
 
 /* Block management */
 
@@ -873,6 +1323,7 @@ PyFrame_FastToLocalsWithError(PyFrameObject *f)
         PyErr_BadInternalCall();
         return -1;
     }
+    f = _PyFrame_LIVE(f);
     locals = f->f_locals;
     if (locals == NULL) {
         locals = f->f_locals = PyDict_New();
@@ -943,6 +1394,7 @@ PyFrame_LocalsToFast(PyFrameObject *f, int clear)
     Py_ssize_t ncells, nfreevars;
     if (f == NULL)
         return;
+    f = _PyFrame_LIVE(f);
     locals = f->f_locals;
     co = f->f_code;
     map = co->co_varnames;
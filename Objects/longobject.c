@@ -113,11 +113,44 @@ _PyLong_Negate(PyLongObject **x_p)
  */
 #define FIVEARY_CUTOFF 8
 
+/* Division and conversion to and from decimal strings switch to the
+ * divide-and-conquer algorithms of Lib/_pylong.py for huge ints: their
+ * asymptotic behavior outweighs the cost of running in Python.  l_divmod()
+ * uses them when the divisor has more than PYLONG_DIVMOD_CUTOFF digits and
+ * the quotient more than PYLONG_QUOTIENT_CUTOFF digits.
+ */
+#define PYLONG_DIVMOD_CUTOFF 300
+#define PYLONG_QUOTIENT_CUTOFF 150
+/* Number of digits of an int converted to a decimal string */
+#define PYLONG_TOSTR_CUTOFF 1000
+/* Number of decimal digits of a string converted to an int */
+#define PYLONG_FROMSTR_CUTOFF 6000
+
 #define SIGCHECK(PyTryBlock)                    \
     do {                                        \
         if (PyErr_CheckSignals()) PyTryBlock    \
     } while(0)
 
+/* Call a function of Lib/_pylong.py with one or two arguments (pass NULL as
+ * b for one).  If the module can't be imported, return NULL without an
+ * exception set, so that the caller falls back to its own algorithm.
+ */
+static PyObject *
+pylong_call(_Py_Identifier *name, PyObject *a, PyObject *b)
+{
+    PyObject *mod, *res;
+
+    mod = PyImport_ImportModule("_pylong");
+    if (mod == NULL) {
+        if (PyErr_ExceptionMatches(PyExc_ImportError))
+            PyErr_Clear();
+        return NULL;
+    }
+    res = _PyObject_CallMethodIdObjArgs(mod, name, a, b, NULL);
+    Py_DECREF(mod);
+    return res;
+}
+
 /* Normalize (remove leading zeros from) an int object.
    Doesn't attempt to free the storage--in most cases, due to the nature
    of the algorithms used, this could save at most be one word anyway. */
@@ -1602,6 +1635,42 @@ long_to_decimal_string_internal(PyObject *aa,
     size_a = Py_ABS(Py_SIZE(a));
     negative = Py_SIZE(a) < 0;
 
+    /* Subclasses are left out, as they could override the operators that
+       _pylong relies on. */
+    if (size_a > PYLONG_TOSTR_CUTOFF && PyLong_CheckExact(a)) {
+        _Py_IDENTIFIER(int_to_decimal_string);
+
+        str = pylong_call(&PyId_int_to_decimal_string, aa, NULL);
+        if (str == NULL) {
+            if (PyErr_Occurred())
+                return -1;
+            /* no _pylong: go on with the quadratic algorithm */
+        }
+        else {
+            assert(PyUnicode_CheckExact(str) && PyUnicode_IS_ASCII(str));
+            strlen = PyUnicode_GET_LENGTH(str);
+            if (writer) {
+                int res = _PyUnicodeWriter_WriteStr(writer, str);
+                Py_DECREF(str);
+                return res;
+            }
+            else if (bytes_writer) {
+                *bytes_str = _PyBytesWriter_Prepare(bytes_writer, *bytes_str,
+                                                    strlen);
+                if (*bytes_str == NULL) {
+                    Py_DECREF(str);
+                    return -1;
+                }
+                memcpy(*bytes_str, PyUnicode_1BYTE_DATA(str), strlen);
+                (*bytes_str) += strlen;
+                Py_DECREF(str);
+                return 0;
+            }
+            *p_output = str;
+            return 0;
+        }
+    }
+
     /* quick and dirty upper bound for the number of digits
        required to express a in base _PyLong_DECIMAL_BASE:
 
@@ -2325,6 +2394,37 @@ digit beyond the first.
             goto onError;
         }
 
+        if (base == 10 && digits > PYLONG_FROMSTR_CUTOFF) {
+            _Py_IDENTIFIER(int_from_string);
+            PyObject *digitstr, *v;
+
+            digitstr = PyUnicode_FromStringAndSize(str, scan - str);
+            if (digitstr == NULL) {
+                return NULL;
+            }
+            v = pylong_call(&PyId_int_from_string, digitstr, NULL);
+            Py_DECREF(digitstr);
+            if (v != NULL) {
+                assert(PyLong_CheckExact(v) && Py_SIZE(v) >= 0);
+                /* Apply the sign here: v may be a shared small int if the
+                   digits were mostly leading zeros. */
+                if (sign < 0) {
+                    z = (PyLongObject *)PyNumber_Negative(v);
+                    Py_DECREF(v);
+                    sign = 1;
+                }
+                else {
+                    z = (PyLongObject *)v;
+                }
+                str = scan;
+                goto digits_done;
+            }
+            if (PyErr_Occurred()) {
+                return NULL;
+            }
+            /* no _pylong: go on with the quadratic algorithm */
+        }
+
         /* Create an int object that can contain the largest possible
          * integer with this base and length.  Note that there's no
          * need to initialize z->ob_digit -- no slot is read up before
@@ -2417,6 +2517,7 @@ digit beyond the first.
             }
         }
     }
+  digits_done:
     if (z == NULL) {
         return NULL;
     }
@@ -3665,6 +3766,31 @@ l_divmod(PyLongObject *v, PyLongObject *w,
         }
         return 0;
     }
+    if (Py_ABS(Py_SIZE(w)) > PYLONG_DIVMOD_CUTOFF &&
+        Py_ABS(Py_SIZE(v)) - Py_ABS(Py_SIZE(w)) > PYLONG_QUOTIENT_CUTOFF &&
+        PyLong_CheckExact(v) && PyLong_CheckExact(w)) {
+        /* Burnikel-Ziegler division in _pylong.int_divmod() */
+        _Py_IDENTIFIER(int_divmod);
+        PyObject *res;
+
+        res = pylong_call(&PyId_int_divmod, (PyObject *)v, (PyObject *)w);
+        if (res != NULL) {
+            assert(PyTuple_CheckExact(res) && PyTuple_GET_SIZE(res) == 2);
+            if (pdiv != NULL) {
+                *pdiv = (PyLongObject *)PyTuple_GET_ITEM(res, 0);
+                Py_INCREF(*pdiv);
+            }
+            if (pmod != NULL) {
+                *pmod = (PyLongObject *)PyTuple_GET_ITEM(res, 1);
+                Py_INCREF(*pmod);
+            }
+            Py_DECREF(res);
+            return 0;
+        }
+        if (PyErr_Occurred())
+            return -1;
+        /* no _pylong: go on with the quadratic algorithm */
+    }
     if (long_divrem(v, w, &div, &mod) < 0)
         return -1;
     if ((Py_SIZE(mod) < 0 && Py_SIZE(w) > 0) ||
@@ -4836,6 +4962,20 @@ long_new_impl(PyTypeObject *type, PyObject *x, PyObject *obase)
     }
 }
 
+/* Call int() without a tuple of the arguments */
+static PyObject *
+long_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+                PyObject *kwnames)
+{
+    assert(type == (PyObject *)&PyLong_Type);
+    if (kwnames == NULL && nargs <= 2) {
+        return long_new_impl(&PyLong_Type,
+                             nargs >= 1 ? args[0] : NULL,
+                             nargs >= 2 ? args[1] : NULL);
+    }
+    return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+}
+
 /* Wimpy, slow approach to tp_new calls for subtypes of int:
    first create a regular int from whatever arguments we got,
    then allocate a subtype instance and initialize it from
@@ -5417,6 +5557,17 @@ PyTypeObject PyLong_Type = {
     0,                                          /* tp_alloc */
     long_new,                                   /* tp_new */
     PyObject_Del,                               /* tp_free */
+    0,                                          /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    0,                                          /* tp_vectorcall_offset */
+    long_vectorcall,                            /* tp_vectorcall */
 };
 
 static PyTypeObject Int_InfoType;
@@ -1,4 +1,5 @@
 #include "Python.h"
+#include "internal/pystate.h"
 
 #include <stdbool.h>
 
@@ -55,6 +56,12 @@ static void _PyMem_SetupDebugHooksDomain(PyMemAllocatorDomain domain);
 #  endif
 #endif
 
+/* Use a radix tree to find out whether an address belongs to pymalloc, see
+   address_in_range() */
+#ifndef WITH_PYMALLOC_RADIX_TREE
+#  define WITH_PYMALLOC_RADIX_TREE 1
+#endif
+
 /* Forward declaration */
 static void* _PyObject_Malloc(void *ctx, size_t size);
 static void* _PyObject_Calloc(void *ctx, size_t nelem, size_t elsize);
@@ -119,6 +126,9 @@ _PyObject_ArenaVirtualFree(void *ctx, void *ptr, size_t size)
 }
 
 #elif defined(ARENAS_USE_MMAP)
+/* Number of memory mappings currently used for arenas */
+static size_t narena_mappings = 0;
+
 static void *
 _PyObject_ArenaMmap(void *ctx, size_t size)
 {
@@ -128,6 +138,7 @@ _PyObject_ArenaMmap(void *ctx, size_t size)
     if (ptr == MAP_FAILED)
         return NULL;
     assert(ptr != NULL);
+    narena_mappings++;
     return ptr;
 }
 
@@ -135,6 +146,122 @@ static void
 _PyObject_ArenaMunmap(void *ctx, void *ptr, size_t size)
 {
     munmap(ptr, size);
+    narena_mappings--;
+}
+
+/* Huge page arena allocator (-X hugepages).
+
+   Arenas are carved out of large reservations, aligned on the huge page
+   size and advised with MADV_HUGEPAGE, so that the kernel can back them
+   with transparent huge pages.  This keeps the number of mappings low and
+   reduces the TLB pressure of processes using a lot of memory.
+
+   A freed arena is given back to the system with MADV_DONTNEED, but its
+   address range is kept in the reservation for later arenas.  A reservation
+   is unmapped once all its arenas are free. */
+
+#define HUGE_PAGE_SIZE          ((size_t)2 << 20)       /* 2 MiB */
+#define ARENA_RESERVATION_SIZE  ((size_t)64 << 20)      /* 64 MiB */
+
+struct arena_reservation {
+    struct arena_reservation *next;
+    uint8_t *address;
+    size_t arena_size;
+    /* number of arena slots in the reservation */
+    uint nslots;
+    /* number of slots currently used by an arena */
+    uint nused;
+    /* inuse[i] is non-zero if slot i is used by an arena */
+    uint8_t inuse[1];
+};
+
+static struct arena_reservation *arena_reservations = NULL;
+
+static void *
+_PyObject_ArenaHugeAlloc(void *ctx, size_t size)
+{
+    struct arena_reservation *res;
+    uint8_t *ptr;
+    size_t nslots, length, offset;
+    uint i;
+
+    for (res = arena_reservations; res != NULL; res = res->next) {
+        if (res->arena_size == size && res->nused < res->nslots) {
+            break;
+        }
+    }
+    if (res == NULL) {
+        nslots = ARENA_RESERVATION_SIZE / size;
+        if (nslots == 0) {
+            nslots = 1;
+        }
+        res = (struct arena_reservation *)PyMem_RawCalloc(
+            1, sizeof(struct arena_reservation) + nslots - 1);
+        if (res == NULL) {
+            return NULL;
+        }
+        /* Map one more huge page to align the reservation on the huge page
+           size, then unmap the unused head and tail. */
+        length = nslots * size;
+        ptr = mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ|PROT_WRITE,
+                   MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            PyMem_RawFree(res);
+            return NULL;
+        }
+        offset = (HUGE_PAGE_SIZE - ((uintptr_t)ptr & (HUGE_PAGE_SIZE - 1)))
+                 & (HUGE_PAGE_SIZE - 1);
+        if (offset != 0) {
+            munmap(ptr, offset);
+        }
+        munmap(ptr + offset + length, HUGE_PAGE_SIZE - offset);
+        ptr += offset;
+#ifdef MADV_HUGEPAGE
+        (void)madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+        res->address = ptr;
+        res->arena_size = size;
+        res->nslots = (uint)nslots;
+        res->next = arena_reservations;
+        arena_reservations = res;
+        narena_mappings++;
+    }
+
+    for (i = 0; res->inuse[i]; i++) {
+        assert(i < res->nslots);
+    }
+    res->inuse[i] = 1;
+    res->nused++;
+    return res->address + (size_t)i * size;
+}
+
+static void
+_PyObject_ArenaHugeFree(void *ctx, void *ptr, size_t size)
+{
+    struct arena_reservation *res, **prev;
+    size_t i;
+
+    for (prev = &arena_reservations; (res = *prev) != NULL;
+         prev = &res->next) {
+        if ((uint8_t *)ptr >= res->address &&
+            (uint8_t *)ptr < res->address + res->nslots * res->arena_size) {
+            break;
+        }
+    }
+    assert(res != NULL && res->arena_size == size);
+    i = ((uint8_t *)ptr - res->address) / size;
+    assert(res->inuse[i]);
+    res->inuse[i] = 0;
+    res->nused--;
+    if (res->nused == 0) {
+        *prev = res->next;
+        munmap(res->address, res->nslots * res->arena_size);
+        PyMem_RawFree(res);
+        narena_mappings--;
+    }
+    else {
+        (void)madvise(ptr, size, MADV_DONTNEED);
+    }
 }
 
 #else
@@ -829,8 +956,15 @@ static int running_on_valgrind = -1;
  *
  * Arenas are allocated with mmap() on systems supporting anonymous memory
  * mappings to reduce heap fragmentation.
+ *
+ * The arena size can be changed by the -X arenasize option, before the first
+ * arena is allocated; see _PyObject_SetArenaConfig().
  */
-#define ARENA_SIZE              (256 << 10)     /* 256KB */
+#define DEFAULT_ARENA_SIZE      (256 << 10)     /* 256KB */
+#define MAX_ARENA_SIZE          ((size_t)1 << 30)       /* 1GB */
+
+static size_t arena_size = DEFAULT_ARENA_SIZE;
+#define ARENA_SIZE              arena_size
 
 #ifdef WITH_MEMORY_LIMITS
 #define MAX_ARENAS              (SMALL_MEMORY_LIMIT / ARENA_SIZE)
@@ -911,6 +1045,17 @@ struct arena_object {
     /* The total number of pools in the arena, whether or not available. */
     uint ntotalpools;
 
+    /* The number of available pools whose memory was given back to the
+     * system by _PyObject_TrimArenas().  They are counted in nfreepools,
+     * but are neither in freepools nor beyond pool_address.
+     */
+    uint ntrimmedpools;
+
+    /* No trimmed pool lies below this pool-aligned address, from which
+     * find_trimmed_pool() starts looking for one.
+     */
+    block* trimmed_address;
+
     /* Singly-linked list of available pools. */
     struct pool_header* freepools;
 
@@ -1144,6 +1289,13 @@ static size_t ntimes_arena_allocated = 0;
 /* High water mark (max value ever seen) for narenas_currently_allocated. */
 static size_t narenas_highwater = 0;
 
+/* Number of calls to _PyObject_TrimArenas(). */
+static size_t ntimes_trimmed = 0;
+/* Total number of pools given back to the system by _PyObject_TrimArenas(). */
+static size_t ntrimmed_pools_total = 0;
+/* Total number of trimmed pools which were used again. */
+static size_t ntrimmed_pools_reused = 0;
+
 static Py_ssize_t _Py_AllocatedBlocks = 0;
 
 Py_ssize_t
@@ -1153,6 +1305,217 @@ _Py_GetAllocatedBlocks(void)
 }
 
 
+#if WITH_PYMALLOC_RADIX_TREE
+/*==========================================================================*/
+/* Arena map
+
+   A radix tree over the address bits records which address ranges belong
+   to arenas, so that address_in_range() never has to read memory that
+   pymalloc doesn't own.
+
+   The address space is divided in granules of 2**arena_map_bits bytes, where
+   the granule size is not larger than the arena size (nor than a leaf).  An
+   arena therefore covers at least one whole granule, and at most one arena
+   can end and one arena can start within a granule.  For each granule, a
+   leaf of the tree stores the offsets at which these arenas end (tail_lo) and
+   start (tail_hi):  the granule bytes below tail_lo and the bytes from
+   tail_hi belong to arenas.  tail_hi is -1 if the whole granule is covered,
+   and 0 if no arena starts in the granule.
+
+   The root node is static, the other nodes are allocated on demand and only
+   freed when the arena size is changed while no arena is allocated.
+*/
+
+#if SIZEOF_VOID_P > 4
+   /* Current 64-bit processors only use 48 address bits */
+#  define MAP_ADDRESS_BITS 48
+#  define MAP_MID_BITS 12
+#else
+#  define MAP_ADDRESS_BITS 32
+#  define MAP_MID_BITS 4
+#endif
+/* Each leaf covers 2**MAP_LEAF_SHIFT bytes */
+#define MAP_LEAF_SHIFT 24
+#define MAP_MID_SHIFT (MAP_LEAF_SHIFT + MAP_MID_BITS)
+#define MAP_ROOT_BITS (MAP_ADDRESS_BITS - MAP_MID_SHIFT)
+#define MAP_ROOT_LENGTH (1 << MAP_ROOT_BITS)
+#define MAP_MID_LENGTH (1 << MAP_MID_BITS)
+
+#define MAP_ROOT_INDEX(p) \
+    (((uintptr_t)(p) >> MAP_MID_SHIFT) & (MAP_ROOT_LENGTH - 1))
+#define MAP_MID_INDEX(p) \
+    (((uintptr_t)(p) >> MAP_LEAF_SHIFT) & (MAP_MID_LENGTH - 1))
+#define MAP_LEAF_INDEX(p) \
+    (((uintptr_t)(p) & (((uintptr_t)1 << MAP_LEAF_SHIFT) - 1)) \
+     >> arena_map_bits)
+
+typedef struct {
+    int32_t tail_hi;
+    int32_t tail_lo;
+} arena_coverage_t;
+
+typedef struct arena_map_leaf {
+    arena_coverage_t arenas[1];
+} arena_map_leaf_t;
+
+typedef struct arena_map_mid {
+    arena_map_leaf_t *ptrs[MAP_MID_LENGTH];
+} arena_map_mid_t;
+
+static arena_map_mid_t *arena_map_root[MAP_ROOT_LENGTH];
+
+/* log2 of the granule size, set by arena_map_configure() */
+static int arena_map_bits = 18;
+
+/* Number of mid and leaf nodes, and bytes allocated for them */
+static size_t arena_map_mid_count = 0;
+static size_t arena_map_leaf_count = 0;
+static size_t arena_map_bytes = 0;
+
+static size_t
+arena_map_leaf_size(void)
+{
+    return sizeof(arena_coverage_t) << (MAP_LEAF_SHIFT - arena_map_bits);
+}
+
+/* Return the leaf node covering p, or NULL.  If create is non-zero, create
+   missing nodes: return NULL only on memory allocation failure. */
+static arena_map_leaf_t *
+arena_map_get(block *p, int create)
+{
+    arena_map_mid_t *mid;
+    arena_map_leaf_t *leaf;
+
+#if SIZEOF_VOID_P > 4
+    if ((uintptr_t)p >> MAP_ADDRESS_BITS) {
+        return NULL;
+    }
+#endif
+    mid = arena_map_root[MAP_ROOT_INDEX(p)];
+    if (mid == NULL) {
+        if (!create) {
+            return NULL;
+        }
+        mid = (arena_map_mid_t *)PyMem_RawCalloc(1, sizeof(arena_map_mid_t));
+        if (mid == NULL) {
+            return NULL;
+        }
+        arena_map_root[MAP_ROOT_INDEX(p)] = mid;
+        arena_map_mid_count++;
+        arena_map_bytes += sizeof(arena_map_mid_t);
+    }
+    leaf = mid->ptrs[MAP_MID_INDEX(p)];
+    if (leaf == NULL) {
+        if (!create) {
+            return NULL;
+        }
+        leaf = (arena_map_leaf_t *)PyMem_RawCalloc(1, arena_map_leaf_size());
+        if (leaf == NULL) {
+            return NULL;
+        }
+        mid->ptrs[MAP_MID_INDEX(p)] = leaf;
+        arena_map_leaf_count++;
+        arena_map_bytes += arena_map_leaf_size();
+    }
+    return leaf;
+}
+
+/* Record that the arena [address:address+ARENA_SIZE) is used or not.
+   Return 0 on memory allocation failure, or if the arena can't be recorded
+   in the map. */
+static int
+arena_map_mark_used(uintptr_t address, int is_used)
+{
+    const uintptr_t granule = (uintptr_t)1 << arena_map_bits;
+    const uintptr_t mask = granule - 1;
+    uintptr_t start = address, end = address + ARENA_SIZE;
+    uintptr_t p;
+    arena_map_leaf_t *leaf;
+
+    if (end < start) {
+        return 0;
+    }
+    if (is_used) {
+        /* Create all the nodes first, so that a failure leaves the map
+           unchanged. */
+        for (p = start & ~mask; p < end; p += granule) {
+            if (arena_map_get((block *)p, 1) == NULL) {
+                return 0;
+            }
+        }
+    }
+
+    /* Granule where the arena starts */
+    leaf = arena_map_get((block *)start, 0);
+    assert(leaf != NULL);
+    leaf->arenas[MAP_LEAF_INDEX(start)].tail_hi =
+        is_used ? ((start & mask) ? (int32_t)(start & mask) : -1) : 0;
+
+    /* Granules entirely covered by the arena */
+    for (p = (start & ~mask) + granule; p + granule <= end; p += granule) {
+        leaf = arena_map_get((block *)p, 0);
+        assert(leaf != NULL);
+        leaf->arenas[MAP_LEAF_INDEX(p)].tail_hi = is_used ? -1 : 0;
+    }
+
+    /* Granule where the arena ends */
+    if (end & mask) {
+        leaf = arena_map_get((block *)end, 0);
+        assert(leaf != NULL);
+        leaf->arenas[MAP_LEAF_INDEX(end)].tail_lo =
+            is_used ? (int32_t)(end & mask) : 0;
+    }
+    return 1;
+}
+
+/* Return true if p belongs to an arena */
+static int
+arena_map_is_used(block *p)
+{
+    arena_map_leaf_t *leaf = arena_map_get(p, 0);
+    arena_coverage_t *cov;
+    int32_t tail;
+
+    if (leaf == NULL) {
+        return 0;
+    }
+    cov = &leaf->arenas[MAP_LEAF_INDEX(p)];
+    tail = (int32_t)((uintptr_t)p & (((uintptr_t)1 << arena_map_bits) - 1));
+    return (tail < cov->tail_lo) || (cov->tail_hi != 0 && tail >= cov->tail_hi);
+}
+
+/* Size the granules for arenas of size bytes.  Must be called while no
+   arena is allocated. */
+static void
+arena_map_configure(size_t size)
+{
+    int bits = 12;
+    int i, j;
+
+    while (bits < MAP_LEAF_SHIFT && ((size_t)1 << (bits + 1)) <= size) {
+        bits++;
+    }
+    if (bits == arena_map_bits) {
+        return;
+    }
+    /* The leaves are sized for the granules, free all the nodes */
+    for (i = 0; i < MAP_ROOT_LENGTH; i++) {
+        arena_map_mid_t *mid = arena_map_root[i];
+        if (mid == NULL) {
+            continue;
+        }
+        for (j = 0; j < MAP_MID_LENGTH; j++) {
+            PyMem_RawFree(mid->ptrs[j]);
+        }
+        PyMem_RawFree(mid);
+        arena_map_root[i] = NULL;
+    }
+    arena_map_mid_count = arena_map_leaf_count = arena_map_bytes = 0;
+    arena_map_bits = bits;
+}
+#endif /* WITH_PYMALLOC_RADIX_TREE */
+
+
 /* Allocate a new arena.  If we run out of memory, return NULL.  Else
  * allocate a new arena, and return the address of an arena_object
  * describing the new arena.  It's expected that the caller will set
@@ -1229,6 +1592,17 @@ new_arena(void)
         unused_arena_objects = arenaobj;
         return NULL;
     }
+#if WITH_PYMALLOC_RADIX_TREE
+    if (!arena_map_mark_used((uintptr_t)address, 1)) {
+        /* Not enough memory for the arena map, or an address that it can't
+         * record: free the arena and put the arenaobj back.
+         */
+        _PyObject_Arena.free(_PyObject_Arena.ctx, address, ARENA_SIZE);
+        arenaobj->nextarena = unused_arena_objects;
+        unused_arena_objects = arenaobj;
+        return NULL;
+    }
+#endif
     arenaobj->address = (uintptr_t)address;
 
     ++narenas_currently_allocated;
@@ -1239,7 +1613,7 @@ new_arena(void)
     /* pool_address <- first pool-aligned address in the arena
        nfreepools <- number of whole pools that fit after alignment */
     arenaobj->pool_address = (block*)arenaobj->address;
-    arenaobj->nfreepools = ARENA_SIZE / POOL_SIZE;
+    arenaobj->nfreepools = (uint)(ARENA_SIZE / POOL_SIZE);
     assert(POOL_SIZE * arenaobj->nfreepools == ARENA_SIZE);
     excess = (uint)(arenaobj->address & POOL_SIZE_MASK);
     if (excess != 0) {
@@ -1247,11 +1621,99 @@ new_arena(void)
         arenaobj->pool_address += POOL_SIZE - excess;
     }
     arenaobj->ntotalpools = arenaobj->nfreepools;
+    arenaobj->ntrimmedpools = 0;
+    arenaobj->trimmed_address = arenaobj->pool_address;
 
     return arenaobj;
 }
 
 
+/* Configure the arenas: size is the arena size in bytes (0 keeps the
+   current size), and if hugepages is non-zero, arenas are allocated from
+   reservations backed by transparent huge pages.  It can only be done while
+   no arena is allocated.
+
+   Return NULL on success, or an error message. */
+const char *
+_PyObject_SetArenaConfig(size_t size, int hugepages)
+{
+#ifdef ARENAS_USE_MMAP
+    if (hugepages && size == 0) {
+        size = HUGE_PAGE_SIZE;
+    }
+#endif
+    if (size == 0) {
+        size = arena_size;
+    }
+    if (size < POOL_SIZE || size > MAX_ARENA_SIZE || size % POOL_SIZE != 0) {
+        return "the arena size must be a multiple of 4 KiB up to 1 GiB";
+    }
+    if (hugepages) {
+#ifdef ARENAS_USE_MMAP
+        if (_PyObject_Arena.alloc != _PyObject_ArenaMmap
+            && _PyObject_Arena.alloc != _PyObject_ArenaHugeAlloc) {
+            return "huge pages require the default arena allocator";
+        }
+#else
+        return "huge pages are not supported on this platform";
+#endif
+    }
+
+    if (narenas_currently_allocated != 0) {
+#ifdef ARENAS_USE_MMAP
+        int enabled = (_PyObject_Arena.alloc == _PyObject_ArenaHugeAlloc);
+#else
+        int enabled = 0;
+#endif
+        if (size == arena_size && !hugepages == !enabled) {
+            return NULL;
+        }
+        return "arenas are already allocated";
+    }
+    arena_size = size;
+#if WITH_PYMALLOC_RADIX_TREE
+    arena_map_configure(size);
+#endif
+#ifdef ARENAS_USE_MMAP
+    if (hugepages) {
+        _PyObject_Arena.alloc = _PyObject_ArenaHugeAlloc;
+        _PyObject_Arena.free = _PyObject_ArenaHugeFree;
+    }
+    else if (_PyObject_Arena.alloc == _PyObject_ArenaHugeAlloc) {
+        _PyObject_Arena.alloc = _PyObject_ArenaMmap;
+        _PyObject_Arena.free = _PyObject_ArenaMunmap;
+    }
+#endif
+    return NULL;
+}
+
+
+/* Return a trimmed pool of the arena ao, the lowest one.
+
+   The header of a pool is zeroed before it is trimmed, and the memory of a
+   trimmed pool reads as zeros or as its zeroed header.  Pools which were
+   ever used have a non-zero nextoffset.  The trimmed pools can't be linked
+   together: writing to them would page them in again.  Instead the search
+   starts from ao->trimmed_address, which only moves back when pools are
+   trimmed, so reusing all the trimmed pools of an arena scans it once. */
+static poolp
+find_trimmed_pool(struct arena_object *ao)
+{
+    block *base = ao->trimmed_address;
+
+    assert(ao->ntrimmedpools > 0);
+    for (; base < ao->pool_address; base += POOL_SIZE) {
+        poolp pool = (poolp)base;
+        if (pool->nextoffset == 0) {
+            assert(pool->ref.count == 0);
+            ao->trimmed_address = base + POOL_SIZE;
+            return pool;
+        }
+    }
+    Py_UNREACHABLE();
+}
+
+
 /*
 address_in_range(P, POOL)
 
@@ -1325,8 +1787,19 @@ that this test determines whether an arbitrary address is controlled by
 obmalloc in a small constant time, independent of the number of arenas
 obmalloc controls.  Since this test is needed at every entry point, it's
 extremely desirable that it be this fast.
+
+When WITH_PYMALLOC_RADIX_TREE is enabled (the default), the arena map is
+looked up instead:  it doesn't read (POOL)->arenaindex, so memory that wasn't
+allocated by obmalloc is never read, and it's still constant time.
 */
 
+#if WITH_PYMALLOC_RADIX_TREE
+static bool
+address_in_range(void *p, poolp pool)
+{
+    return arena_map_is_used((block *)p);
+}
+#else
 static bool ATTRIBUTE_NO_ADDRESS_SAFETY_ANALYSIS
 address_in_range(void *p, poolp pool)
 {
@@ -1340,6 +1813,174 @@ address_in_range(void *p, poolp pool)
         (uintptr_t)p - arenas[arenaindex].address < ARENA_SIZE &&
         arenas[arenaindex].address != 0;
 }
+#endif
+
+
+/*==========================================================================*/
+
+/* Per-thread block cache
+
+   Every thread state owns a small LIFO cache of free blocks per size class.
+   pymalloc_free() pushes a freed block on the cache of the current thread
+   instead of linking it back into its pool, and pymalloc_alloc() pops blocks
+   from that cache before looking at usedpools.  Blocks sitting in a cache
+   are still accounted as allocated by their pool (pool->ref.count), so they
+   can be handed out again without touching the pool and arena metadata,
+   which is only modified when a cache is empty or full.
+
+   The cache of a thread state is only accessed by the thread holding the
+   GIL with that thread state.  Allocations made without a current thread
+   state (early startup, late finalization) bypass the cache.  The cache is
+   flushed back to the pools by PyThreadState_Clear(). */
+
+/* Maximum number of blocks cached per size class */
+#define PYMALLOC_CACHE_SIZE 32
+
+struct _pymalloc_cache {
+    block *freeblocks[NB_SMALL_SIZE_CLASSES];
+    uint nfree[NB_SMALL_SIZE_CLASSES];
+};
+
+static int pymalloc_cache_enabled = 1;
+
+static void pymalloc_free_block(poolp pool, block *p);
+
+/* Pop a free block of the size class size from the cache of the current
+   thread.  Return NULL if the cache is empty. */
+static block *
+pymalloc_cache_pop(uint size)
+{
+    PyThreadState *tstate;
+    struct _pymalloc_cache *cache;
+    block *bp;
+
+    if (!pymalloc_cache_enabled) {
+        return NULL;
+    }
+    tstate = PyThreadState_GET();
+    if (tstate == NULL || (cache = tstate->pymalloc_cache) == NULL) {
+        return NULL;
+    }
+    bp = cache->freeblocks[size];
+    if (bp == NULL) {
+        return NULL;
+    }
+    cache->freeblocks[size] = *(block **)bp;
+    cache->nfree[size]--;
+    return bp;
+}
+
+/* Push the block p of pool on the cache of the current thread.
+   Return 0 if the block has not been cached. */
+static int
+pymalloc_cache_push(poolp pool, block *p)
+{
+    PyThreadState *tstate;
+    struct _pymalloc_cache *cache;
+    uint size;
+
+    if (!pymalloc_cache_enabled) {
+        return 0;
+    }
+    tstate = PyThreadState_GET();
+    if (tstate == NULL) {
+        return 0;
+    }
+    cache = tstate->pymalloc_cache;
+    if (cache == NULL) {
+        cache = (struct _pymalloc_cache *)PyMem_RawCalloc(1, sizeof(*cache));
+        if (cache == NULL) {
+            return 0;
+        }
+        tstate->pymalloc_cache = cache;
+    }
+    size = pool->szidx;
+    if (cache->nfree[size] >= PYMALLOC_CACHE_SIZE) {
+        return 0;
+    }
+    *(block **)p = cache->freeblocks[size];
+    cache->freeblocks[size] = p;
+    cache->nfree[size]++;
+    return 1;
+}
+
+/* Give the blocks cached by tstate back to their pools and release the
+   cache.  Must be called with the GIL held. */
+void
+_PyObject_ClearThreadCache(PyThreadState *tstate)
+{
+    struct _pymalloc_cache *cache = tstate->pymalloc_cache;
+    uint i;
+
+    if (cache == NULL) {
+        return;
+    }
+    tstate->pymalloc_cache = NULL;
+    for (i = 0; i < NB_SMALL_SIZE_CLASSES; i++) {
+        block *bp = cache->freeblocks[i];
+        while (bp != NULL) {
+            block *next = *(block **)bp;
+            pymalloc_free_block(POOL_ADDR(bp), bp);
+            bp = next;
+        }
+    }
+    PyMem_RawFree(cache);
+}
+
+/* Clear the caches of all thread states of all interpreters */
+static void
+pymalloc_clear_all_caches(void)
+{
+    PyInterpreterState *interp;
+    PyThreadState *tstate;
+
+    for (interp = PyInterpreterState_Head(); interp != NULL;
+         interp = PyInterpreterState_Next(interp)) {
+        for (tstate = PyInterpreterState_ThreadHead(interp); tstate != NULL;
+             tstate = PyThreadState_Next(tstate)) {
+            _PyObject_ClearThreadCache(tstate);
+        }
+    }
+}
+
+/* Enable or disable the per-thread block caches.  Disabling them gives all
+   cached blocks back to their pools.  Return the previous state. */
+int
+_PyObject_SetThreadCacheEnabled(int enabled)
+{
+    int old = pymalloc_cache_enabled;
+    pymalloc_cache_enabled = enabled;
+    if (!enabled) {
+        pymalloc_clear_all_caches();
+    }
+    return old;
+}
+
+int
+_PyObject_GetThreadCacheEnabled(void)
+{
+    return pymalloc_cache_enabled;
+}
+
+/* Number of blocks of the size class size held by all thread caches */
+static size_t
+pymalloc_cached_blocks(uint size)
+{
+    PyInterpreterState *interp;
+    PyThreadState *tstate;
+    size_t n = 0;
+
+    for (interp = PyInterpreterState_Head(); interp != NULL;
+         interp = PyInterpreterState_Next(interp)) {
+        for (tstate = PyInterpreterState_ThreadHead(interp); tstate != NULL;
+             tstate = PyThreadState_Next(tstate)) {
+            if (tstate->pymalloc_cache != NULL) {
+                n += tstate->pymalloc_cache->nfree[size];
+            }
+        }
+    }
+    return n;
+}
 
 
 /*==========================================================================*/
@@ -1381,11 +2022,17 @@ pymalloc_alloc(void *ctx, void **ptr_p, size_t nbytes)
         return 0;
     }
 
+    size = (uint)(nbytes - 1) >> ALIGNMENT_SHIFT;
+    bp = pymalloc_cache_pop(size);
+    if (bp != NULL) {
+        *ptr_p = (void *)bp;
+        return 1;
+    }
+
     LOCK();
     /*
      * Most frequent paths first
      */
-    size = (uint)(nbytes - 1) >> ALIGNMENT_SHIFT;
     pool = usedpools[size + size];
     if (pool != pool->nextpool) {
         /*
@@ -1472,6 +2119,7 @@ pymalloc_alloc(void *ctx, void **ptr_p, size_t nbytes)
              * time.
              */
             assert(usable_arenas->freepools != NULL ||
+                   usable_arenas->ntrimmedpools > 0 ||
                    usable_arenas->pool_address <=
                    (block*)usable_arenas->address +
                        ARENA_SIZE - POOL_SIZE);
@@ -1510,16 +2158,25 @@ pymalloc_alloc(void *ctx, void **ptr_p, size_t nbytes)
         goto success;
     }
 
-    /* Carve off a new pool. */
+    /* Carve off a new pool, or reuse a trimmed pool once all the pools
+     * of the arena have been carved off.
+     */
     assert(usable_arenas->nfreepools > 0);
     assert(usable_arenas->freepools == NULL);
-    pool = (poolp)usable_arenas->pool_address;
-    assert((block*)pool <= (block*)usable_arenas->address +
-                             ARENA_SIZE - POOL_SIZE);
+    if (usable_arenas->nfreepools > usable_arenas->ntrimmedpools) {
+        pool = (poolp)usable_arenas->pool_address;
+        assert((block*)pool <= (block*)usable_arenas->address +
+                                 ARENA_SIZE - POOL_SIZE);
+        usable_arenas->pool_address += POOL_SIZE;
+    }
+    else {
+        pool = find_trimmed_pool(usable_arenas);
+        --usable_arenas->ntrimmedpools;
+        ++ntrimmed_pools_reused;
+    }
     pool->arenaindex = (uint)(usable_arenas - arenas);
     assert(&arenas[pool->arenaindex] == usable_arenas);
     pool->szidx = DUMMY_SIZE_IDX;
-    usable_arenas->pool_address += POOL_SIZE;
     --usable_arenas->nfreepools;
 
     if (usable_arenas->nfreepools == 0) {
@@ -1594,9 +2251,6 @@ static int
 pymalloc_free(void *ctx, void *p)
 {
     poolp pool;
-    block *lastfree;
-    poolp next, prev;
-    uint size;
 
     assert(p != NULL);
 
@@ -1612,6 +2266,21 @@ pymalloc_free(void *ctx, void *p)
     }
     /* We allocated this address. */
 
+    if (!pymalloc_cache_push(pool, (block *)p)) {
+        pymalloc_free_block(pool, (block *)p);
+    }
+    return 1;
+}
+
+
+/* Give the block p back to its pool */
+static void
+pymalloc_free_block(poolp pool, block *p)
+{
+    block *lastfree;
+    poolp next, prev;
+    uint size;
+
     LOCK();
 
     /* Link p to the start of the pool's freeblock list.  Since
@@ -1622,7 +2291,7 @@ pymalloc_free(void *ctx, void *p)
      */
     assert(pool->ref.count > 0);            /* else it was empty */
     *(block **)p = lastfree = pool->freeblock;
-    pool->freeblock = (block *)p;
+    pool->freeblock = p;
     if (!lastfree) {
         /* Pool was full, so doesn't currently live in any list:
          * link it to the front of the appropriate usedpools[] list.
@@ -1718,6 +2387,9 @@ pymalloc_free(void *ctx, void *p)
         unused_arena_objects = ao;
 
         /* Free the entire arena. */
+#if WITH_PYMALLOC_RADIX_TREE
+        arena_map_mark_used(ao->address, 0);
+#endif
         _PyObject_Arena.free(_PyObject_Arena.ctx,
                              (void *)ao->address, ARENA_SIZE);
         ao->address = 0;                        /* mark unassociated */
@@ -1799,7 +2471,6 @@ pymalloc_free(void *ctx, void *p)
 
 success:
     UNLOCK();
-    return 1;
 }
 
 
@@ -1819,6 +2490,72 @@ _PyObject_Free(void *ctx, void *p)
 }
 
 
+/* Give the memory of the free pools of all arenas back to the system,
+   after flushing the thread caches.  The pools stay available: they are
+   used again, and paged in again by the system, once the other free pools
+   of their arena are exhausted.  Fully free arenas are already released by
+   pymalloc_free_block().
+
+   If lazy is non-zero, use MADV_FREE where it is available: the system only
+   reclaims the pages under memory pressure, which is cheaper if they are
+   reused soon, but they still count in the resident set size until then.
+
+   Return the number of bytes given back to the system. */
+size_t
+_PyObject_TrimArenas(int lazy)
+{
+    size_t released = 0;
+#if defined(ARENAS_USE_MMAP) && defined(MADV_DONTNEED)
+    static long page_size = 0;
+    uint i;
+
+    if (page_size == 0) {
+        page_size = sysconf(_SC_PAGESIZE);
+    }
+    if (page_size <= 0 || POOL_SIZE % page_size != 0) {
+        /* Pools must be made of whole pages */
+        return 0;
+    }
+
+    pymalloc_clear_all_caches();
+    ntimes_trimmed++;
+    for (i = 0; i < maxarenas; ++i) {
+        struct arena_object *ao = &arenas[i];
+        poolp pool, next;
+
+        if (ao->address == 0) {
+            continue;
+        }
+        for (pool = ao->freepools; pool != NULL; pool = next) {
+            int advice = MADV_DONTNEED;
+            next = pool->nextpool;
+            memset(pool, 0, POOL_OVERHEAD);
+#ifdef MADV_FREE
+            if (lazy) {
+                advice = MADV_FREE;
+            }
+            if (madvise(pool, POOL_SIZE, advice) < 0 && advice == MADV_FREE) {
+                /* MADV_FREE is not supported by the running kernel */
+                advice = MADV_DONTNEED;
+                (void)madvise(pool, POOL_SIZE, advice);
+            }
+#else
+            (void)madvise(pool, POOL_SIZE, advice);
+#endif
+            ao->ntrimmedpools++;
+            if ((block *)pool < ao->trimmed_address) {
+                ao->trimmed_address = (block *)pool;
+            }
+            ntrimmed_pools_total++;
+            released += POOL_SIZE;
+        }
+        ao->freepools = NULL;
+    }
+#endif
+    return released;
+}
+
+
 /* pymalloc realloc.
 
    If nbytes==0, then as the Python docs promise, we do not treat this like
@@ -1917,6 +2654,35 @@ _Py_GetAllocatedBlocks(void)
     return 0;
 }
 
+void
+_PyObject_ClearThreadCache(PyThreadState *tstate)
+{
+}
+
+int
+_PyObject_SetThreadCacheEnabled(int enabled)
+{
+    return 0;
+}
+
+int
+_PyObject_GetThreadCacheEnabled(void)
+{
+    return 0;
+}
+
+const char *
+_PyObject_SetArenaConfig(size_t size, int hugepages)
+{
+    return "arenas require pymalloc";
+}
+
+size_t
+_PyObject_TrimArenas(int lazy)
+{
+    return 0;
+}
+
 #endif /* WITH_PYMALLOC */
 
 
@@ -2464,6 +3230,52 @@ pool_is_in_list(const poolp target, poolp list)
 }
 #endif
 
+#ifdef __linux__
+/* Return non-zero if the address range [start:end) contains an arena */
+static int
+range_has_arena(uintptr_t start, uintptr_t end)
+{
+    uint i;
+    for (i = 0; i < maxarenas; ++i) {
+        if (arenas[i].address != 0 &&
+            arenas[i].address >= start && arenas[i].address < end) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Return the number of bytes of the mappings containing arenas which are
+   backed by transparent huge pages, according to /proc/self/smaps.  Return
+   (size_t)-1 if the file cannot be read. */
+static size_t
+arena_huge_page_bytes(void)
+{
+    FILE *fp;
+    char line[4096];
+    unsigned long long start, end;
+    unsigned long kb;
+    int has_arena = 0;
+    size_t total = 0;
+
+    fp = fopen("/proc/self/smaps", "r");
+    if (fp == NULL) {
+        return (size_t)-1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "%llx-%llx ", &start, &end) == 2) {
+            has_arena = range_has_arena((uintptr_t)start, (uintptr_t)end);
+        }
+        else if (has_arena &&
+                 sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+            total += (size_t)kb * 1024;
+        }
+    }
+    fclose(fp);
+    return total;
+}
+#endif
+
 /* Print summary info to "out" about the state of pymalloc's structures.
  * In Py_DEBUG mode, also perform some expensive internal consistency
  * checks.
@@ -2490,10 +3302,14 @@ _PyObject_DebugMallocStats(FILE *out)
     size_t available_bytes = 0;
     /* # of free pools + pools not yet carved out of current arena */
     uint numfreepools = 0;
+    /* # of free pools given back to the system */
+    size_t numtrimmedpools = 0;
     /* # of bytes for arena alignment padding */
     size_t arena_alignment = 0;
     /* # of bytes in used and full pools used for pool_headers */
     size_t pool_header_bytes = 0;
+    /* total # of bytes in blocks held by the thread caches */
+    size_t cached_bytes = 0;
     /* # of bytes in used and full pools wasted due to quantization,
      * i.e. the necessarily leftover space at the ends of used and
      * full pools.
@@ -2525,6 +3341,7 @@ _PyObject_DebugMallocStats(FILE *out)
         narenas += 1;
 
         numfreepools += arenas[i].nfreepools;
+        numtrimmedpools += arenas[i].ntrimmedpools;
 
         /* round up to pool alignment */
         if (base & (uintptr_t)POOL_SIZE_MASK) {
@@ -2544,7 +3361,8 @@ _PyObject_DebugMallocStats(FILE *out)
             if (p->ref.count == 0) {
                 /* currently unused */
 #ifdef Py_DEBUG
-                assert(pool_is_in_list(p, arenas[i].freepools));
+                assert(p->nextoffset == 0 ||
+                       pool_is_in_list(p, arenas[i].freepools));
 #endif
                 continue;
             }
@@ -2581,6 +3399,7 @@ _PyObject_DebugMallocStats(FILE *out)
                 i, size, p, b, f);
         allocated_bytes += b * size;
         available_bytes += f * size;
+        cached_bytes += pymalloc_cached_blocks(i) * size;
         pool_header_bytes += p * POOL_OVERHEAD;
         quantization += p * ((POOL_SIZE - POOL_OVERHEAD) % size);
     }
@@ -2593,9 +3412,32 @@ _PyObject_DebugMallocStats(FILE *out)
     (void)printone(out, "# arenas allocated current", narenas);
 
     PyOS_snprintf(buf, sizeof(buf),
-        "%" PY_FORMAT_SIZE_T "u arenas * %d bytes/arena",
+        "%" PY_FORMAT_SIZE_T "u arenas * %" PY_FORMAT_SIZE_T "u bytes/arena",
         narenas, ARENA_SIZE);
     (void)printone(out, buf, narenas * ARENA_SIZE);
+#ifdef ARENAS_USE_MMAP
+    if (_PyObject_Arena.alloc == _PyObject_ArenaMmap
+        || _PyObject_Arena.alloc == _PyObject_ArenaHugeAlloc) {
+        (void)printone(out, "# arena mappings", narena_mappings);
+    }
+#endif
+#ifdef __linux__
+    {
+        size_t huge_bytes = arena_huge_page_bytes();
+        if (huge_bytes != (size_t)-1) {
+            (void)printone(out, "# bytes in huge pages", huge_bytes);
+        }
+    }
+#endif
+    (void)printone(out, "# bytes in thread caches", cached_bytes);
+#if WITH_PYMALLOC_RADIX_TREE
+    (void)printone(out, "# arena map nodes",
+                   arena_map_mid_count + arena_map_leaf_count);
+    (void)printone(out, "# bytes in arena map nodes", arena_map_bytes);
+#endif
+    (void)printone(out, "# times arenas trimmed", ntimes_trimmed);
+    (void)printone(out, "# pools trimmed total", ntrimmed_pools_total);
+    (void)printone(out, "# trimmed pools reused", ntrimmed_pools_reused);
 
     fputc('\n', out);
 
@@ -2606,6 +3448,10 @@ _PyObject_DebugMallocStats(FILE *out)
         "%u unused pools * %d bytes", numfreepools, POOL_SIZE);
     total += printone(out, buf, (size_t)numfreepools * POOL_SIZE);
 
+    PyOS_snprintf(buf, sizeof(buf),
+        "    of which %" PY_FORMAT_SIZE_T "u trimmed", numtrimmedpools);
+    (void)printone(out, buf, numtrimmedpools * POOL_SIZE);
+
     total += printone(out, "# bytes lost to pool headers", pool_header_bytes);
     total += printone(out, "# bytes lost to quantization", quantization);
     total += printone(out, "# bytes lost to arena alignment", arena_alignment);
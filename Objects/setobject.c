@@ -976,10 +976,31 @@ set_iter(PySetObject *so)
     return (PyObject *)si;
 }
 
+/* Number of items of a length hint trusted before adding any */
+#define SET_PRESIZE_SAMPLE 1024
+
+/* Grow the table ahead of adding `hint` more keys.  It is only an
+ * estimate: go on without it if memory is short.  Returns 1 if the table
+ * was grown, 0 if not.
+ */
+static int
+set_presize(PySetObject *so, Py_ssize_t hint)
+{
+    if (hint > 0 && hint <= (PY_SSIZE_T_MAX >> 3) - so->used &&
+            (so->fill + hint)*5 >= so->mask*3) {
+        if (set_table_resize(so, (so->used + hint)*2) == 0)
+            return 1;
+        PyErr_Clear();
+    }
+    return 0;
+}
+
 static int
 set_update_internal(PySetObject *so, PyObject *other)
 {
     PyObject *key, *it;
+    Py_ssize_t hint, i = 0, used;
+    int presized = 0;
 
     if (PyAnySet_Check(other))
         return set_merge(so, other);
@@ -1011,6 +1032,20 @@ set_update_internal(PySetObject *so, PyObject *other)
     if (it == NULL)
         return -1;
 
+    /* Presize from a length hint too.  It counts duplicates, so trust at
+     * most SET_PRESIZE_SAMPLE items of it first.  Once that many were
+     * added, trust the rest of it scaled by the fraction of them which
+     * were new, and give the memory back afterwards if the set still
+     * ended up much smaller.
+     */
+    hint = PyObject_LengthHint(other, 0);
+    if (hint < 0) {
+        Py_DECREF(it);
+        return -1;
+    }
+    used = so->used;
+    presized = set_presize(so, Py_MIN(hint, SET_PRESIZE_SAMPLE));
+
     while ((key = PyIter_Next(it)) != NULL) {
         if (set_add_key(so, key)) {
             Py_DECREF(it);
@@ -1018,10 +1053,20 @@ set_update_internal(PySetObject *so, PyObject *other)
             return -1;
         }
         Py_DECREF(key);
+        if (++i == SET_PRESIZE_SAMPLE && hint > SET_PRESIZE_SAMPLE) {
+            Py_ssize_t rest = hint - SET_PRESIZE_SAMPLE;
+            Py_ssize_t added = so->used - used;
+            /* rest * added / SET_PRESIZE_SAMPLE, without overflow */
+            rest = (rest / SET_PRESIZE_SAMPLE * added
+                    + rest % SET_PRESIZE_SAMPLE * added / SET_PRESIZE_SAMPLE);
+            presized |= set_presize(so, rest);
+        }
     }
     Py_DECREF(it);
     if (PyErr_Occurred())
         return -1;
+    if (presized && so->mask >= PySet_MINSIZE*8 && so->used*8 <= so->mask)
+        return set_table_resize(so, so->used>50000 ? so->used*2 : so->used*4);
     return 0;
 }
 
@@ -1089,16 +1134,24 @@ make_new_set_basetype(PyTypeObject *type, PyObject *iterable)
 /* The empty frozenset is a singleton */
 static PyObject *emptyfrozenset = NULL;
 
-static PyObject *
-frozenset_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+/* Untrack a frozenset just built if all its items are atomic */
+static void
+frozenset_untrack_new(PySetObject *so)
 {
-    PyObject *iterable = NULL, *result;
+    setentry *entry;
+    Py_ssize_t pos = 0;
 
-    if (type == &PyFrozenSet_Type && !_PyArg_NoKeywords("frozenset", kwds))
-        return NULL;
+    while (set_next(so, &pos, &entry)) {
+        if (_PyObject_GC_MAY_BE_TRACKED(entry->key))
+            return;
+    }
+    _PyGC_UNTRACK_NEW(so);
+}
 
-    if (!PyArg_UnpackTuple(args, type->tp_name, 0, 1, &iterable))
-        return NULL;
+static PyObject *
+make_new_frozenset(PyTypeObject *type, PyObject *iterable)
+{
+    PyObject *result;
 
     if (type != &PyFrozenSet_Type)
         return make_new_set(type, iterable);
@@ -1110,8 +1163,12 @@ frozenset_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
             return iterable;
         }
         result = make_new_set(type, iterable);
-        if (result == NULL || PySet_GET_SIZE(result))
+        if (result == NULL)
+            return NULL;
+        if (PySet_GET_SIZE(result)) {
+            frozenset_untrack_new((PySetObject *)result);
             return result;
+        }
         Py_DECREF(result);
     }
     /* The empty frozenset is a singleton */
@@ -1121,12 +1178,51 @@ frozenset_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     return emptyfrozenset;
 }
 
+static PyObject *
+frozenset_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    PyObject *iterable = NULL;
+
+    if (type == &PyFrozenSet_Type && !_PyArg_NoKeywords("frozenset", kwds))
+        return NULL;
+
+    if (!PyArg_UnpackTuple(args, type->tp_name, 0, 1, &iterable))
+        return NULL;
+
+    return make_new_frozenset(type, iterable);
+}
+
+/* Call frozenset() without a tuple of the arguments */
+static PyObject *
+frozenset_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+                     PyObject *kwnames)
+{
+    assert(type == (PyObject *)&PyFrozenSet_Type);
+    if (kwnames == NULL && nargs <= 1) {
+        return make_new_frozenset(&PyFrozenSet_Type,
+                                  nargs == 1 ? args[0] : NULL);
+    }
+    return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+}
+
 static PyObject *
 set_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
     return make_new_set(type, NULL);
 }
 
+/* Call set() without a tuple of the arguments */
+static PyObject *
+set_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+               PyObject *kwnames)
+{
+    assert(type == (PyObject *)&PySet_Type);
+    if (kwnames == NULL && nargs <= 1) {
+        return make_new_set(&PySet_Type, nargs == 1 ? args[0] : NULL);
+    }
+    return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+}
+
 /* set_swap_bodies() switches the contents of any two sets by moving their
    internal data pointers and, if needed, copying the internal smalltables.
    Semantically equivalent to:
@@ -2177,6 +2273,17 @@ PyTypeObject PySet_Type = {
     PyType_GenericAlloc,                /* tp_alloc */
     set_new,                            /* tp_new */
     PyObject_GC_Del,                    /* tp_free */
+    0,                                  /* tp_is_gc */
+    0,                                  /* tp_bases */
+    0,                                  /* tp_mro */
+    0,                                  /* tp_cache */
+    0,                                  /* tp_subclasses */
+    0,                                  /* tp_weaklist */
+    0,                                  /* tp_del */
+    0,                                  /* tp_version_tag */
+    0,                                  /* tp_finalize */
+    0,                                  /* tp_vectorcall_offset */
+    set_vectorcall,                     /* tp_vectorcall */
 };
 
 /* frozenset object ********************************************************/
@@ -2275,6 +2382,17 @@ PyTypeObject PyFrozenSet_Type = {
     PyType_GenericAlloc,                /* tp_alloc */
     frozenset_new,                      /* tp_new */
     PyObject_GC_Del,                    /* tp_free */
+    0,                                  /* tp_is_gc */
+    0,                                  /* tp_bases */
+    0,                                  /* tp_mro */
+    0,                                  /* tp_cache */
+    0,                                  /* tp_subclasses */
+    0,                                  /* tp_weaklist */
+    0,                                  /* tp_del */
+    0,                                  /* tp_version_tag */
+    0,                                  /* tp_finalize */
+    0,                                  /* tp_vectorcall_offset */
+    frozenset_vectorcall,               /* tp_vectorcall */
 };
 
 
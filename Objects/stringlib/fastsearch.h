@@ -4,7 +4,12 @@
 
 /* fast search/count implementation, based on a mix between boyer-
    moore and horspool, with a few more bells and whistles on the top.
-   for some more background, see: http://effbot.org/zone/stringlib.htm */
+   for some more background, see: http://effbot.org/zone/stringlib.htm
+
+   long needles in long haystacks are searched with the two-way algorithm
+   of Crochemore and Perrin, which runs in linear time whatever the input,
+   and short needles in 1-byte strings are filtered 16 positions at a time
+   with SSE2 when it is available. */
 
 /* note: fastsearch may access s[n], which isn't a problem when using
    Python's ordinary string types, but may cause problems if you're
@@ -160,18 +165,539 @@ STRINGLIB(rfind_char)(const STRINGLIB_CHAR* s, Py_ssize_t n, STRINGLIB_CHAR ch)
 
 #undef MEMCHR_CUT_OFF
 
+/* the two-way algorithm splits the needle in two halves at a "critical
+   factorization": the right half is matched from left to right, then the
+   left half; after a mismatch in the right half the window moves past the
+   mismatch, after a mismatch in the left half it moves by the period of the
+   needle.  see M. Crochemore and D. Perrin, "Two-way string-matching",
+   Journal of the ACM 38(3), 1991, and
+   http://www-igm.univ-mlv.fr/~lecroq/string/node26.html */
+
+/* return the start of the maximal suffix of the needle, for the order of
+   the characters or its inverse, and store the period of the suffix in
+   *return_period */
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(_lex_search)(const STRINGLIB_CHAR *needle, Py_ssize_t len_needle,
+                       Py_ssize_t *return_period, int invert_alphabet)
+{
+    Py_ssize_t max_suffix = 0;
+    Py_ssize_t candidate = 1;
+    Py_ssize_t k = 0;
+    Py_ssize_t period = 1;
+
+    while (candidate + k < len_needle) {
+        STRINGLIB_CHAR a = needle[candidate + k];
+        STRINGLIB_CHAR b = needle[max_suffix + k];
+        if (invert_alphabet ? (b < a) : (a < b)) {
+            /* the suffix at candidate is smaller: none of the k + 1
+               characters scanned from candidate starts a maximal suffix */
+            candidate += k + 1;
+            k = 0;
+            period = candidate - max_suffix;
+        }
+        else if (a == b) {
+            if (k + 1 != period) {
+                k++;
+            }
+            else {
+                /* matched a whole period: start matching the next one */
+                candidate += period;
+                k = 0;
+            }
+        }
+        else {
+            /* the suffix at candidate is larger: it becomes the maximum */
+            max_suffix = candidate;
+            candidate++;
+            k = 0;
+            period = 1;
+        }
+    }
+    *return_period = period;
+    return max_suffix;
+}
+
+/* the later of the two maximal suffixes gives a critical factorization */
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(_factorize)(const STRINGLIB_CHAR *needle, Py_ssize_t len_needle,
+                      Py_ssize_t *return_period)
+{
+    Py_ssize_t cut1, period1, cut2, period2;
+
+    cut1 = STRINGLIB(_lex_search)(needle, len_needle, &period1, 0);
+    cut2 = STRINGLIB(_lex_search)(needle, len_needle, &period2, 1);
+    if (cut1 > cut2) {
+        *return_period = period1;
+        return cut1;
+    }
+    *return_period = period2;
+    return cut2;
+}
+
+/* the windows are first moved with a compressed horspool "bad character"
+   table, indexed by the low bits of the characters */
+#define TWOWAY_SHIFT_TYPE uint8_t
+#define TWOWAY_MAX_SHIFT UINT8_MAX
+#define TWOWAY_TABLE_SIZE_BITS 6U
+#define TWOWAY_TABLE_SIZE (1U << TWOWAY_TABLE_SIZE_BITS)
+#define TWOWAY_TABLE_MASK (TWOWAY_TABLE_SIZE - 1U)
+
+typedef struct {
+    const STRINGLIB_CHAR *needle;
+    Py_ssize_t len_needle;
+    Py_ssize_t cut;
+    Py_ssize_t period;
+    Py_ssize_t gap;
+    int is_periodic;
+    TWOWAY_SHIFT_TYPE table[TWOWAY_TABLE_SIZE];
+} STRINGLIB(prework);
+
+Py_LOCAL_INLINE(void)
+STRINGLIB(_preprocess)(const STRINGLIB_CHAR *needle, Py_ssize_t len_needle,
+                       STRINGLIB(prework) *p)
+{
+    Py_ssize_t i, not_found_shift;
+
+    p->needle = needle;
+    p->len_needle = len_needle;
+    p->cut = STRINGLIB(_factorize)(needle, len_needle, &p->period);
+    assert(p->period + p->cut <= len_needle);
+    p->is_periodic = (0 == memcmp(needle, needle + p->period,
+                                  p->cut * STRINGLIB_SIZEOF_CHAR));
+    if (p->is_periodic) {
+        assert(p->cut <= len_needle / 2);
+        assert(p->cut < p->period);
+        p->gap = 0;     /* unused */
+    }
+    else {
+        unsigned int last;
+
+        /* a lower bound on the period */
+        p->period = Py_MAX(p->cut, len_needle - p->cut) + 1;
+        /* the distance from the last character to the previous character
+           with the same entry in the table: windows can move by that
+           much when the right half mismatches early */
+        p->gap = len_needle;
+        last = needle[len_needle - 1] & TWOWAY_TABLE_MASK;
+        for (i = len_needle - 2; i >= 0; i--) {
+            if ((needle[i] & TWOWAY_TABLE_MASK) == last) {
+                p->gap = len_needle - 1 - i;
+                break;
+            }
+        }
+    }
+    not_found_shift = Py_MIN(len_needle, TWOWAY_MAX_SHIFT);
+    for (i = 0; i < (Py_ssize_t)TWOWAY_TABLE_SIZE; i++) {
+        p->table[i] = Py_SAFE_DOWNCAST(not_found_shift,
+                                       Py_ssize_t, TWOWAY_SHIFT_TYPE);
+    }
+    for (i = len_needle - not_found_shift; i < len_needle; i++) {
+        p->table[needle[i] & TWOWAY_TABLE_MASK] =
+            Py_SAFE_DOWNCAST(len_needle - 1 - i,
+                             Py_ssize_t, TWOWAY_SHIFT_TYPE);
+    }
+}
+
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(_two_way)(const STRINGLIB_CHAR *haystack, Py_ssize_t len_haystack,
+                    STRINGLIB(prework) *p)
+{
+    const Py_ssize_t len_needle = p->len_needle;
+    const Py_ssize_t cut = p->cut;
+    Py_ssize_t period = p->period;
+    const STRINGLIB_CHAR *const needle = p->needle;
+    const STRINGLIB_CHAR *window_last = haystack + len_needle - 1;
+    const STRINGLIB_CHAR *const haystack_end = haystack + len_haystack;
+    TWOWAY_SHIFT_TYPE *table = p->table;
+    const STRINGLIB_CHAR *window;
+    Py_ssize_t i, shift;
+
+    if (p->is_periodic) {
+        /* the first "memory" characters of the window are known to match
+           after a shift by the period */
+        Py_ssize_t memory = 0;
+      periodicwindowloop:
+        while (window_last < haystack_end) {
+            assert(memory == 0);
+            for (;;) {
+                shift = table[(*window_last) & TWOWAY_TABLE_MASK];
+                window_last += shift;
+                if (shift == 0)
+                    break;
+                if (window_last >= haystack_end)
+                    return -1;
+            }
+          no_shift:
+            window = window_last - len_needle + 1;
+            assert((window[len_needle - 1] & TWOWAY_TABLE_MASK) ==
+                   (needle[len_needle - 1] & TWOWAY_TABLE_MASK));
+            for (i = Py_MAX(cut, memory); i < len_needle; i++) {
+                if (needle[i] != window[i]) {
+                    /* right half mismatch */
+                    window_last += i - cut + 1;
+                    memory = 0;
+                    goto periodicwindowloop;
+                }
+            }
+            for (i = memory; i < cut; i++) {
+                if (needle[i] != window[i]) {
+                    /* left half mismatch */
+                    window_last += period;
+                    memory = len_needle - period;
+                    if (window_last >= haystack_end)
+                        return -1;
+                    shift = table[(*window_last) & TWOWAY_TABLE_MASK];
+                    if (shift) {
+                        /* the new window mismatches right of where the
+                           comparisons would resume: jump at least as far
+                           as for a mismatch on the first comparison */
+                        Py_ssize_t mem_jump = Py_MAX(cut, memory) - cut + 1;
+                        memory = 0;
+                        window_last += Py_MAX(shift, mem_jump);
+                        goto periodicwindowloop;
+                    }
+                    goto no_shift;
+                }
+            }
+            return window - haystack;
+        }
+    }
+    else {
+        Py_ssize_t gap = p->gap;
+        Py_ssize_t gap_jump_end = Py_MIN(len_needle, cut + gap);
+
+        period = Py_MAX(gap, period);
+      windowloop:
+        while (window_last < haystack_end) {
+            for (;;) {
+                shift = table[(*window_last) & TWOWAY_TABLE_MASK];
+                window_last += shift;
+                if (shift == 0)
+                    break;
+                if (window_last >= haystack_end)
+                    return -1;
+            }
+            window = window_last - len_needle + 1;
+            assert((window[len_needle - 1] & TWOWAY_TABLE_MASK) ==
+                   (needle[len_needle - 1] & TWOWAY_TABLE_MASK));
+            for (i = cut; i < gap_jump_end; i++) {
+                if (needle[i] != window[i]) {
+                    /* early right half mismatch: jump by the gap */
+                    assert(gap >= i - cut + 1);
+                    window_last += gap;
+                    goto windowloop;
+                }
+            }
+            for (i = gap_jump_end; i < len_needle; i++) {
+                if (needle[i] != window[i]) {
+                    /* late right half mismatch */
+                    assert(i - cut + 1 > gap);
+                    window_last += i - cut + 1;
+                    goto windowloop;
+                }
+            }
+            for (i = 0; i < cut; i++) {
+                if (needle[i] != window[i]) {
+                    /* left half mismatch */
+                    window_last += period;
+                    goto windowloop;
+                }
+            }
+            return window - haystack;
+        }
+    }
+    return -1;
+}
+
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(_two_way_find)(const STRINGLIB_CHAR *haystack,
+                         Py_ssize_t len_haystack,
+                         const STRINGLIB_CHAR *needle,
+                         Py_ssize_t len_needle)
+{
+    STRINGLIB(prework) p;
+    STRINGLIB(_preprocess)(needle, len_needle, &p);
+    return STRINGLIB(_two_way)(haystack, len_haystack, &p);
+}
+
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(_two_way_count)(const STRINGLIB_CHAR *haystack,
+                          Py_ssize_t len_haystack,
+                          const STRINGLIB_CHAR *needle,
+                          Py_ssize_t len_needle,
+                          Py_ssize_t maxcount)
+{
+    STRINGLIB(prework) p;
+    Py_ssize_t index = 0, count = 0, result;
+
+    STRINGLIB(_preprocess)(needle, len_needle, &p);
+    for (;;) {
+        result = STRINGLIB(_two_way)(haystack + index,
+                                     len_haystack - index, &p);
+        if (result == -1)
+            return count;
+        count++;
+        if (count == maxcount)
+            return maxcount;
+        index += result + len_needle;
+    }
+}
+
+#undef TWOWAY_SHIFT_TYPE
+#undef TWOWAY_MAX_SHIFT
+#undef TWOWAY_TABLE_SIZE_BITS
+#undef TWOWAY_TABLE_SIZE
+#undef TWOWAY_TABLE_MASK
+
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(default_find)(const STRINGLIB_CHAR* s, Py_ssize_t n,
+                        const STRINGLIB_CHAR* p, Py_ssize_t m,
+                        Py_ssize_t maxcount, int mode)
+{
+    const Py_ssize_t w = n - m;
+    const Py_ssize_t mlast = m - 1;
+    Py_ssize_t skip = mlast - 1;
+    Py_ssize_t count = 0;
+    Py_ssize_t i, j;
+    unsigned long mask = 0;
+    const STRINGLIB_CHAR *ss = s + m - 1;
+    const STRINGLIB_CHAR *pp = p + m - 1;
+
+    /* create compressed boyer-moore delta 1 table */
+
+    /* process pattern[:-1] */
+    for (i = 0; i < mlast; i++) {
+        STRINGLIB_BLOOM_ADD(mask, p[i]);
+        if (p[i] == p[mlast])
+            skip = mlast - i - 1;
+    }
+    /* process pattern[-1] outside the loop */
+    STRINGLIB_BLOOM_ADD(mask, p[mlast]);
+
+    for (i = 0; i <= w; i++) {
+        /* note: using mlast in the skip path slows things down on x86 */
+        if (ss[i] == pp[0]) {
+            /* candidate match */
+            for (j = 0; j < mlast; j++)
+                if (s[i+j] != p[j])
+                    break;
+            if (j == mlast) {
+                /* got a match! */
+                if (mode != FAST_COUNT)
+                    return i;
+                count++;
+                if (count == maxcount)
+                    return maxcount;
+                i = i + mlast;
+                continue;
+            }
+            /* miss: check if next character is part of pattern */
+            if (!STRINGLIB_BLOOM(mask, ss[i+1]))
+                i = i + m;
+            else
+                i = i + skip;
+        } else {
+            /* skip: check if next character is part of pattern */
+            if (!STRINGLIB_BLOOM(mask, ss[i+1]))
+                i = i + m;
+        }
+    }
+    return mode == FAST_COUNT ? count : -1;
+}
+
+/* same as default_find(), but switch to the two-way algorithm once the
+   candidate matches have compared more than m/4 characters: the needle and
+   the haystack are then repetitive enough for its setup to pay off */
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(adaptive_find)(const STRINGLIB_CHAR* s, Py_ssize_t n,
+                         const STRINGLIB_CHAR* p, Py_ssize_t m,
+                         Py_ssize_t maxcount, int mode)
+{
+    const Py_ssize_t w = n - m;
+    const Py_ssize_t mlast = m - 1;
+    Py_ssize_t skip = mlast - 1;
+    Py_ssize_t count = 0, hits = 0, res;
+    Py_ssize_t i, j;
+    unsigned long mask = 0;
+    const STRINGLIB_CHAR *ss = s + m - 1;
+    const STRINGLIB_CHAR *pp = p + m - 1;
+
+    for (i = 0; i < mlast; i++) {
+        STRINGLIB_BLOOM_ADD(mask, p[i]);
+        if (p[i] == p[mlast])
+            skip = mlast - i - 1;
+    }
+    STRINGLIB_BLOOM_ADD(mask, p[mlast]);
+
+    for (i = 0; i <= w; i++) {
+        if (ss[i] == pp[0]) {
+            for (j = 0; j < mlast; j++)
+                if (s[i+j] != p[j])
+                    break;
+            if (j == mlast) {
+                if (mode != FAST_COUNT)
+                    return i;
+                count++;
+                if (count == maxcount)
+                    return maxcount;
+                i = i + mlast;
+                continue;
+            }
+            hits += j + 1;
+            if (hits > m / 4 && w - i > 2000) {
+                if (mode == FAST_SEARCH) {
+                    res = STRINGLIB(_two_way_find)(s + i, n - i, p, m);
+                    return res == -1 ? -1 : res + i;
+                }
+                res = STRINGLIB(_two_way_count)(s + i, n - i, p, m,
+                                                maxcount - count);
+                return res + count;
+            }
+            if (!STRINGLIB_BLOOM(mask, ss[i+1]))
+                i = i + m;
+            else
+                i = i + skip;
+        } else {
+            if (!STRINGLIB_BLOOM(mask, ss[i+1]))
+                i = i + m;
+        }
+    }
+    return mode == FAST_COUNT ? count : -1;
+}
+
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(default_rfind)(const STRINGLIB_CHAR* s, Py_ssize_t n,
+                         const STRINGLIB_CHAR* p, Py_ssize_t m)
+{
+    const Py_ssize_t w = n - m;
+    const Py_ssize_t mlast = m - 1;
+    Py_ssize_t skip = mlast - 1;
+    Py_ssize_t i, j;
+    unsigned long mask = 0;
+
+    /* create compressed boyer-moore delta 1 table */
+
+    /* process pattern[0] outside the loop */
+    STRINGLIB_BLOOM_ADD(mask, p[0]);
+    /* process pattern[:0:-1] */
+    for (i = mlast; i > 0; i--) {
+        STRINGLIB_BLOOM_ADD(mask, p[i]);
+        if (p[i] == p[0])
+            skip = i - 1;
+    }
+
+    for (i = w; i >= 0; i--) {
+        if (s[i] == p[0]) {
+            /* candidate match */
+            for (j = mlast; j > 0; j--)
+                if (s[i+j] != p[j])
+                    break;
+            if (j == 0)
+                /* got a match! */
+                return i;
+            /* miss: check if previous character is part of pattern */
+            if (i > 0 && !STRINGLIB_BLOOM(mask, s[i-1]))
+                i = i - m;
+            else
+                i = i - skip;
+        } else {
+            /* skip: check if previous character is part of pattern */
+            if (i > 0 && !STRINGLIB_BLOOM(mask, s[i-1]))
+                i = i - m;
+        }
+    }
+    return -1;
+}
+
+#if STRINGLIB_SIZEOF_CHAR == 1 && \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define STRINGLIB_HAVE_SSE2
+#  include <emmintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#endif
+
+#ifdef STRINGLIB_HAVE_SSE2
+
+/* longest needle searched with sse2_find() */
+#define SSE2_MAX_NEEDLE 32
+
+/* search 16 positions at a time: compare the first and the last character
+   of the needle with 16 characters of the haystack each, and only compare
+   the rest of the needle where both match.  see Wojciech Mula, "SIMD-
+   friendly algorithms for substring searching",
+   http://0x80.pl/articles/simd-strfind.html */
+Py_LOCAL_INLINE(Py_ssize_t)
+STRINGLIB(sse2_find)(const STRINGLIB_CHAR* s, Py_ssize_t n,
+                     const STRINGLIB_CHAR* p, Py_ssize_t m,
+                     Py_ssize_t maxcount, int mode)
+{
+    const __m128i first = _mm_set1_epi8((char)p[0]);
+    const __m128i last = _mm_set1_epi8((char)p[m - 1]);
+    const Py_ssize_t w = n - m;
+    Py_ssize_t i = 0, count = 0, res;
+
+    /* the block at i covers the windows i to i + 15 */
+    while (i + 15 <= w) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(s + i + m - 1));
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first),
+                          _mm_cmpeq_epi8(b, last)));
+        Py_ssize_t next = i + 16;
+
+        while (bits) {
+            Py_ssize_t k;
+#if defined(__GNUC__) || defined(__clang__)
+            k = __builtin_ctz(bits);
+#elif defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, bits);
+            k = (Py_ssize_t)index;
+#else
+            for (k = 0; !(bits & (1U << k)); k++)
+                ;
+#endif
+            if (memcmp(s + i + k + 1, p + 1, m - 2) == 0) {
+                /* got a match! */
+                if (mode != FAST_COUNT)
+                    return i + k;
+                count++;
+                if (count == maxcount)
+                    return maxcount;
+                /* matches don't overlap: drop the windows it covers */
+                if (k + m >= 16) {
+                    next = i + k + m;
+                    break;
+                }
+                bits &= ~0U << (k + m);
+                continue;
+            }
+            bits &= bits - 1;
+        }
+        i = next;
+    }
+
+    if (i > w)
+        return mode == FAST_COUNT ? count : -1;
+    res = STRINGLIB(default_find)(s + i, n - i, p, m, maxcount - count, mode);
+    if (mode == FAST_COUNT)
+        return count + res;
+    return res == -1 ? -1 : i + res;
+}
+
+#endif  /* STRINGLIB_HAVE_SSE2 */
+
 Py_LOCAL_INLINE(Py_ssize_t)
 FASTSEARCH(const STRINGLIB_CHAR* s, Py_ssize_t n,
            const STRINGLIB_CHAR* p, Py_ssize_t m,
            Py_ssize_t maxcount, int mode)
 {
-    unsigned long mask;
-    Py_ssize_t skip, count = 0;
-    Py_ssize_t i, j, mlast, w;
+    Py_ssize_t i, count = 0;
 
-    w = n - m;
-
-    if (w < 0 || (mode == FAST_COUNT && maxcount == 0))
+    if (n < m || (mode == FAST_COUNT && maxcount == 0))
         return -1;
 
     /* look for special cases */
@@ -195,90 +721,31 @@ FASTSEARCH(const STRINGLIB_CHAR* s, Py_ssize_t n,
         return -1;
     }
 
-    mlast = m - 1;
-    skip = mlast - 1;
-    mask = 0;
-
-    if (mode != FAST_RSEARCH) {
-        const STRINGLIB_CHAR *ss = s + m - 1;
-        const STRINGLIB_CHAR *pp = p + m - 1;
-
-        /* create compressed boyer-moore delta 1 table */
-
-        /* process pattern[:-1] */
-        for (i = 0; i < mlast; i++) {
-            STRINGLIB_BLOOM_ADD(mask, p[i]);
-            if (p[i] == p[mlast])
-                skip = mlast - i - 1;
-        }
-        /* process pattern[-1] outside the loop */
-        STRINGLIB_BLOOM_ADD(mask, p[mlast]);
-
-        for (i = 0; i <= w; i++) {
-            /* note: using mlast in the skip path slows things down on x86 */
-            if (ss[i] == pp[0]) {
-                /* candidate match */
-                for (j = 0; j < mlast; j++)
-                    if (s[i+j] != p[j])
-                        break;
-                if (j == mlast) {
-                    /* got a match! */
-                    if (mode != FAST_COUNT)
-                        return i;
-                    count++;
-                    if (count == maxcount)
-                        return maxcount;
-                    i = i + mlast;
-                    continue;
-                }
-                /* miss: check if next character is part of pattern */
-                if (!STRINGLIB_BLOOM(mask, ss[i+1]))
-                    i = i + m;
-                else
-                    i = i + skip;
-            } else {
-                /* skip: check if next character is part of pattern */
-                if (!STRINGLIB_BLOOM(mask, ss[i+1]))
-                    i = i + m;
-            }
-        }
-    } else {    /* FAST_RSEARCH */
+    if (mode == FAST_RSEARCH)
+        return STRINGLIB(default_rfind)(s, n, p, m);
 
-        /* create compressed boyer-moore delta 1 table */
-
-        /* process pattern[0] outside the loop */
-        STRINGLIB_BLOOM_ADD(mask, p[0]);
-        /* process pattern[:0:-1] */
-        for (i = mlast; i > 0; i--) {
-            STRINGLIB_BLOOM_ADD(mask, p[i]);
-            if (p[i] == p[0])
-                skip = i - 1;
-        }
-
-        for (i = w; i >= 0; i--) {
-            if (s[i] == p[0]) {
-                /* candidate match */
-                for (j = mlast; j > 0; j--)
-                    if (s[i+j] != p[j])
-                        break;
-                if (j == 0)
-                    /* got a match! */
-                    return i;
-                /* miss: check if previous character is part of pattern */
-                if (i > 0 && !STRINGLIB_BLOOM(mask, s[i-1]))
-                    i = i - m;
-                else
-                    i = i - skip;
-            } else {
-                /* skip: check if previous character is part of pattern */
-                if (i > 0 && !STRINGLIB_BLOOM(mask, s[i-1]))
-                    i = i - m;
-            }
-        }
+#ifdef STRINGLIB_HAVE_SSE2
+    if (m <= SSE2_MAX_NEEDLE)
+        return STRINGLIB(sse2_find)(s, n, p, m, maxcount, mode);
+#endif
+    /* the setup of the two-way algorithm only pays off for long inputs;
+       the default algorithm is quadratic at worst, which is bounded for
+       short needles in short haystacks */
+    if (n < 2500 || (m < 100 && n < 30000) || m < 6)
+        return STRINGLIB(default_find)(s, n, p, m, maxcount, mode);
+    /* the two-way algorithm beats the default one when the needle is not
+       a large part of the haystack (written to not overflow) */
+    if ((m >> 2) * 3 < (n >> 2)) {
+        if (mode == FAST_SEARCH)
+            return STRINGLIB(_two_way_find)(s, n, p, m);
+        return STRINGLIB(_two_way_count)(s, n, p, m, maxcount);
     }
-
-    if (mode != FAST_COUNT)
-        return -1;
-    return count;
+    /* otherwise, only switch to it when the input turns out to be
+       repetitive */
+    return STRINGLIB(adaptive_find)(s, n, p, m, maxcount, mode);
 }
 
+#ifdef STRINGLIB_HAVE_SSE2
+#  undef SSE2_MAX_NEEDLE
+#  undef STRINGLIB_HAVE_SSE2
+#endif
@@ -205,6 +205,29 @@ _PyTuple_MaybeUntrack(PyObject *op)
     _PyObject_GC_UNTRACK(op);
 }
 
+/* Untrack a tuple just built for Python code if all its items are atomic.
+   C code may still fill the tuples returned by the C API, so only the
+   tuples returned to Python code are checked, except the empty tuple
+   singleton.  Return op. */
+static PyObject *
+tuple_untrack_new(PyObject *op)
+{
+    Py_ssize_t i;
+
+    if (op == NULL || Py_SIZE(op) == 0 || !_PyObject_GC_IS_TRACKED(op))
+        return op;
+    for (i = 0; i < Py_SIZE(op); i++) {
+        if (_PyObject_GC_MAY_BE_TRACKED(PyTuple_GET_ITEM(op, i)))
+            return op;
+    }
+#ifdef SHOW_TRACK_COUNT
+    count_tracked--;
+    count_untracked++;
+#endif
+    _PyGC_UNTRACK_NEW(op);
+    return op;
+}
+
 PyObject *
 PyTuple_Pack(Py_ssize_t n, ...)
 {
@@ -426,7 +449,7 @@ tupleslice(PyTupleObject *a, Py_ssize_t ilow,
         Py_INCREF(v);
         dest[i] = v;
     }
-    return (PyObject *)np;
+    return tuple_untrack_new((PyObject *)np);
 }
 
 PyObject *
@@ -482,7 +505,7 @@ tupleconcat(PyTupleObject *a, PyObject *bb)
         Py_INCREF(v);
         dest[i] = v;
     }
-    return (PyObject *)np;
+    return tuple_untrack_new((PyObject *)np);
 #undef b
 }
 
@@ -520,7 +543,7 @@ tuplerepeat(PyTupleObject *a, Py_ssize_t n)
             p++;
         }
     }
-    return (PyObject *) np;
+    return tuple_untrack_new((PyObject *)np);
 }
 
 /*[clinic input]
@@ -680,8 +703,24 @@ tuple_new_impl(PyTypeObject *type, PyObject *iterable)
 
     if (iterable == NULL)
         return PyTuple_New(0);
+    else if (PyTuple_CheckExact(iterable)) {
+        Py_INCREF(iterable);
+        return iterable;
+    }
     else
-        return PySequence_Tuple(iterable);
+        return tuple_untrack_new(PySequence_Tuple(iterable));
+}
+
+/* Call tuple() without a tuple of the arguments */
+static PyObject *
+tuple_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+                 PyObject *kwnames)
+{
+    assert(type == (PyObject *)&PyTuple_Type);
+    if (kwnames == NULL && nargs <= 1) {
+        return tuple_new_impl(&PyTuple_Type, nargs == 1 ? args[0] : NULL);
+    }
+    return _PyObject_MakeTpCall(type, args, nargs, kwnames);
 }
 
 static PyObject *
@@ -763,7 +802,7 @@ tuplesubscript(PyTupleObject* self, PyObject* item)
                 dest[i] = it;
             }
 
-            return result;
+            return tuple_untrack_new(result);
         }
     }
     else {
@@ -841,6 +880,17 @@ PyTypeObject PyTuple_Type = {
     0,                                          /* tp_alloc */
     tuple_new,                                  /* tp_new */
     PyObject_GC_Del,                            /* tp_free */
+    0,                                          /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    0,                                          /* tp_vectorcall_offset */
+    tuple_vectorcall,                           /* tp_vectorcall */
 };
 
 /* The following function breaks the notion that tuples are immutable:
@@ -61,6 +61,7 @@ _Py_IDENTIFIER(__doc__);
 _Py_IDENTIFIER(__getattribute__);
 _Py_IDENTIFIER(__getitem__);
 _Py_IDENTIFIER(__hash__);
+_Py_IDENTIFIER(__init__);
 _Py_IDENTIFIER(__init_subclass__);
 _Py_IDENTIFIER(__len__);
 _Py_IDENTIFIER(__module__);
@@ -958,6 +959,50 @@ type_call(PyTypeObject *type, PyObject *args, PyObject *kwds)
     return obj;
 }
 
+/* Forward */
+static PyObject *object_new(PyTypeObject *, PyObject *, PyObject *);
+static int object_init(PyObject *, PyObject *, PyObject *);
+static int slot_tp_init(PyObject *, PyObject *, PyObject *);
+static int slot_tp_init_fastcall(PyObject *, PyObject *const *, Py_ssize_t,
+                                 PyObject *);
+
+/* The tp_vectorcall of PyType_Type, object and the classes created by
+   type_new().  Calls type(x) and creates the instances of classes which
+   don't override object.__new__() without a tuple and a dict of the
+   arguments; the other calls go through type_call(). */
+static PyObject *
+type_vectorcall(PyObject *callable, PyObject *const *args, Py_ssize_t nargs,
+                PyObject *kwnames)
+{
+    PyTypeObject *type = (PyTypeObject *)callable;
+    PyObject *obj;
+
+    if (type == &PyType_Type) {
+        if (nargs == 1 && kwnames == NULL) {
+            obj = (PyObject *)Py_TYPE(args[0]);
+            Py_INCREF(obj);
+            return obj;
+        }
+    }
+    else if (type->tp_new == object_new &&
+             !(type->tp_flags & Py_TPFLAGS_IS_ABSTRACT)) {
+        if (type->tp_init == slot_tp_init) {
+            obj = type->tp_alloc(type, 0);
+            if (obj == NULL)
+                return NULL;
+            if (slot_tp_init_fastcall(obj, args, nargs, kwnames) < 0) {
+                Py_DECREF(obj);
+                return NULL;
+            }
+            return obj;
+        }
+        if (type->tp_init == object_init && nargs == 0 && kwnames == NULL) {
+            return type->tp_alloc(type, 0);
+        }
+    }
+    return _PyObject_MakeTpCall(callable, args, nargs, kwnames);
+}
+
 PyObject *
 PyType_GenericAlloc(PyTypeObject *type, Py_ssize_t nitems)
 {
@@ -2265,10 +2310,6 @@ valid_identifier(PyObject *s)
     return 1;
 }
 
-/* Forward */
-static int
-object_init(PyObject *self, PyObject *args, PyObject *kwds);
-
 static int
 type_init(PyObject *cls, PyObject *args, PyObject *kwds)
 {
@@ -2600,6 +2641,7 @@ type_new(PyTypeObject *metatype, PyObject *args, PyObject *kwds)
         type->tp_flags |= Py_TPFLAGS_HAVE_GC;
 
     /* Initialize essential fields */
+    type->tp_vectorcall = type_vectorcall;
     type->tp_as_async = &et->as_async;
     type->tp_as_number = &et->as_number;
     type->tp_as_sequence = &et->as_sequence;
@@ -3254,6 +3296,7 @@ static void
 type_dealloc(PyTypeObject *type)
 {
     PyHeapTypeObject *et;
+    int i;
     PyObject *tp, *val, *tb;
 
     /* Assert this is a heap-allocated type object */
@@ -3279,6 +3322,10 @@ type_dealloc(PyTypeObject *type)
     Py_XDECREF(et->ht_slots);
     if (et->ht_cached_keys)
         _PyDictKeys_DecRef(et->ht_cached_keys);
+    for (i = 0; i < _PyHeapType_KEYS_VARIANTS; i++) {
+        if (et->ht_keys_variants[i])
+            _PyDictKeys_DecRef(et->ht_keys_variants[i]);
+    }
     Py_TYPE(type)->tp_free((PyObject *)type);
 }
 
@@ -3423,6 +3470,10 @@ type___sizeof___impl(PyTypeObject *self)
         size = sizeof(PyHeapTypeObject);
         if (et->ht_cached_keys)
             size += _PyDict_KeysSize(et->ht_cached_keys);
+        for (int i = 0; i < _PyHeapType_KEYS_VARIANTS; i++) {
+            if (et->ht_keys_variants[i])
+                size += _PyDict_KeysSize(et->ht_keys_variants[i]);
+        }
     }
     else
         size = sizeof(PyTypeObject);
@@ -3479,6 +3530,7 @@ static int
 type_clear(PyTypeObject *type)
 {
     PyDictKeysObject *cached_keys;
+    int i;
     /* Because of type_is_gc(), the collector only calls this
        for heaptypes. */
     assert(type->tp_flags & Py_TPFLAGS_HEAPTYPE);
@@ -3515,6 +3567,13 @@ type_clear(PyTypeObject *type)
         ((PyHeapTypeObject *)type)->ht_cached_keys = NULL;
         _PyDictKeys_DecRef(cached_keys);
     }
+    for (i = 0; i < _PyHeapType_KEYS_VARIANTS; i++) {
+        cached_keys = ((PyHeapTypeObject *)type)->ht_keys_variants[i];
+        if (cached_keys != NULL) {
+            ((PyHeapTypeObject *)type)->ht_keys_variants[i] = NULL;
+            _PyDictKeys_DecRef(cached_keys);
+        }
+    }
     if (type->tp_dict)
         PyDict_Clear(type->tp_dict);
     Py_CLEAR(type->tp_mro);
@@ -3549,7 +3608,8 @@ PyTypeObject PyType_Type = {
     (setattrofunc)type_setattro,                /* tp_setattro */
     0,                                          /* tp_as_buffer */
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC |
-        Py_TPFLAGS_BASETYPE | Py_TPFLAGS_TYPE_SUBCLASS,         /* tp_flags */
+        Py_TPFLAGS_BASETYPE | Py_TPFLAGS_TYPE_SUBCLASS |
+        Py_TPFLAGS_HAVE_VECTORCALL,                             /* tp_flags */
     type_doc,                                   /* tp_doc */
     (traverseproc)type_traverse,                /* tp_traverse */
     (inquiry)type_clear,                        /* tp_clear */
@@ -3570,6 +3630,16 @@ PyTypeObject PyType_Type = {
     type_new,                                   /* tp_new */
     PyObject_GC_Del,                            /* tp_free */
     (inquiry)type_is_gc,                        /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    offsetof(PyTypeObject, tp_vectorcall),      /* tp_vectorcall_offset */
+    type_vectorcall,                            /* tp_vectorcall */
 };
 
 
@@ -3615,10 +3685,6 @@ PyTypeObject PyType_Type = {
 
 */
 
-/* Forward */
-static PyObject *
-object_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
-
 static int
 excess_args(PyObject *args, PyObject *kwds)
 {
@@ -4744,6 +4810,17 @@ PyTypeObject PyBaseObject_Type = {
     PyType_GenericAlloc,                        /* tp_alloc */
     object_new,                                 /* tp_new */
     PyObject_Del,                               /* tp_free */
+    0,                                          /* tp_is_gc */
+    0,                                          /* tp_bases */
+    0,                                          /* tp_mro */
+    0,                                          /* tp_cache */
+    0,                                          /* tp_subclasses */
+    0,                                          /* tp_weaklist */
+    0,                                          /* tp_del */
+    0,                                          /* tp_version_tag */
+    0,                                          /* tp_finalize */
+    0,                                          /* tp_vectorcall_offset */
+    type_vectorcall,                            /* tp_vectorcall */
 };
 
 
@@ -6579,10 +6656,26 @@ slot_tp_descr_set(PyObject *self, PyObject *target, PyObject *value)
     return 0;
 }
 
+/* Check the result of a call of __init__() and release it */
+static int
+init_result(PyObject *res)
+{
+    if (res == NULL)
+        return -1;
+    if (res != Py_None) {
+        PyErr_Format(PyExc_TypeError,
+                     "__init__() should return None, not '%.200s'",
+                     Py_TYPE(res)->tp_name);
+        Py_DECREF(res);
+        return -1;
+    }
+    Py_DECREF(res);
+    return 0;
+}
+
 static int
 slot_tp_init(PyObject *self, PyObject *args, PyObject *kwds)
 {
-    _Py_IDENTIFIER(__init__);
     int unbound;
     PyObject *meth = lookup_method(self, &PyId___init__, &unbound);
     PyObject *res;
@@ -6596,17 +6689,29 @@ slot_tp_init(PyObject *self, PyObject *args, PyObject *kwds)
         res = PyObject_Call(meth, args, kwds);
     }
     Py_DECREF(meth);
-    if (res == NULL)
-        return -1;
-    if (res != Py_None) {
-        PyErr_Format(PyExc_TypeError,
-                     "__init__() should return None, not '%.200s'",
-                     Py_TYPE(res)->tp_name);
-        Py_DECREF(res);
+    return init_result(res);
+}
+
+/* Variant of slot_tp_init() for type_vectorcall() */
+static int
+slot_tp_init_fastcall(PyObject *self, PyObject *const *args,
+                      Py_ssize_t nargs, PyObject *kwnames)
+{
+    int unbound;
+    PyObject *meth = lookup_method(self, &PyId___init__, &unbound);
+    PyObject *res;
+
+    if (meth == NULL)
         return -1;
+    if (unbound) {
+        res = _PyObject_FastCallKeywords_Prepend(meth, self, args, nargs,
+                                                 kwnames);
     }
-    Py_DECREF(res);
-    return 0;
+    else {
+        res = _PyObject_FastCallKeywords(meth, args, nargs, kwnames);
+    }
+    Py_DECREF(meth);
+    return init_result(res);
 }
 
 static PyObject *
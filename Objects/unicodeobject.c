@@ -15054,6 +15054,21 @@ unicode_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
         return PyUnicode_FromEncodedObject(x, encoding, errors);
 }
 
+/* Call str() and str(object) without a tuple of the arguments */
+static PyObject *
+unicode_vectorcall(PyObject *type, PyObject *const *args, Py_ssize_t nargs,
+                   PyObject *kwnames)
+{
+    assert(type == (PyObject *)&PyUnicode_Type);
+    if (kwnames == NULL) {
+        if (nargs == 0)
+            _Py_RETURN_UNICODE_EMPTY();
+        if (nargs == 1)
+            return PyObject_Str(args[0]);
+    }
+    return _PyObject_MakeTpCall(type, args, nargs, kwnames);
+}
+
 static PyObject *
 unicode_subtype_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
@@ -15210,6 +15225,17 @@ PyTypeObject PyUnicode_Type = {
     0,                  /* tp_alloc */
     unicode_new,            /* tp_new */
     PyObject_Del,           /* tp_free */
+    0,                      /* tp_is_gc */
+    0,                      /* tp_bases */
+    0,                      /* tp_mro */
+    0,                      /* tp_cache */
+    0,                      /* tp_subclasses */
+    0,                      /* tp_weaklist */
+    0,                      /* tp_del */
+    0,                      /* tp_version_tag */
+    0,                      /* tp_finalize */
+    0,                      /* tp_vectorcall_offset */
+    unicode_vectorcall,     /* tp_vectorcall */
 };
 
 /* Initialize the Unicode implementation */
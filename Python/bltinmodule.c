@@ -2672,7 +2672,36 @@ zip_reduce(zipobject *lz)
     return Py_BuildValue("OO", Py_TYPE(lz), lz->ittuple);
 }
 
+static PyObject *
+zip_length_hint(zipobject *lz)
+{
+    Py_ssize_t i, n, hint = 0;
+    Py_ssize_t tuplesize = lz->tuplesize;
+
+    /* The shortest iterator gives the length, so it is only known when
+       every iterator knows its own.  The length of an iterator whose
+       __length_hint__() fails is unknown too: the hint of zip must not
+       make list(zip(...)) fail. */
+    for (i = 0; i < tuplesize; i++) {
+        n = PyObject_LengthHint(PyTuple_GET_ITEM(lz->ittuple, i), -1);
+        if (n == -1) {
+            if (PyErr_Occurred()) {
+                if (!PyErr_ExceptionMatches(PyExc_Exception))
+                    return NULL;
+                PyErr_Clear();
+            }
+            Py_RETURN_NOTIMPLEMENTED;
+        }
+        if (i == 0 || n < hint)
+            hint = n;
+    }
+    return PyLong_FromSsize_t(hint);
+}
+
+PyDoc_STRVAR(length_hint_doc, "Private method returning an estimate of len(list(it)).");
+
 static PyMethodDef zip_methods[] = {
+    {"__length_hint__", (PyCFunction)zip_length_hint, METH_NOARGS, length_hint_doc},
     {"__reduce__",   (PyCFunction)zip_reduce,   METH_NOARGS, reduce_doc},
     {NULL,           NULL}           /* sentinel */
 };
@@ -10,11 +10,13 @@
 #define PY_LOCAL_AGGRESSIVE
 
 #include "Python.h"
+#include "internal/code.h"
 #include "internal/pystate.h"
 
 #include "code.h"
 #include "dictobject.h"
 #include "frameobject.h"
+#include "longintrepr.h"
 #include "opcode.h"
 #include "pydtrace.h"
 #include "setobject.h"
@@ -58,6 +60,9 @@ static void dtrace_function_entry(PyFrameObject *);
 static void dtrace_function_return(PyFrameObject *);
 
 static PyObject * cmp_outcome(int, PyObject *, PyObject *);
+static void specialize(PyCodeObject *, _PyOpcache *, Py_ssize_t, int, int,
+                       PyObject *, PyObject *);
+static void unspecialize(PyCodeObject *, _PyOpcache *, Py_ssize_t, int, int);
 static PyObject * import_name(PyFrameObject *, PyObject *, PyObject *,
                               PyObject *);
 static PyObject * import_from(PyObject *, PyObject *);
@@ -88,6 +93,44 @@ static long dxp[256];
 #endif
 #endif
 
+/* Adaptive specialization statistics, indexed by opcode.  For generic
+   instructions, only 'failure' is used. */
+typedef struct {
+    uint64_t specialized;  /* instructions rewritten into this opcode */
+    uint64_t hit;          /* executions whose guard succeeded */
+    uint64_t miss;         /* executions whose guard failed */
+    uint64_t deopt;        /* instructions rewritten back to generic */
+    uint64_t failure;      /* attempts to specialize which failed */
+} specialization_stats;
+
+static specialization_stats spec_stats[256];
+
+/* Opcode profiler, see sys._setopcodeprofile().  Unlike
+   DYNAMIC_EXECUTION_PROFILE, it is enabled at runtime: while it is, the
+   interpreter is counted in _Py_TracingPossible, so that every instruction
+   goes through fast_next_opcode, where it is counted. */
+struct _opcode_profile {
+    /* pairs[i][j] is the number of times opcode j was executed right after
+       opcode i, and pairs[256][j] the number of times opcode j was executed
+       (the format of sys.getdxp() with DXPAIRS). */
+    uint64_t pairs[257][256];
+    /* Also count opcodes per code object? */
+    int per_code;
+    /* co_extra index of the per code object counters, or -1 */
+    Py_ssize_t code_index;
+    /* Incremented by _PyEval_ResetOpcodeProfile(): per code object counters
+       of an older generation are stale. */
+    uint64_t generation;
+};
+
+typedef struct {
+    uint64_t generation;
+    uint64_t counts[256];
+} code_opcode_profile;
+
+static uint64_t * get_code_opcode_counts(struct _opcode_profile *,
+                                         PyCodeObject *);
+
 #define GIL_REQUEST _Py_atomic_load_relaxed(&_PyRuntime.ceval.gil_drop_request)
 
 /* This can set eval_breaker to 0 even though gil_drop_request became
@@ -156,7 +199,7 @@ PyEval_InitThreads(void)
     if (gil_created())
         return;
     create_gil();
-    take_gil(PyThreadState_GET());
+    take_gil(PyThreadState_GET(), 0);
     _PyRuntime.ceval.pending.main_thread = PyThread_get_thread_ident();
     if (!_PyRuntime.ceval.pending.lock)
         _PyRuntime.ceval.pending.lock = PyThread_allocate_lock();
@@ -177,7 +220,7 @@ PyEval_AcquireLock(void)
     PyThreadState *tstate = PyThreadState_GET();
     if (tstate == NULL)
         Py_FatalError("PyEval_AcquireLock: current thread state is NULL");
-    take_gil(tstate);
+    take_gil(tstate, 0);
 }
 
 void
@@ -198,7 +241,7 @@ PyEval_AcquireThread(PyThreadState *tstate)
         Py_FatalError("PyEval_AcquireThread: NULL new thread state");
     /* Check someone has called PyEval_InitThreads() to create the lock */
     assert(gil_created());
-    take_gil(tstate);
+    take_gil(tstate, 0);
     if (PyThreadState_Swap(tstate) != NULL)
         Py_FatalError(
             "PyEval_AcquireThread: non-NULL old thread state");
@@ -228,7 +271,7 @@ PyEval_ReInitThreads(void)
         return;
     recreate_gil();
     _PyRuntime.ceval.pending.lock = PyThread_allocate_lock();
-    take_gil(current_tstate);
+    take_gil(current_tstate, 0);
     _PyRuntime.ceval.pending.main_thread = PyThread_get_thread_ident();
 
     /* Destroy all threads except the current one */
@@ -266,7 +309,7 @@ PyEval_RestoreThread(PyThreadState *tstate)
         Py_FatalError("PyEval_RestoreThread: NULL tstate");
     if (gil_created()) {
         int err = errno;
-        take_gil(tstate);
+        take_gil(tstate, 1);
         /* _Py_Finalizing is protected by the GIL */
         if (_Py_IsFinalizing() && !_Py_CURRENTLY_FINALIZING(tstate)) {
             drop_gil(tstate);
@@ -551,6 +594,8 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
 #ifdef DXPAIRS
     int lastopcode = 0;
 #endif
+    int profile_lastopcode = 0;
+    uint64_t *code_opcode_counts = NULL;
     PyObject **stack_pointer;  /* Next free slot in value stack */
     const _Py_CODEUNIT *next_instr;
     int opcode;        /* Current opcode */
@@ -559,6 +604,7 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
     PyObject **fastlocals, **freevars;
     PyObject *retval = NULL;            /* Return value */
     PyThreadState *tstate = PyThreadState_GET();
+    PyFrameObject *back;
     PyCodeObject *co;
 
     /* when tracing we set things up so that
@@ -573,6 +619,7 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
     const _Py_CODEUNIT *first_instr;
     PyObject *names;
     PyObject *consts;
+    _PyOpcache *co_opcache;
 
 #ifdef LLTRACE
     _Py_IDENTIFIER(__ltrace__);
@@ -746,6 +793,87 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
 #define PREDICTED(op)           PRED_##op:
 
 
+/* Shared opcode cache.
+
+   The cache of a code object is allocated lazily, only once the code object
+   has been executed _PyCode_OPCACHE_MIN_RUNS times, so that code which runs
+   only a few times (module bodies, class bodies) does not pay for it.
+
+   OPCACHE_CHECK() sets co_opcache to the cache entry of the current
+   instruction, or to NULL if the instruction has no cache entry. */
+#define OPCACHE_CHECK() \
+    do { \
+        co_opcache = NULL; \
+        if (co->co_opcache != NULL) { \
+            unsigned char co_opt_offset = \
+                co->co_opcache_map[next_instr - first_instr]; \
+            if (co_opt_offset > 0) { \
+                assert(co_opt_offset <= co->co_opcache_size); \
+                co_opcache = &co->co_opcache[co_opt_offset - 1]; \
+                assert(co_opcache != NULL); \
+            } \
+        } \
+    } while (0)
+
+/* Permanently disable the cache entry of the current instruction. */
+#define OPCACHE_DEOPT() \
+    do { \
+        if (co_opcache != NULL) { \
+            co_opcache->optimized = -1; \
+            assert(co->co_opcache_map[next_instr - first_instr] > 0); \
+            co->co_opcache_map[next_instr - first_instr] = 0; \
+            co_opcache = NULL; \
+        } \
+    } while (0)
+
+/* Count a miss, disabling the entry after _PyCode_OPCACHE_MAX_TRIES. */
+#define OPCACHE_MAYBE_DEOPT() \
+    do { \
+        if (co_opcache != NULL && --co_opcache->optimized <= 0) { \
+            OPCACHE_DEOPT(); \
+        } \
+    } while (0)
+
+/* Adaptive specialization.
+
+   When a code object gets hot, _PyCode_InitOpcache() makes a private copy
+   of its bytecode (co_quickened) which the interpreter executes from then
+   on.  The first time a generic instruction having a cache entry executes,
+   MAYBE_SPECIALIZE() rewrites it in that copy into a variant specialized
+   for the types of its operands (int, float, str).  The specialized
+   instruction checks these types (its guard) and, on success, skips the
+   generic number and rich comparison protocols.  On failure, SPECIALIZE_MISS()
+   runs the generic instruction instead, and after _PyCode_OPCACHE_MAX_TRIES
+   misses the instruction is rewritten back to the generic one for good. */
+#define MAYBE_SPECIALIZE(left, right) \
+    do { \
+        OPCACHE_CHECK(); \
+        if (co_opcache != NULL) { \
+            specialize(co, co_opcache, next_instr - first_instr - 1, \
+                       opcode, oparg, (left), (right)); \
+        } \
+    } while (0)
+
+#define SPECIALIZE_HIT() (spec_stats[opcode].hit++)
+
+#define SPECIALIZE_MISS(generic) \
+    do { \
+        OPCACHE_CHECK(); \
+        if (co_opcache != NULL) { \
+            unspecialize(co, co_opcache, next_instr - first_instr - 1, \
+                         opcode, (generic)); \
+        } \
+        opcode = (generic); \
+        goto dispatch_opcode; \
+    } while (0)
+
+/* Value of an int object of at most one digit. */
+#define IS_MEDIUM_INT(x) (Py_ABS(Py_SIZE(x)) <= 1)
+#define MEDIUM_INT_VALUE(x) \
+    (Py_SIZE(x) < 0 ? -(sdigit)((PyLongObject *)(x))->ob_digit[0] : \
+     (Py_SIZE(x) == 0 ? (sdigit)0 : (sdigit)((PyLongObject *)(x))->ob_digit[0]))
+
+
 /* Stack manipulation macros */
 
 /* The stack can grow at most MAXINT deep, as co_nlocals and
@@ -881,7 +1009,33 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
     assert(PyBytes_GET_SIZE(co->co_code) <= INT_MAX);
     assert(PyBytes_GET_SIZE(co->co_code) % sizeof(_Py_CODEUNIT) == 0);
     assert(_Py_IS_ALIGNED(PyBytes_AS_STRING(co->co_code), sizeof(_Py_CODEUNIT)));
-    first_instr = (_Py_CODEUNIT *) PyBytes_AS_STRING(co->co_code);
+
+    if (co->co_opcache_flag < _PyCode_OPCACHE_MIN_RUNS) {
+        co->co_opcache_flag++;
+        if (co->co_opcache_flag == _PyCode_OPCACHE_MIN_RUNS) {
+            if (_PyCode_InitOpcache(co) < 0) {
+                goto exit_eval_frame;
+            }
+        }
+    }
+    if (co->co_quickened != NULL) {
+        /* Offsets are the same in both copies of the bytecode, so a
+           suspended generator can resume in the quickened one. */
+        first_instr = co->co_quickened;
+    }
+    else {
+        first_instr = (_Py_CODEUNIT *) PyBytes_AS_STRING(co->co_code);
+    }
+
+    if (_Py_TracingPossible && tstate->interp->opcode_profiling &&
+        tstate->interp->opcode_profile->per_code) {
+        code_opcode_counts = get_code_opcode_counts(
+            tstate->interp->opcode_profile, co);
+        if (code_opcode_counts == NULL) {
+            goto exit_eval_frame;
+        }
+    }
+
     /*
        f->f_lasti refers to the index of the last instruction,
        unless it's -1 in which case next_instr should be first_instr.
@@ -967,11 +1121,12 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
                 /* Give another thread a chance */
                 if (PyThreadState_Swap(NULL) != tstate)
                     Py_FatalError("ceval: tstate mix-up");
+                gil_stats_forced_switch(tstate);
                 drop_gil(tstate);
 
                 /* Other threads may run now */
 
-                take_gil(tstate);
+                take_gil(tstate, 0);
 
                 /* Check if we should make a quick exit. */
                 if (_Py_IsFinalizing() &&
@@ -1028,6 +1183,17 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
         /* Extract opcode and argument */
 
         NEXTOPARG();
+
+        if (_Py_TracingPossible && tstate->interp->opcode_profiling) {
+            struct _opcode_profile *profile = tstate->interp->opcode_profile;
+            profile->pairs[profile_lastopcode][opcode]++;
+            profile->pairs[256][opcode]++;
+            if (code_opcode_counts != NULL) {
+                code_opcode_counts[opcode]++;
+            }
+            profile_lastopcode = opcode;
+        }
+
     dispatch_opcode:
 #ifdef DYNAMIC_EXECUTION_PROFILE
 #ifdef DXPAIRS
@@ -1195,7 +1361,52 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
         TARGET(BINARY_MULTIPLY) {
             PyObject *right = POP();
             PyObject *left = TOP();
-            PyObject *res = PyNumber_Multiply(left, right);
+            PyObject *res;
+            MAYBE_SPECIALIZE(left, right);
+            res = PyNumber_Multiply(left, right);
+            Py_DECREF(left);
+            Py_DECREF(right);
+            SET_TOP(res);
+            if (res == NULL)
+                goto error;
+            DISPATCH();
+        }
+
+        TARGET(BINARY_MULTIPLY_INT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *res;
+            if (!PyLong_CheckExact(left) || !PyLong_CheckExact(right)) {
+                SPECIALIZE_MISS(BINARY_MULTIPLY);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            if (IS_MEDIUM_INT(left) && IS_MEDIUM_INT(right)) {
+                res = PyLong_FromLongLong((long long)MEDIUM_INT_VALUE(left) *
+                                          MEDIUM_INT_VALUE(right));
+            }
+            else {
+                res = PyLong_Type.tp_as_number->nb_multiply(left, right);
+            }
+            Py_DECREF(left);
+            Py_DECREF(right);
+            SET_TOP(res);
+            if (res == NULL)
+                goto error;
+            DISPATCH();
+        }
+
+        TARGET(BINARY_MULTIPLY_FLOAT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *res;
+            if (!PyFloat_CheckExact(left) || !PyFloat_CheckExact(right)) {
+                SPECIALIZE_MISS(BINARY_MULTIPLY);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            res = PyFloat_FromDouble(PyFloat_AS_DOUBLE(left) *
+                                     PyFloat_AS_DOUBLE(right));
             Py_DECREF(left);
             Py_DECREF(right);
             SET_TOP(res);
@@ -1264,12 +1475,10 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
             PyObject *right = POP();
             PyObject *left = TOP();
             PyObject *sum;
-            /* NOTE(haypo): Please don't try to micro-optimize int+int on
-               CPython using bytecode, it is simply worthless.
-               See http://bugs.python.org/issue21955 and
-               http://bugs.python.org/issue10044 for the discussion. In short,
-               no patch shown any impact on a realistic benchmark, only a minor
-               speedup on microbenchmarks. */
+            /* int+int and float+float are only special-cased by the
+               specialized instructions below, which are used in hot code:
+               see "Adaptive specialization" above. */
+            MAYBE_SPECIALIZE(left, right);
             if (PyUnicode_CheckExact(left) &&
                      PyUnicode_CheckExact(right)) {
                 sum = unicode_concatenate(left, right, f, next_instr);
@@ -1286,10 +1495,98 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
             DISPATCH();
         }
 
+        TARGET(BINARY_ADD_INT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *sum;
+            if (!PyLong_CheckExact(left) || !PyLong_CheckExact(right)) {
+                SPECIALIZE_MISS(BINARY_ADD);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            if (IS_MEDIUM_INT(left) && IS_MEDIUM_INT(right)) {
+                sum = PyLong_FromLong((long)MEDIUM_INT_VALUE(left) +
+                                      MEDIUM_INT_VALUE(right));
+            }
+            else {
+                sum = PyLong_Type.tp_as_number->nb_add(left, right);
+            }
+            Py_DECREF(left);
+            Py_DECREF(right);
+            SET_TOP(sum);
+            if (sum == NULL)
+                goto error;
+            DISPATCH();
+        }
+
+        TARGET(BINARY_ADD_FLOAT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *sum;
+            if (!PyFloat_CheckExact(left) || !PyFloat_CheckExact(right)) {
+                SPECIALIZE_MISS(BINARY_ADD);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            sum = PyFloat_FromDouble(PyFloat_AS_DOUBLE(left) +
+                                     PyFloat_AS_DOUBLE(right));
+            Py_DECREF(left);
+            Py_DECREF(right);
+            SET_TOP(sum);
+            if (sum == NULL)
+                goto error;
+            DISPATCH();
+        }
+
         TARGET(BINARY_SUBTRACT) {
             PyObject *right = POP();
             PyObject *left = TOP();
-            PyObject *diff = PyNumber_Subtract(left, right);
+            PyObject *diff;
+            MAYBE_SPECIALIZE(left, right);
+            diff = PyNumber_Subtract(left, right);
+            Py_DECREF(right);
+            Py_DECREF(left);
+            SET_TOP(diff);
+            if (diff == NULL)
+                goto error;
+            DISPATCH();
+        }
+
+        TARGET(BINARY_SUBTRACT_INT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *diff;
+            if (!PyLong_CheckExact(left) || !PyLong_CheckExact(right)) {
+                SPECIALIZE_MISS(BINARY_SUBTRACT);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            if (IS_MEDIUM_INT(left) && IS_MEDIUM_INT(right)) {
+                diff = PyLong_FromLong((long)MEDIUM_INT_VALUE(left) -
+                                       MEDIUM_INT_VALUE(right));
+            }
+            else {
+                diff = PyLong_Type.tp_as_number->nb_subtract(left, right);
+            }
+            Py_DECREF(right);
+            Py_DECREF(left);
+            SET_TOP(diff);
+            if (diff == NULL)
+                goto error;
+            DISPATCH();
+        }
+
+        TARGET(BINARY_SUBTRACT_FLOAT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *diff;
+            if (!PyFloat_CheckExact(left) || !PyFloat_CheckExact(right)) {
+                SPECIALIZE_MISS(BINARY_SUBTRACT);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            diff = PyFloat_FromDouble(PyFloat_AS_DOUBLE(left) -
+                                      PyFloat_AS_DOUBLE(right));
             Py_DECREF(right);
             Py_DECREF(left);
             SET_TOP(diff);
@@ -2152,6 +2449,26 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
             if (PyDict_CheckExact(f->f_globals)
                 && PyDict_CheckExact(f->f_builtins))
             {
+                OPCACHE_CHECK();
+                if (co_opcache != NULL && co_opcache->optimized > 0) {
+                    _PyOpcache_LoadGlobal *lg = &co_opcache->u.lg;
+
+                    if (lg->globals_ver ==
+                            ((PyDictObject *)f->f_globals)->ma_version_tag
+                        && lg->builtins_ver ==
+                           ((PyDictObject *)f->f_builtins)->ma_version_tag)
+                    {
+                        /* Neither namespace changed since the cache was
+                           filled: the cached object is still the value
+                           bound to the name. */
+                        v = lg->ptr;
+                        assert(v != NULL);
+                        Py_INCREF(v);
+                        PUSH(v);
+                        DISPATCH();
+                    }
+                }
+
                 v = _PyDict_LoadGlobal((PyDictObject *)f->f_globals,
                                        (PyDictObject *)f->f_builtins,
                                        name);
@@ -2164,6 +2481,18 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
                     }
                     goto error;
                 }
+
+                if (co_opcache != NULL) {
+                    _PyOpcache_LoadGlobal *lg = &co_opcache->u.lg;
+
+                    co_opcache->optimized = 1;
+                    lg->globals_ver =
+                        ((PyDictObject *)f->f_globals)->ma_version_tag;
+                    lg->builtins_ver =
+                        ((PyDictObject *)f->f_builtins)->ma_version_tag;
+                    lg->ptr = v; /* borrowed */
+                }
+
                 Py_INCREF(v);
             }
             else {
@@ -2298,12 +2627,18 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
 
         TARGET(BUILD_TUPLE) {
             PyObject *tup = PyTuple_New(oparg);
+            /* The empty tuple is a shared singleton: leave it alone */
+            int may_be_tracked = (oparg == 0);
             if (tup == NULL)
                 goto error;
             while (--oparg >= 0) {
                 PyObject *item = POP();
+                may_be_tracked |= _PyObject_GC_MAY_BE_TRACKED(item);
                 PyTuple_SET_ITEM(tup, oparg, item);
             }
+            if (!may_be_tracked && _PyObject_GC_IS_TRACKED(tup)) {
+                _PyGC_UNTRACK_NEW(tup);
+            }
             PUSH(tup);
             DISPATCH();
         }
@@ -2517,8 +2852,16 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
         }
 
         TARGET(BUILD_MAP_UNPACK) {
-            Py_ssize_t i;
-            PyObject *sum = PyDict_New();
+            Py_ssize_t i, size = 0;
+            PyObject *sum;
+
+            /* Presize for the dicts being unpacked; other mappings
+               would have to be asked, and may have side effects. */
+            for (i = oparg; i > 0; i--) {
+                if (PyDict_CheckExact(PEEK(i)))
+                    size += PyDict_GET_SIZE(PEEK(i));
+            }
+            sum = size ? _PyDict_NewPresized(size) : PyDict_New();
             if (sum == NULL)
                 goto error;
 
@@ -2542,8 +2885,16 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
         }
 
         TARGET(BUILD_MAP_UNPACK_WITH_CALL) {
-            Py_ssize_t i;
-            PyObject *sum = PyDict_New();
+            Py_ssize_t i, size = 0;
+            PyObject *sum;
+
+            /* Presize for the dicts being unpacked; other mappings
+               would have to be asked, and may have side effects. */
+            for (i = oparg; i > 0; i--) {
+                if (PyDict_CheckExact(PEEK(i)))
+                    size += PyDict_GET_SIZE(PEEK(i));
+            }
+            sum = size ? _PyDict_NewPresized(size) : PyDict_New();
             if (sum == NULL)
                 goto error;
 
@@ -2611,7 +2962,164 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
         TARGET(LOAD_ATTR) {
             PyObject *name = GETITEM(names, oparg);
             PyObject *owner = TOP();
-            PyObject *res = PyObject_GetAttr(owner, name);
+            PyTypeObject *type = Py_TYPE(owner);
+            PyObject *res;
+
+            OPCACHE_CHECK();
+            if (co_opcache != NULL &&
+                PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG))
+            {
+                if (co_opcache->optimized > 0) {
+                    _PyOpcache_LoadAttr *la = &co_opcache->u.la;
+
+                    if (la->type == type &&
+                        la->tp_version_tag == type->tp_version_tag)
+                    {
+                        /* hint >= 0 is an index in the instance dict;
+                           hint < -1 is an inverted slot offset (offsets
+                           are strictly positive). */
+                        if (la->hint < -1) {
+                            res = *(PyObject **)((char *)owner + ~la->hint);
+                            if (res != NULL) {
+                                Py_INCREF(res);
+                                SET_TOP(res);
+                                Py_DECREF(owner);
+                                DISPATCH();
+                            }
+                            /* The slot is empty: let the slow path raise
+                               AttributeError, the cache is still valid. */
+                        }
+                        else {
+                            PyObject *dict;
+
+                            assert(type->tp_dictoffset > 0);
+                            dict = *(PyObject **)((char *)owner +
+                                                  type->tp_dictoffset);
+                            if (dict != NULL && PyDict_CheckExact(dict)) {
+                                Py_ssize_t hint = la->hint;
+                                res = NULL;
+                                Py_INCREF(dict);
+                                la->hint = _PyDict_GetItemHint(
+                                    (PyDictObject *)dict, name, hint, &res);
+                                if (res != NULL) {
+                                    assert(la->hint >= 0);
+                                    if (la->hint != hint) {
+                                        /* The hint didn't help this time */
+                                        OPCACHE_MAYBE_DEOPT();
+                                    }
+                                    Py_INCREF(res);
+                                    SET_TOP(res);
+                                    Py_DECREF(owner);
+                                    Py_DECREF(dict);
+                                    DISPATCH();
+                                }
+                                /* The attribute is missing from this
+                                   instance: don't optimize the lookup. */
+                                PyErr_Clear();
+                                Py_DECREF(dict);
+                                OPCACHE_DEOPT();
+                            }
+                            else {
+                                OPCACHE_DEOPT();
+                            }
+                        }
+                    }
+                    else {
+                        /* The type changed or is a different one: maybe
+                           the instruction will stabilize. */
+                        OPCACHE_MAYBE_DEOPT();
+                    }
+                }
+
+                /* co_opcache is NULL if the entry was just disabled. */
+                if (co_opcache != NULL &&
+                    type->tp_getattro == PyObject_GenericGetAttr)
+                {
+                    PyObject *descr;
+
+                    if (type->tp_dict == NULL && PyType_Ready(type) < 0) {
+                        Py_DECREF(owner);
+                        SET_TOP(NULL);
+                        goto error;
+                    }
+                    descr = _PyType_Lookup(type, name);
+                    if (descr != NULL) {
+                        if (Py_TYPE(descr) == &PyMemberDescr_Type &&
+                            ((PyMemberDescrObject *)descr)->d_member->type ==
+                                T_OBJECT_EX &&
+                            PyType_IsSubtype(type,
+                                PyDescr_TYPE(descr)))
+                        {
+                            /* A __slots__ member: load it directly. */
+                            Py_ssize_t offset =
+                                ((PyMemberDescrObject *)descr)->d_member->offset;
+                            _PyOpcache_LoadAttr *la = &co_opcache->u.la;
+
+                            assert(offset > 0);
+                            if (co_opcache->optimized == 0) {
+                                co_opcache->optimized = _PyCode_OPCACHE_MAX_TRIES;
+                            }
+                            la->type = type;
+                            la->tp_version_tag = type->tp_version_tag;
+                            la->hint = ~offset;
+
+                            res = *(PyObject **)((char *)owner + offset);
+                            if (res != NULL) {
+                                Py_INCREF(res);
+                                SET_TOP(res);
+                                Py_DECREF(owner);
+                                DISPATCH();
+                            }
+                        }
+                        else {
+                            /* Some other kind of descriptor */
+                            OPCACHE_DEOPT();
+                        }
+                    }
+                    else if (type->tp_dictoffset > 0) {
+                        PyObject *dict = *(PyObject **)((char *)owner +
+                                                        type->tp_dictoffset);
+                        if (dict != NULL && PyDict_CheckExact(dict)) {
+                            Py_ssize_t hint;
+                            res = NULL;
+                            Py_INCREF(dict);
+                            hint = _PyDict_GetItemHint((PyDictObject *)dict,
+                                                       name, -1, &res);
+                            if (res != NULL) {
+                                _PyOpcache_LoadAttr *la = &co_opcache->u.la;
+
+                                assert(hint >= 0);
+                                if (co_opcache->optimized == 0) {
+                                    co_opcache->optimized = _PyCode_OPCACHE_MAX_TRIES;
+                                }
+                                la->type = type;
+                                la->tp_version_tag = type->tp_version_tag;
+                                la->hint = hint;
+
+                                Py_INCREF(res);
+                                SET_TOP(res);
+                                Py_DECREF(owner);
+                                Py_DECREF(dict);
+                                DISPATCH();
+                            }
+                            PyErr_Clear();
+                            Py_DECREF(dict);
+                        }
+                        else {
+                            OPCACHE_DEOPT();
+                        }
+                    }
+                    else {
+                        /* No instance dict at a fixed offset */
+                        OPCACHE_DEOPT();
+                    }
+                }
+                else {
+                    OPCACHE_DEOPT();
+                }
+            }
+
+            res = PyObject_GetAttr(owner, name);
             Py_DECREF(owner);
             SET_TOP(res);
             if (res == NULL)
@@ -2622,7 +3130,108 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
         TARGET(COMPARE_OP) {
             PyObject *right = POP();
             PyObject *left = TOP();
-            PyObject *res = cmp_outcome(oparg, left, right);
+            PyObject *res;
+            MAYBE_SPECIALIZE(left, right);
+            res = cmp_outcome(oparg, left, right);
+            Py_DECREF(left);
+            Py_DECREF(right);
+            SET_TOP(res);
+            if (res == NULL)
+                goto error;
+            PREDICT(POP_JUMP_IF_FALSE);
+            PREDICT(POP_JUMP_IF_TRUE);
+            DISPATCH();
+        }
+
+        TARGET(COMPARE_OP_INT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *res;
+            if (!PyLong_CheckExact(left) || !PyLong_CheckExact(right)) {
+                SPECIALIZE_MISS(COMPARE_OP);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            if (IS_MEDIUM_INT(left) && IS_MEDIUM_INT(right)) {
+                sdigit a = MEDIUM_INT_VALUE(left);
+                sdigit b = MEDIUM_INT_VALUE(right);
+                int cmp;
+                switch (oparg) {
+                case PyCmp_LT: cmp = a < b; break;
+                case PyCmp_LE: cmp = a <= b; break;
+                case PyCmp_EQ: cmp = a == b; break;
+                case PyCmp_NE: cmp = a != b; break;
+                case PyCmp_GT: cmp = a > b; break;
+                case PyCmp_GE: cmp = a >= b; break;
+                default: Py_UNREACHABLE();
+                }
+                res = cmp ? Py_True : Py_False;
+                Py_INCREF(res);
+            }
+            else {
+                res = PyLong_Type.tp_richcompare(left, right, oparg);
+            }
+            Py_DECREF(left);
+            Py_DECREF(right);
+            SET_TOP(res);
+            if (res == NULL)
+                goto error;
+            PREDICT(POP_JUMP_IF_FALSE);
+            PREDICT(POP_JUMP_IF_TRUE);
+            DISPATCH();
+        }
+
+        TARGET(COMPARE_OP_FLOAT) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *res;
+            double a, b;
+            int cmp;
+            if (!PyFloat_CheckExact(left) || !PyFloat_CheckExact(right)) {
+                SPECIALIZE_MISS(COMPARE_OP);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            a = PyFloat_AS_DOUBLE(left);
+            b = PyFloat_AS_DOUBLE(right);
+            switch (oparg) {
+            case PyCmp_LT: cmp = a < b; break;
+            case PyCmp_LE: cmp = a <= b; break;
+            case PyCmp_EQ: cmp = a == b; break;
+            case PyCmp_NE: cmp = a != b; break;
+            case PyCmp_GT: cmp = a > b; break;
+            case PyCmp_GE: cmp = a >= b; break;
+            default: Py_UNREACHABLE();
+            }
+            res = cmp ? Py_True : Py_False;
+            Py_INCREF(res);
+            Py_DECREF(left);
+            Py_DECREF(right);
+            SET_TOP(res);
+            PREDICT(POP_JUMP_IF_FALSE);
+            PREDICT(POP_JUMP_IF_TRUE);
+            DISPATCH();
+        }
+
+        TARGET(COMPARE_OP_STR) {
+            PyObject *right = TOP();
+            PyObject *left = SECOND();
+            PyObject *res;
+            if (!PyUnicode_CheckExact(left) || !PyUnicode_CheckExact(right)) {
+                SPECIALIZE_MISS(COMPARE_OP);
+            }
+            SPECIALIZE_HIT();
+            STACKADJ(-1);
+            if ((oparg == PyCmp_EQ || oparg == PyCmp_NE) &&
+                PyUnicode_IS_READY(left) && PyUnicode_IS_READY(right))
+            {
+                int eq = (left == right) || _PyUnicode_EQ(left, right);
+                res = (eq == (oparg == PyCmp_EQ)) ? Py_True : Py_False;
+                Py_INCREF(res);
+            }
+            else {
+                res = PyUnicode_RichCompare(left, right, oparg);
+            }
             Py_DECREF(left);
             Py_DECREF(right);
             SET_TOP(res);
@@ -3076,9 +3685,64 @@ _PyEval_EvalFrameDefault(PyFrameObject *f, int throwflag)
             /* Designed to work in tamdem with CALL_METHOD. */
             PyObject *name = GETITEM(names, oparg);
             PyObject *obj = TOP();
+            PyTypeObject *type = Py_TYPE(obj);
             PyObject *meth = NULL;
+            int meth_found;
+
+            OPCACHE_CHECK();
+            if (co_opcache != NULL && co_opcache->optimized > 0) {
+                _PyOpcache_LoadMethod *lm = &co_opcache->u.lm;
+
+                if (lm->type == type &&
+                    PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG) &&
+                    lm->tp_version_tag == type->tp_version_tag)
+                {
+                    /* The type is unchanged, so the method found on it is
+                       still valid, unless an instance attribute shadows
+                       it. */
+                    PyObject *dict = NULL;
+                    if (type->tp_dictoffset != 0) {
+                        PyObject **dictptr = _PyObject_GetDictPtr(obj);
+                        if (dictptr != NULL) {
+                            dict = *dictptr;
+                        }
+                    }
+                    if (dict == NULL ||
+                        (PyDict_CheckExact(dict) &&
+                         PyDict_GetItem(dict, name) == NULL))
+                    {
+                        meth = lm->descr;
+                        Py_INCREF(meth);
+                        SET_TOP(meth);
+                        PUSH(obj);  // self
+                        DISPATCH();
+                    }
+                }
+                OPCACHE_MAYBE_DEOPT();
+            }
+
+            meth_found = _PyObject_GetMethod(obj, name, &meth);
 
-            int meth_found = _PyObject_GetMethod(obj, name, &meth);
+            if (co_opcache != NULL && meth_found) {
+                if (type->tp_getattro == PyObject_GenericGetAttr &&
+                    PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG))
+                {
+                    /* meth_found means that meth is a function or a method
+                       descriptor found on the type, and not shadowed by an
+                       instance attribute. */
+                    _PyOpcache_LoadMethod *lm = &co_opcache->u.lm;
+
+                    if (co_opcache->optimized == 0) {
+                        co_opcache->optimized = _PyCode_OPCACHE_MAX_TRIES;
+                    }
+                    lm->type = type;
+                    lm->tp_version_tag = type->tp_version_tag;
+                    lm->descr = meth;  /* borrowed */
+                }
+                else if (co_opcache->optimized == 0) {
+                    OPCACHE_DEOPT();
+                }
+            }
 
             if (meth == NULL) {
                 /* Most likely attribute wasn't found. */
@@ -3536,7 +4200,12 @@ exit_eval_frame:
         dtrace_function_return(f);
     Py_LeaveRecursiveCall();
     f->f_executing = 0;
-    tstate->frame = f->f_back;
+    back = f->f_back;
+    if (back != NULL && back->f_stackframe != NULL) {
+        /* f was created by PyFrame_New() while back was executing */
+        back = back->f_stackframe;
+    }
+    tstate->frame = back;
 
     return _Py_CheckFunctionResult(NULL, retval, "PyEval_EvalFrameEx");
 }
@@ -3726,10 +4395,16 @@ _PyEval_EvalCodeWithName(PyObject *_co, PyObject *globals, PyObject *locals,
         return NULL;
     }
 
-    /* Create the frame */
+    /* Create the frame: generators and coroutines outlive the call, other
+       frames live on the data stack. */
     tstate = PyThreadState_GET();
     assert(tstate != NULL);
-    f = _PyFrame_New_NoTrack(tstate, co, globals, locals);
+    if (co->co_flags & (CO_GENERATOR | CO_COROUTINE | CO_ASYNC_GENERATOR)) {
+        f = _PyFrame_New_NoTrack(tstate, co, globals, locals);
+    }
+    else {
+        f = _PyFrame_New_OnStack(tstate, co, globals, locals);
+    }
     if (f == NULL) {
         return NULL;
     }
@@ -3938,10 +4613,6 @@ _PyEval_EvalCodeWithName(PyObject *_co, PyObject *globals, PyObject *locals,
             goto fail;
         }
 
-        /* Don't need to keep the reference to f_back, it will be set
-         * when the generator is resumed. */
-        Py_CLEAR(f->f_back);
-
         /* Create a new generator that owns the ready to run frame
          * and return that as the value. */
         if (is_coro) {
@@ -3978,7 +4649,12 @@ fail: /* Jump here from prelude on failure */
        so recursion_depth must be boosted for the duration.
     */
     assert(tstate != NULL);
-    if (Py_REFCNT(f) > 1) {
+    if (f->f_onstack) {
+        ++tstate->recursion_depth;
+        _PyFrame_Clear_OnStack(tstate, f);
+        --tstate->recursion_depth;
+    }
+    else if (Py_REFCNT(f) > 1) {
         Py_DECREF(f);
         _PyObject_GC_TRACK(f);
     }
@@ -4280,6 +4956,12 @@ call_trace(Py_tracefunc func, PyObject *obj,
     int result;
     if (tstate->tracing)
         return 0;
+    /* The trace function may keep a reference to the frame */
+    if (frame != NULL) {
+        frame = _PyFrame_Materialize(frame);
+        if (frame == NULL)
+            return -1;
+    }
     tstate->tracing++;
     tstate->use_tracing = 0;
     result = func(obj, frame, what, arg);
@@ -4430,7 +5112,7 @@ _PyEval_GetAsyncGenFinalizer(void)
 PyObject *
 PyEval_GetBuiltins(void)
 {
-    PyFrameObject *current_frame = PyEval_GetFrame();
+    PyFrameObject *current_frame = _PyThreadState_GetFrame(PyThreadState_GET());
     if (current_frame == NULL)
         return PyThreadState_GET()->interp->builtins;
     else
@@ -4440,7 +5122,7 @@ PyEval_GetBuiltins(void)
 PyObject *
 PyEval_GetLocals(void)
 {
-    PyFrameObject *current_frame = PyEval_GetFrame();
+    PyFrameObject *current_frame = _PyThreadState_GetFrame(PyThreadState_GET());
     if (current_frame == NULL) {
         PyErr_SetString(PyExc_SystemError, "frame does not exist");
         return NULL;
@@ -4456,7 +5138,7 @@ PyEval_GetLocals(void)
 PyObject *
 PyEval_GetGlobals(void)
 {
-    PyFrameObject *current_frame = PyEval_GetFrame();
+    PyFrameObject *current_frame = _PyThreadState_GetFrame(PyThreadState_GET());
     if (current_frame == NULL)
         return NULL;
 
@@ -4468,13 +5150,19 @@ PyFrameObject *
 PyEval_GetFrame(void)
 {
     PyThreadState *tstate = PyThreadState_GET();
-    return _PyThreadState_GetFrame(tstate);
+    PyFrameObject *f = _PyThreadState_GetFrame(tstate);
+
+    /* The caller may keep a reference to the frame */
+    if (f != NULL) {
+        f = _PyFrame_Materialize(f);
+    }
+    return f;
 }
 
 int
 PyEval_MergeCompilerFlags(PyCompilerFlags *cf)
 {
-    PyFrameObject *current_frame = PyEval_GetFrame();
+    PyFrameObject *current_frame = _PyThreadState_GetFrame(PyThreadState_GET());
     int result = cf->cf_flags != 0;
 
     if (current_frame != NULL) {
@@ -4981,6 +5669,103 @@ format_exc_unbound(PyCodeObject *co, int oparg)
     }
 }
 
+/* Rewrite the generic instruction at 'index' in the quickened bytecode of
+   'co' into a variant specialized for the types of its operands. */
+static void
+specialize(PyCodeObject *co, _PyOpcache *entry, Py_ssize_t index,
+           int opcode, int oparg, PyObject *left, PyObject *right)
+{
+    int specialized = 0;
+
+    if (co->co_quickened == NULL) {
+        return;
+    }
+    if (entry->optimized == 0) {
+        entry->optimized = _PyCode_OPCACHE_MAX_TRIES;
+    }
+
+    if (Py_TYPE(left) == Py_TYPE(right)) {
+        switch (opcode) {
+        case BINARY_ADD:
+            if (PyLong_CheckExact(left)) {
+                specialized = BINARY_ADD_INT;
+            }
+            else if (PyFloat_CheckExact(left)) {
+                specialized = BINARY_ADD_FLOAT;
+            }
+            break;
+        case BINARY_SUBTRACT:
+            if (PyLong_CheckExact(left)) {
+                specialized = BINARY_SUBTRACT_INT;
+            }
+            else if (PyFloat_CheckExact(left)) {
+                specialized = BINARY_SUBTRACT_FLOAT;
+            }
+            break;
+        case BINARY_MULTIPLY:
+            if (PyLong_CheckExact(left)) {
+                specialized = BINARY_MULTIPLY_INT;
+            }
+            else if (PyFloat_CheckExact(left)) {
+                specialized = BINARY_MULTIPLY_FLOAT;
+            }
+            break;
+        case COMPARE_OP:
+            if (oparg > PyCmp_GE) {
+                /* in, not in, is, is not, exception match */
+                break;
+            }
+            if (PyLong_CheckExact(left)) {
+                specialized = COMPARE_OP_INT;
+            }
+            else if (PyFloat_CheckExact(left)) {
+                specialized = COMPARE_OP_FLOAT;
+            }
+            else if (PyUnicode_CheckExact(left)) {
+                specialized = COMPARE_OP_STR;
+            }
+            break;
+        default:
+            Py_UNREACHABLE();
+        }
+    }
+
+    if (specialized) {
+        if (_Py_OPCODE(co->co_quickened[index]) != specialized) {
+            _Py_SET_OPCODE(co->co_quickened[index], specialized);
+            spec_stats[specialized].specialized++;
+        }
+        return;
+    }
+
+    spec_stats[opcode].failure++;
+    if (--entry->optimized <= 0) {
+        /* Give up on this instruction */
+        _Py_SET_OPCODE(co->co_quickened[index], opcode);
+        entry->optimized = -1;
+        co->co_opcache_map[index + 1] = 0;
+    }
+}
+
+/* Called when the guard of the specialized instruction at 'index' failed:
+   count the miss, and rewrite the instruction back into the generic one
+   if it keeps missing. */
+static void
+unspecialize(PyCodeObject *co, _PyOpcache *entry, Py_ssize_t index,
+             int opcode, int generic)
+{
+    assert(co->co_quickened != NULL);
+    assert(_Py_OPCODE(co->co_quickened[index]) == opcode);
+
+    spec_stats[opcode].miss++;
+    if (--entry->optimized <= 0) {
+        spec_stats[opcode].deopt++;
+        _Py_SET_OPCODE(co->co_quickened[index], generic);
+        entry->optimized = -1;
+        co->co_opcache_map[index + 1] = 0;
+    }
+}
+
 static PyObject *
 unicode_concatenate(PyObject *v, PyObject *w,
                     PyFrameObject *f, const _Py_CODEUNIT *next_instr)
@@ -5034,6 +5819,222 @@ unicode_concatenate(PyObject *v, PyObject *w,
     return res;
 }
 
+PyObject *
+_Py_GetSpecializationStats(PyObject *self, PyObject *unused)
+{
+    static const struct {
+        int opcode;
+        const char *name;
+    } generic[] = {
+        {BINARY_ADD, "BINARY_ADD"},
+        {BINARY_SUBTRACT, "BINARY_SUBTRACT"},
+        {BINARY_MULTIPLY, "BINARY_MULTIPLY"},
+        {COMPARE_OP, "COMPARE_OP"},
+        {0, NULL}
+    }, specialized[] = {
+        {BINARY_ADD_INT, "BINARY_ADD_INT"},
+        {BINARY_ADD_FLOAT, "BINARY_ADD_FLOAT"},
+        {BINARY_SUBTRACT_INT, "BINARY_SUBTRACT_INT"},
+        {BINARY_SUBTRACT_FLOAT, "BINARY_SUBTRACT_FLOAT"},
+        {BINARY_MULTIPLY_INT, "BINARY_MULTIPLY_INT"},
+        {BINARY_MULTIPLY_FLOAT, "BINARY_MULTIPLY_FLOAT"},
+        {COMPARE_OP_INT, "COMPARE_OP_INT"},
+        {COMPARE_OP_FLOAT, "COMPARE_OP_FLOAT"},
+        {COMPARE_OP_STR, "COMPARE_OP_STR"},
+        {0, NULL}
+    };
+    PyObject *result, *stats;
+    int i;
+
+    result = PyDict_New();
+    if (result == NULL) {
+        return NULL;
+    }
+    for (i = 0; generic[i].name != NULL; i++) {
+        specialization_stats *st = &spec_stats[generic[i].opcode];
+        stats = Py_BuildValue("{sK}",
+                              "failure", (unsigned long long)st->failure);
+        if (stats == NULL ||
+            PyDict_SetItemString(result, generic[i].name, stats) < 0) {
+            goto error;
+        }
+        Py_DECREF(stats);
+    }
+    for (i = 0; specialized[i].name != NULL; i++) {
+        specialization_stats *st = &spec_stats[specialized[i].opcode];
+        stats = Py_BuildValue("{sKsKsKsK}",
+                              "specialized", (unsigned long long)st->specialized,
+                              "hit", (unsigned long long)st->hit,
+                              "miss", (unsigned long long)st->miss,
+                              "deopt", (unsigned long long)st->deopt);
+        if (stats == NULL ||
+            PyDict_SetItemString(result, specialized[i].name, stats) < 0) {
+            goto error;
+        }
+        Py_DECREF(stats);
+    }
+    return result;
+
+error:
+    Py_XDECREF(stats);
+    Py_DECREF(result);
+    return NULL;
+}
+
+int
+_PyEval_SetOpcodeProfile(int enable, int per_code)
+{
+    PyInterpreterState *interp = PyThreadState_GET()->interp;
+    struct _opcode_profile *profile = interp->opcode_profile;
+
+    if (enable) {
+        if (profile == NULL) {
+            profile = PyMem_RawCalloc(1, sizeof(struct _opcode_profile));
+            if (profile == NULL) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            profile->code_index = -1;
+            interp->opcode_profile = profile;
+        }
+        if (per_code && profile->code_index < 0) {
+            profile->code_index = _PyEval_RequestCodeExtraIndex(PyMem_Free);
+            if (profile->code_index < 0) {
+                PyErr_SetString(PyExc_RuntimeError,
+                                "too many users of code object extra data");
+                return -1;
+            }
+        }
+        profile->per_code = per_code;
+    }
+
+    if (enable != interp->opcode_profiling) {
+        _Py_TracingPossible += enable ? 1 : -1;
+        interp->opcode_profiling = enable;
+    }
+    return 0;
+}
+
+void
+_PyEval_ResetOpcodeProfile(void)
+{
+    struct _opcode_profile *profile =
+        PyThreadState_GET()->interp->opcode_profile;
+
+    if (profile != NULL) {
+        memset(profile->pairs, 0, sizeof(profile->pairs));
+        profile->generation++;
+    }
+}
+
+void
+_PyEval_FiniOpcodeProfile(PyInterpreterState *interp)
+{
+    if (interp->opcode_profiling) {
+        _Py_TracingPossible--;
+        interp->opcode_profiling = 0;
+    }
+    PyMem_RawFree(interp->opcode_profile);
+    interp->opcode_profile = NULL;
+}
+
+/* Return the opcode counters of the code object 'co', creating them if
+   needed.  Set an exception and return NULL on error. */
+static uint64_t *
+get_code_opcode_counts(struct _opcode_profile *profile, PyCodeObject *co)
+{
+    code_opcode_profile *counts;
+
+    assert(profile->code_index >= 0);
+    if (_PyCode_GetExtra((PyObject *)co, profile->code_index,
+                         (void **)&counts) < 0) {
+        return NULL;
+    }
+    if (counts == NULL) {
+        counts = PyMem_Malloc(sizeof(code_opcode_profile));
+        if (counts == NULL) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        if (_PyCode_SetExtra((PyObject *)co, profile->code_index,
+                             counts) < 0) {
+            PyMem_Free(counts);
+            return NULL;
+        }
+        counts->generation = profile->generation - 1;
+    }
+    if (counts->generation != profile->generation) {
+        memset(counts->counts, 0, sizeof(counts->counts));
+        counts->generation = profile->generation;
+    }
+    return counts->counts;
+}
+
+static PyObject *
+opcode_counts_as_list(const uint64_t *counts)
+{
+    int i;
+    PyObject *l = PyList_New(256);
+    if (l == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < 256; i++) {
+        PyObject *x = PyLong_FromUnsignedLongLong(
+            counts != NULL ? counts[i] : 0);
+        if (x == NULL) {
+            Py_DECREF(l);
+            return NULL;
+        }
+        PyList_SET_ITEM(l, i, x);
+    }
+    return l;
+}
+
+PyObject *
+_PyEval_GetOpcodeProfile(PyObject *code)
+{
+    struct _opcode_profile *profile =
+        PyThreadState_GET()->interp->opcode_profile;
+    PyObject *l;
+    int i;
+
+    if (code != NULL) {
+        code_opcode_profile *counts = NULL;
+
+        if (!PyCode_Check(code)) {
+            PyErr_Format(PyExc_TypeError,
+                         "expected a code object, got %.200s",
+                         Py_TYPE(code)->tp_name);
+            return NULL;
+        }
+        if (profile != NULL && profile->code_index >= 0) {
+            if (_PyCode_GetExtra(code, profile->code_index,
+                                 (void **)&counts) < 0) {
+                return NULL;
+            }
+            if (counts != NULL && counts->generation != profile->generation) {
+                counts = NULL;
+            }
+        }
+        return opcode_counts_as_list(counts != NULL ? counts->counts : NULL);
+    }
+
+    l = PyList_New(257);
+    if (l == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < 257; i++) {
+        PyObject *x = opcode_counts_as_list(
+            profile != NULL ? profile->pairs[i] : NULL);
+        if (x == NULL) {
+            Py_DECREF(l);
+            return NULL;
+        }
+        PyList_SET_ITEM(l, i, x);
+    }
+    return l;
+}
+
 #ifdef DYNAMIC_EXECUTION_PROFILE
 
 static PyObject *
@@ -50,6 +50,20 @@
      run and end up being the first to re-acquire it, making the "timeslices"
      much longer than expected.
      (Note: this mechanism is enabled with FORCE_SWITCHING above)
+
+   - With the default scheduling policy, any waiting thread can take the
+     GIL when it is released, and a thread coming back from I/O waits for
+     the switch interval like the others.  With the _PyGIL_SCHED_PRIORITY
+     policy (see sys._setgilscheduling()), waiting threads take tickets in
+     one of two FIFO queues, and only the thread at the head of the queues
+     can take the GIL, which prevents convoys.  Threads which released the
+     GIL voluntarily (PyEval_RestoreThread(), e.g. after a blocking I/O
+     call) are queued in the priority queue, which is served first, and its
+     head sets gil_drop_request right away instead of waiting for the
+     switch interval.  Other threads behave as with the default policy,
+     except that only the head of the queues sets gil_drop_request.
+     Since several threads may wait on `cond`, it is broadcast when the
+     queues are not empty.
 */
 
 #include "condvar.h"
@@ -76,6 +90,9 @@
 #define COND_SIGNAL(cond) \
     if (PyCOND_SIGNAL(&(cond))) { \
         Py_FatalError("PyCOND_SIGNAL(" #cond ") failed"); };
+#define COND_BROADCAST(cond) \
+    if (PyCOND_BROADCAST(&(cond))) { \
+        Py_FatalError("PyCOND_BROADCAST(" #cond ") failed"); };
 #define COND_WAIT(cond, mut) \
     if (PyCOND_WAIT(&(cond), &(mut))) { \
         Py_FatalError("PyCOND_WAIT(" #cond ") failed"); };
@@ -98,8 +115,27 @@ static void _gil_initialize(struct _gil_runtime_state *state)
     _Py_atomic_int uninitialized = {-1};
     state->locked = uninitialized;
     state->interval = DEFAULT_INTERVAL;
+    state->scheduling = _PyGIL_SCHED_DEFAULT;
+    state->stats = 0;
 }
 
+#define GIL_QUEUE_LENGTH(queue) ((queue).tail - (queue).head)
+#define GIL_QUEUED() \
+    (GIL_QUEUE_LENGTH(_PyRuntime.ceval.gil.queues[0]) + \
+     GIL_QUEUE_LENGTH(_PyRuntime.ceval.gil.queues[1]))
+
+/* Wake up threads waiting for the GIL: all of them if some are queued,
+   since only the head of the queues may take it. */
+#define GIL_WAKE_UP() \
+    do { \
+        if (GIL_QUEUED()) { \
+            COND_BROADCAST(_PyRuntime.ceval.gil.cond); \
+        } \
+        else { \
+            COND_SIGNAL(_PyRuntime.ceval.gil.cond); \
+        } \
+    } while (0)
+
 static int gil_created(void)
 {
     return (_Py_atomic_load_explicit(&_PyRuntime.ceval.gil.locked,
@@ -118,6 +154,8 @@ static void create_gil(void)
     COND_INIT(_PyRuntime.ceval.gil.switch_cond);
 #endif
     _Py_atomic_store_relaxed(&_PyRuntime.ceval.gil.last_holder, 0);
+    memset(_PyRuntime.ceval.gil.queues, 0,
+           sizeof(_PyRuntime.ceval.gil.queues));
     _Py_ANNOTATE_RWLOCK_CREATE(&_PyRuntime.ceval.gil.locked);
     _Py_atomic_store_explicit(&_PyRuntime.ceval.gil.locked, 0,
                               _Py_memory_order_release);
@@ -146,6 +184,56 @@ static void recreate_gil(void)
     create_gil();
 }
 
+/* Index of the bucket of the GIL wait and hold time histograms counting
+   'duration' */
+static int gil_histogram_bucket(_PyTime_t duration)
+{
+    _PyTime_t us = _PyTime_AsMicroseconds(duration, _PyTime_ROUND_FLOOR);
+    int bucket = 0;
+    while (us > 0 && bucket < _PyGIL_HISTOGRAM_SIZE - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/* Record that tstate took the GIL after waiting 'wait', during which it set
+   gil_drop_request 'drop_requests' times. */
+static void gil_stats_take(PyThreadState *tstate, _PyTime_t now,
+                           _PyTime_t wait, unsigned long drop_requests)
+{
+    struct _gil_thread_stats *stats = tstate->gil_stats;
+    if (stats == NULL) {
+        stats = PyMem_RawCalloc(1, sizeof(struct _gil_thread_stats));
+        if (stats == NULL) {
+            return;
+        }
+        tstate->gil_stats = stats;
+    }
+    stats->wait_histogram[gil_histogram_bucket(wait)]++;
+    stats->drop_requests += drop_requests;
+    stats->hold_start = now;
+}
+
+/* Record that tstate is about to drop the GIL. */
+static void gil_stats_drop(PyThreadState *tstate)
+{
+    struct _gil_thread_stats *stats = tstate->gil_stats;
+    if (_PyRuntime.ceval.gil.stats && stats->hold_start != 0) {
+        _PyTime_t hold = _PyTime_GetMonotonicClock() - stats->hold_start;
+        stats->hold_histogram[gil_histogram_bucket(hold)]++;
+    }
+    stats->hold_start = 0;
+}
+
+/* Record that tstate is about to drop the GIL because of gil_drop_request. */
+static void gil_stats_forced_switch(PyThreadState *tstate)
+{
+    if (_PyRuntime.ceval.gil.stats && tstate->gil_stats != NULL) {
+        tstate->gil_stats->forced_switches++;
+    }
+}
+
 static void drop_gil(PyThreadState *tstate)
 {
     if (!_Py_atomic_load_relaxed(&_PyRuntime.ceval.gil.locked))
@@ -157,12 +245,15 @@ static void drop_gil(PyThreadState *tstate)
            holder variable so that our heuristics work. */
         _Py_atomic_store_relaxed(&_PyRuntime.ceval.gil.last_holder,
                                  (uintptr_t)tstate);
+        if (tstate->gil_stats != NULL) {
+            gil_stats_drop(tstate);
+        }
     }
 
     MUTEX_LOCK(_PyRuntime.ceval.gil.mutex);
     _Py_ANNOTATE_RWLOCK_RELEASED(&_PyRuntime.ceval.gil.locked, /*is_write=*/1);
     _Py_atomic_store_relaxed(&_PyRuntime.ceval.gil.locked, 0);
-    COND_SIGNAL(_PyRuntime.ceval.gil.cond);
+    GIL_WAKE_UP();
     MUTEX_UNLOCK(_PyRuntime.ceval.gil.mutex);
 
 #ifdef FORCE_SWITCHING
@@ -188,17 +279,75 @@ static void drop_gil(PyThreadState *tstate)
 #endif
 }
 
-static void take_gil(PyThreadState *tstate)
+/* Wait until the ticket of the calling thread is at the head of the GIL
+   queues and the GIL is released.  Called with the GIL mutex held.
+   Return the number of times gil_drop_request was set. */
+static unsigned long wait_gil_turn(int priority)
+{
+    struct _gil_runtime_state *gil = &_PyRuntime.ceval.gil;
+    struct _gil_queue *queue = &gil->queues[priority];
+    unsigned long ticket = queue->tail++;
+    unsigned long drop_requests = 0;
+
+#define IS_NEXT_HOLDER() \
+    (queue->head == ticket && \
+     (priority || GIL_QUEUE_LENGTH(gil->queues[1]) == 0))
+
+    while (_Py_atomic_load_relaxed(&gil->locked) || !IS_NEXT_HOLDER()) {
+        if (!IS_NEXT_HOLDER()) {
+            COND_WAIT(gil->cond, gil->mutex);
+        }
+        else if (priority) {
+            SET_GIL_DROP_REQUEST();
+            drop_requests++;
+            COND_WAIT(gil->cond, gil->mutex);
+        }
+        else {
+            int timed_out = 0;
+            unsigned long saved_switchnum = gil->switch_number;
+            COND_TIMED_WAIT(gil->cond, gil->mutex, INTERVAL, timed_out);
+            if (timed_out &&
+                _Py_atomic_load_relaxed(&gil->locked) &&
+                gil->switch_number == saved_switchnum &&
+                IS_NEXT_HOLDER()) {
+                SET_GIL_DROP_REQUEST();
+                drop_requests++;
+            }
+        }
+    }
+#undef IS_NEXT_HOLDER
+
+    queue->head++;
+    if (GIL_QUEUED()) {
+        /* Let the new head of the queues ask for the GIL */
+        COND_BROADCAST(gil->cond);
+    }
+    return drop_requests;
+}
+
+/* 'priority' is non-zero if the thread released the GIL voluntarily,
+   e.g. to block on I/O. */
+static void take_gil(PyThreadState *tstate, int priority)
 {
     int err;
+    _PyTime_t wait_start = 0;
+    unsigned long drop_requests = 0;
     if (tstate == NULL)
         Py_FatalError("take_gil: NULL tstate");
 
     err = errno;
     MUTEX_LOCK(_PyRuntime.ceval.gil.mutex);
 
-    if (!_Py_atomic_load_relaxed(&_PyRuntime.ceval.gil.locked))
+    if (!_Py_atomic_load_relaxed(&_PyRuntime.ceval.gil.locked) &&
+        GIL_QUEUED() == 0)
+        goto _ready;
+
+    wait_start = _PyTime_GetMonotonicClock();
+
+    if (_PyRuntime.ceval.gil.scheduling == _PyGIL_SCHED_PRIORITY) {
+        drop_requests = wait_gil_turn(priority);
         goto _ready;
+    }
 
     while (_Py_atomic_load_relaxed(&_PyRuntime.ceval.gil.locked)) {
         int timed_out = 0;
@@ -213,6 +362,7 @@ static void take_gil(PyThreadState *tstate)
             _Py_atomic_load_relaxed(&_PyRuntime.ceval.gil.locked) &&
             _PyRuntime.ceval.gil.switch_number == saved_switchnum) {
             SET_GIL_DROP_REQUEST();
+            drop_requests++;
         }
     }
 _ready:
@@ -244,6 +394,22 @@ _ready:
         _PyEval_SignalAsyncExc();
     }
 
+    if (wait_start != 0 || _PyRuntime.ceval.gil.stats) {
+        _PyTime_t now = _PyTime_GetMonotonicClock();
+        _PyTime_t wait = 0;
+        if (wait_start != 0) {
+            wait = now - wait_start;
+            tstate->gil_wait_count++;
+            tstate->gil_wait_total += wait;
+            if (wait > tstate->gil_wait_max) {
+                tstate->gil_wait_max = wait;
+            }
+        }
+        if (_PyRuntime.ceval.gil.stats) {
+            gil_stats_take(tstate, now, wait, drop_requests);
+        }
+    }
+
     MUTEX_UNLOCK(_PyRuntime.ceval.gil.mutex);
     errno = err;
 }
@@ -257,3 +423,30 @@ unsigned long _PyEval_GetSwitchInterval()
 {
     return _PyRuntime.ceval.gil.interval;
 }
+
+void _PyEval_SetGILScheduling(int policy)
+{
+    assert(policy == _PyGIL_SCHED_DEFAULT || policy == _PyGIL_SCHED_PRIORITY);
+    if (!gil_created()) {
+        _PyRuntime.ceval.gil.scheduling = policy;
+        return;
+    }
+    MUTEX_LOCK(_PyRuntime.ceval.gil.mutex);
+    _PyRuntime.ceval.gil.scheduling = policy;
+    MUTEX_UNLOCK(_PyRuntime.ceval.gil.mutex);
+}
+
+int _PyEval_GetGILScheduling()
+{
+    return _PyRuntime.ceval.gil.scheduling;
+}
+
+void _PyEval_SetGILStats(int enable)
+{
+    _PyRuntime.ceval.gil.stats = enable;
+}
+
+int _PyEval_GetGILStats()
+{
+    return _PyRuntime.ceval.gil.stats;
+}
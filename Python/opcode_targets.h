@@ -199,15 +199,15 @@ static void *opcode_targets[256] = {
     &&_unknown_opcode,
     &&_unknown_opcode,
     &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
-    &&_unknown_opcode,
+    &&TARGET_BINARY_ADD_INT,
+    &&TARGET_BINARY_ADD_FLOAT,
+    &&TARGET_BINARY_SUBTRACT_INT,
+    &&TARGET_BINARY_SUBTRACT_FLOAT,
+    &&TARGET_BINARY_MULTIPLY_INT,
+    &&TARGET_BINARY_MULTIPLY_FLOAT,
+    &&TARGET_COMPARE_OP_INT,
+    &&TARGET_COMPARE_OP_FLOAT,
+    &&TARGET_COMPARE_OP_STR,
     &&_unknown_opcode,
     &&_unknown_opcode,
     &&_unknown_opcode,
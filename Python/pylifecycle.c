@@ -618,6 +618,14 @@ _Py_InitializeCore(const _PyCoreConfig *core_config)
         }
     }
 
+    if (core_config->arena_size != 0 || core_config->hugepages) {
+        const char *msg = _PyObject_SetArenaConfig(core_config->arena_size,
+                                                   core_config->hugepages);
+        if (msg != NULL) {
+            return _Py_INIT_USER_ERR(msg);
+        }
+    }
+
     if (_PyRuntime.initialized) {
         return _Py_INIT_ERR("main interpreter already initialized");
     }
@@ -853,6 +861,10 @@ _Py_InitializeMainInterpreter(const _PyMainInterpreterConfig *config)
     if (_PyTraceMalloc_Init(interp->core_config.tracemalloc) < 0)
         return _Py_INIT_ERR("can't initialize tracemalloc");
 
+    if (interp->core_config.opcode_profile &&
+        _PyEval_SetOpcodeProfile(1, interp->core_config.opcode_profile == 2) < 0)
+        return _Py_INIT_ERR("can't enable the opcode profiler");
+
     err = add_main_module(interp);
     if (_Py_INIT_FAILED(err)) {
         return err;
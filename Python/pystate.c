@@ -3,6 +3,7 @@
 
 #include "Python.h"
 #include "internal/pystate.h"
+#include "frameobject.h"
 
 #define GET_TSTATE() \
     ((PyThreadState*)_Py_atomic_load_relaxed(&_PyThreadState_Current))
@@ -141,6 +142,8 @@ PyInterpreterState_New(void)
     interp->import_func = NULL;
     interp->eval_frame = _PyEval_EvalFrameDefault;
     interp->co_extra_user_count = 0;
+    interp->opcode_profiling = 0;
+    interp->opcode_profile = NULL;
 #ifdef HAVE_DLOPEN
 #if HAVE_DECL_RTLD_NOW
     interp->dlopenflags = RTLD_NOW;
@@ -197,6 +200,7 @@ PyInterpreterState_Clear(PyInterpreterState *interp)
     Py_CLEAR(interp->builtins_copy);
     Py_CLEAR(interp->importlib);
     Py_CLEAR(interp->import_func);
+    _PyEval_FiniOpcodeProfile(interp);
 #ifdef HAVE_FORK
     Py_CLEAR(interp->before_forkers);
     Py_CLEAR(interp->after_forkers_parent);
@@ -311,6 +315,15 @@ new_threadstate(PyInterpreterState *interp, int init)
         tstate->async_gen_firstiter = NULL;
         tstate->async_gen_finalizer = NULL;
 
+        tstate->gil_wait_count = 0;
+        tstate->gil_wait_total = 0;
+        tstate->gil_wait_max = 0;
+        tstate->gil_stats = NULL;
+        tstate->pymalloc_cache = NULL;
+        tstate->datastack_chunk = NULL;
+        tstate->datastack_top = NULL;
+        tstate->datastack_limit = NULL;
+
         if (init)
             _PyThreadState_Init(tstate);
 
@@ -469,7 +482,7 @@ PyThreadState_Clear(PyThreadState *tstate)
         fprintf(stderr,
           "PyThreadState_Clear: warning: thread still has a frame\n");
 
-    Py_CLEAR(tstate->frame);
+    _PyFrame_ClearDataStack(tstate);
 
     Py_CLEAR(tstate->dict);
     Py_CLEAR(tstate->async_exc);
@@ -497,6 +510,8 @@ PyThreadState_Clear(PyThreadState *tstate)
     Py_CLEAR(tstate->coroutine_wrapper);
     Py_CLEAR(tstate->async_gen_firstiter);
     Py_CLEAR(tstate->async_gen_finalizer);
+
+    _PyObject_ClearThreadCache(tstate);
 }
 
 
@@ -521,6 +536,9 @@ tstate_delete_common(PyThreadState *tstate)
     if (tstate->on_delete != NULL) {
         tstate->on_delete(tstate->on_delete_data);
     }
+    /* Blocks freed between PyThreadState_Clear() and here */
+    _PyObject_ClearThreadCache(tstate);
+    PyMem_RawFree(tstate->gil_stats);
     PyMem_RawFree(tstate);
 }
 
@@ -589,6 +607,7 @@ _PyThreadState_DeleteExcept(PyThreadState *tstate)
     for (p = garbage; p; p = next) {
         next = p->next;
         PyThreadState_Clear(p);
+        PyMem_RawFree(p->gil_stats);
         PyMem_RawFree(p);
     }
 }
@@ -764,6 +783,9 @@ _PyThread_CurrentFrames(void)
             struct _frame *frame = t->frame;
             if (frame == NULL)
                 continue;
+            frame = _PyFrame_Materialize(frame);
+            if (frame == NULL)
+                goto Fail;
             id = PyLong_FromUnsignedLong(t->thread_id);
             if (id == NULL)
                 goto Fail;
@@ -782,6 +804,144 @@ _PyThread_CurrentFrames(void)
     return NULL;
 }
 
+static PyObject *
+gil_histogram_as_list(const uint64_t *histogram)
+{
+    PyObject *l = PyList_New(_PyGIL_HISTOGRAM_SIZE);
+    int i;
+    if (l == NULL)
+        return NULL;
+    for (i = 0; i < _PyGIL_HISTOGRAM_SIZE; i++) {
+        PyObject *x = PyLong_FromUnsignedLongLong(histogram[i]);
+        if (x == NULL) {
+            Py_DECREF(l);
+            return NULL;
+        }
+        PyList_SET_ITEM(l, i, x);
+    }
+    return l;
+}
+
+/* The implementation of sys._getgilstats(), to be called with the GIL held,
+   like sys._getgilwaitstats() below. */
+PyObject *
+_PyThread_GILStats(void)
+{
+    PyObject *result;
+    PyThreadState *t;
+
+    result = PyDict_New();
+    if (result == NULL)
+        return NULL;
+
+    HEAD_LOCK();
+    for (t = PyThreadState_GET()->interp->tstate_head; t != NULL;
+         t = t->next) {
+        struct _gil_thread_stats *gs = t->gil_stats;
+        PyObject *id, *wait, *hold, *stats;
+        int stat;
+        if (gs == NULL)
+            continue;
+        wait = gil_histogram_as_list(gs->wait_histogram);
+        hold = gil_histogram_as_list(gs->hold_histogram);
+        if (wait == NULL || hold == NULL) {
+            Py_XDECREF(wait);
+            Py_XDECREF(hold);
+            goto Fail;
+        }
+        stats = Py_BuildValue("{sNsNsKsK}",
+                              "wait_histogram", wait,
+                              "hold_histogram", hold,
+                              "forced_switches",
+                              (unsigned long long)gs->forced_switches,
+                              "drop_requests",
+                              (unsigned long long)gs->drop_requests);
+        if (stats == NULL)
+            goto Fail;
+        id = PyLong_FromUnsignedLong(t->thread_id);
+        if (id == NULL) {
+            Py_DECREF(stats);
+            goto Fail;
+        }
+        stat = PyDict_SetItem(result, id, stats);
+        Py_DECREF(id);
+        Py_DECREF(stats);
+        if (stat < 0)
+            goto Fail;
+    }
+    HEAD_UNLOCK();
+    return result;
+
+ Fail:
+    HEAD_UNLOCK();
+    Py_DECREF(result);
+    return NULL;
+}
+
+/* The implementation of sys._resetgilstats(), to be called with the GIL
+   held. */
+void
+_PyThread_ResetGILStats(void)
+{
+    PyThreadState *t;
+
+    HEAD_LOCK();
+    for (t = PyThreadState_GET()->interp->tstate_head; t != NULL;
+         t = t->next) {
+        struct _gil_thread_stats *gs = t->gil_stats;
+        if (gs != NULL) {
+            _PyTime_t hold_start = gs->hold_start;
+            memset(gs, 0, sizeof(*gs));
+            gs->hold_start = hold_start;
+        }
+    }
+    HEAD_UNLOCK();
+}
+
+/* The implementation of sys._getgilwaitstats(), to be called with the GIL
+   held: the statistics of other threads are only modified while they hold
+   the GIL. */
+PyObject *
+_PyThread_GILWaitStats(void)
+{
+    PyObject *result;
+    PyThreadState *t;
+
+    result = PyDict_New();
+    if (result == NULL)
+        return NULL;
+
+    HEAD_LOCK();
+    for (t = PyThreadState_GET()->interp->tstate_head; t != NULL;
+         t = t->next) {
+        PyObject *id, *stats;
+        int stat;
+        id = PyLong_FromUnsignedLong(t->thread_id);
+        if (id == NULL)
+            goto Fail;
+        stats = Py_BuildValue("(Kdd)",
+                              (unsigned long long)t->gil_wait_count,
+                              _PyTime_AsSecondsDouble(t->gil_wait_total),
+                              _PyTime_AsSecondsDouble(t->gil_wait_max));
+        if (stats == NULL) {
+            Py_DECREF(id);
+            goto Fail;
+        }
+        stat = PyDict_SetItem(result, id, stats);
+        Py_DECREF(id);
+        Py_DECREF(stats);
+        if (stat < 0)
+            goto Fail;
+    }
+    HEAD_UNLOCK();
+    return result;
+
+ Fail:
+    HEAD_UNLOCK();
+    Py_DECREF(result);
+    return NULL;
+}
+
 /* Python "auto thread state" API. */
 
 /* Keep this as a static, as it is not reliable!  It can only
@@ -500,21 +500,22 @@ trace_trampoline(PyObject *self, PyFrameObject *frame,
 {
     PyObject *callback;
     PyObject *result;
+    PyFrameObject *live = _PyFrame_LIVE(frame);
 
     if (what == PyTrace_CALL)
         callback = self;
     else
-        callback = frame->f_trace;
+        callback = live->f_trace;
     if (callback == NULL)
         return 0;
     result = call_trampoline(callback, frame, what, arg);
     if (result == NULL) {
         PyEval_SetTrace(NULL, NULL);
-        Py_CLEAR(frame->f_trace);
+        Py_CLEAR(live->f_trace);
         return -1;
     }
     if (result != Py_None) {
-        Py_XSETREF(frame->f_trace, result);
+        Py_XSETREF(live->f_trace, result);
     }
     else {
         Py_DECREF(result);
@@ -672,6 +673,114 @@ PyDoc_STRVAR(getswitchinterval_doc,
 "getswitchinterval() -> current thread switch interval; see setswitchinterval()."
 );
 
+static PyObject *
+sys_setgilscheduling(PyObject *self, PyObject *args)
+{
+    const char *policy;
+    if (!PyArg_ParseTuple(args, "s:_setgilscheduling", &policy))
+        return NULL;
+    if (strcmp(policy, "default") == 0)
+        _PyEval_SetGILScheduling(_PyGIL_SCHED_DEFAULT);
+    else if (strcmp(policy, "priority") == 0)
+        _PyEval_SetGILScheduling(_PyGIL_SCHED_PRIORITY);
+    else {
+        PyErr_Format(PyExc_ValueError,
+                     "unknown GIL scheduling policy: %s", policy);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(setgilscheduling_doc,
+"_setgilscheduling(policy)\n\
+\n\
+Set the policy deciding which waiting thread takes the GIL next.\n\
+With 'default', any waiting thread can take it.  With 'priority',\n\
+waiting threads take the GIL in FIFO order, and threads which released\n\
+it voluntarily (e.g. for a blocking I/O call) take it first, without\n\
+waiting for the switch interval."
+);
+
+static PyObject *
+sys_getgilscheduling(PyObject *self, PyObject *args)
+{
+    if (_PyEval_GetGILScheduling() == _PyGIL_SCHED_PRIORITY)
+        return PyUnicode_FromString("priority");
+    return PyUnicode_FromString("default");
+}
+
+PyDoc_STRVAR(getgilscheduling_doc,
+"_getgilscheduling() -> current GIL scheduling policy; see _setgilscheduling()."
+);
+
+static PyObject *
+sys_getgilwaitstats(PyObject *self, PyObject *args)
+{
+    return _PyThread_GILWaitStats();
+}
+
+PyDoc_STRVAR(getgilwaitstats_doc,
+"_getgilwaitstats() -> dictionary\n\
+\n\
+Return a dictionary mapping each thread's identifier to a tuple\n\
+(count, total, max): the number of times the thread had to wait for\n\
+the GIL, and the total and longest time it waited, in seconds."
+);
+
+static PyObject *
+sys_setgilstats(PyObject *self, PyObject *args)
+{
+    int enabled;
+    if (!PyArg_ParseTuple(args, "p:_setgilstats", &enabled))
+        return NULL;
+    _PyEval_SetGILStats(enabled);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(setgilstats_doc,
+"_setgilstats(enabled)\n\
+\n\
+Enable or disable the collection of detailed GIL statistics; see\n\
+_getgilstats()."
+);
+
+static PyObject *
+sys_getgilstats(PyObject *self, PyObject *args)
+{
+    return _PyThread_GILStats();
+}
+
+PyDoc_STRVAR(getgilstats_doc,
+"_getgilstats() -> dictionary\n\
+\n\
+Return a dictionary mapping the identifier of each thread which ran while\n\
+GIL statistics were enabled to a dictionary with the keys:\n\
+\n\
+wait_histogram -- histogram of the times the thread waited for the GIL\n\
+hold_histogram -- histogram of the times the thread held the GIL\n\
+forced_switches -- number of times the thread had to drop the GIL\n\
+    because another thread requested it\n\
+drop_requests -- number of times the thread requested another thread\n\
+    to drop the GIL\n\
+\n\
+The first bucket of a histogram counts durations under 1 microsecond,\n\
+bucket i durations in [2**(i-1), 2**i) microseconds, and the last one\n\
+also longer durations."
+);
+
+static PyObject *
+sys_resetgilstats(PyObject *self, PyObject *args)
+{
+    _PyThread_ResetGILStats();
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(resetgilstats_doc,
+"_resetgilstats()\n\
+\n\
+Reset the detailed GIL statistics of all threads to zero."
+);
+
 static PyObject *
 sys_setrecursionlimit(PyObject *self, PyObject *args)
 {
@@ -1288,7 +1397,8 @@ sys_getframe(PyObject *self, PyObject *args)
                         "call stack is not deep enough");
         return NULL;
     }
-    Py_INCREF(f);
+    f = _PyFrame_Materialize(f);
+    Py_XINCREF(f);
     return (PyObject*)f;
 }
 
@@ -1386,6 +1496,79 @@ In Py_DEBUG mode, also perform some expensive internal consistency\n\
 checks.\n\
 ");
 
+static PyObject *
+sys_setmalloccache(PyObject *self, PyObject *args)
+{
+    int enabled;
+    if (!PyArg_ParseTuple(args, "p:_setmalloccache", &enabled))
+        return NULL;
+    (void)_PyObject_SetThreadCacheEnabled(enabled);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(setmalloccache_doc,
+"_setmalloccache(enabled)\n\
+\n\
+Enable or disable the per-thread caches of free pymalloc blocks.\n\
+Disabling them gives the cached blocks back to the allocator."
+);
+
+static PyObject *
+sys_getmalloccache(PyObject *self, PyObject *args)
+{
+    return PyBool_FromLong(_PyObject_GetThreadCacheEnabled());
+}
+
+PyDoc_STRVAR(getmalloccache_doc,
+"_getmalloccache() -> bool\n\
+\n\
+Return True if the per-thread caches of free pymalloc blocks are enabled."
+);
+
+static PyObject *
+sys_malloctrim(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"lazy", 0};
+    int lazy = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p:_malloctrim",
+                                     kwlist, &lazy))
+        return NULL;
+    return PyLong_FromSize_t(_PyObject_TrimArenas(lazy));
+}
+
+PyDoc_STRVAR(malloctrim_doc,
+"_malloctrim(lazy=False) -> int\n\
+\n\
+Give the memory of the free pools of pymalloc arenas back to the system,\n\
+and return the number of bytes released.  If lazy is true, the system\n\
+only reclaims the memory when it needs it (MADV_FREE)."
+);
+
+static PyObject *
+sys_getdictsharingstats(PyObject *self, PyObject *args)
+{
+    return _PyDict_GetSharingStats();
+}
+
+PyDoc_STRVAR(getdictsharingstats_doc,
+"_getdictsharingstats() -> dictionary\n\
+\n\
+Return statistics on the instance dictionaries sharing their keys:\n\
+\n\
+created -- number of dictionaries created with the keys of a class\n\
+unshared -- number of dictionaries which stopped sharing their keys,\n\
+    counted again by reason in the next entries\n\
+order -- a key was set out of the shared order\n\
+deletion -- a key was deleted\n\
+non_str -- a key was not a str\n\
+full -- the shared keys were full, and shared with other dictionaries\n\
+other -- any other reason\n\
+variants_created -- number of other key orders shared by a class\n\
+variant_switches -- number of dictionaries which kept sharing their keys\n\
+    by switching to another key order of their class"
+);
+
 #ifdef Py_TRACE_REFS
 /* Defined in objects.c because it uses static globals if that file */
 extern PyObject *_Py_GetObjects(PyObject *, PyObject *);
@@ -1396,10 +1579,88 @@ extern PyObject *_Py_GetObjects(PyObject *, PyObject *);
 extern PyObject *_Py_GetDXProfile(PyObject *,  PyObject *);
 #endif
 
+/* Defined in ceval.c because it uses static globals of that file */
+extern PyObject *_Py_GetSpecializationStats(PyObject *, PyObject *);
+
+PyDoc_STRVAR(getspecializationstats_doc,
+"_getspecializationstats() -> dict\n\
+\n\
+Return statistics about the adaptive specialization of instructions in\n\
+hot code objects.  Keys are opcode names.  Specialized instructions map\n\
+to the number of instructions rewritten into them ('specialized'), of\n\
+executions whose type guard succeeded ('hit') or failed ('miss'), and of\n\
+instructions rewritten back to the generic instruction ('deopt').\n\
+Generic instructions map to the number of failed attempts to specialize\n\
+them ('failure').\n\
+\n\
+This function should be used for internal and specialized purposes only."
+);
+
 #ifdef __cplusplus
 }
 #endif
 
+static PyObject *
+sys_setopcodeprofile(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"enabled", "per_code", 0};
+    int enabled, per_code = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "p|p:_setopcodeprofile",
+                                     kwlist, &enabled, &per_code))
+        return NULL;
+    if (_PyEval_SetOpcodeProfile(enabled, per_code) < 0)
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(setopcodeprofile_doc,
+"_setopcodeprofile(enabled, per_code=False)\n\
+\n\
+Enable or disable the opcode profiler of the current interpreter.  While\n\
+enabled, it counts executed opcodes and opcode pairs, and also opcodes per\n\
+code object if per_code is true.  Enabling it slows down the interpreter.\n\
+\n\
+This function should be used for internal and specialized purposes only."
+);
+
+static PyObject *
+sys_getopcodeprofile(PyObject *self, PyObject *args)
+{
+    PyObject *code = NULL;
+
+    if (!PyArg_ParseTuple(args, "|O:_getopcodeprofile", &code))
+        return NULL;
+    return _PyEval_GetOpcodeProfile(code);
+}
+
+PyDoc_STRVAR(getopcodeprofile_doc,
+"_getopcodeprofile([code]) -> list\n\
+\n\
+Return the counts of the opcode profiler as a list of 257 lists of 256\n\
+ints: the item [i][j] is the number of times opcode j was executed right\n\
+after opcode i, and the item [256][j] the number of times opcode j was\n\
+executed.  If a code object is given, return the list of 256 ints counting\n\
+its opcodes instead, which requires per_code profiling.\n\
+\n\
+This function should be used for internal and specialized purposes only."
+);
+
+static PyObject *
+sys_resetopcodeprofile(PyObject *self, PyObject *args)
+{
+    _PyEval_ResetOpcodeProfile();
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(resetopcodeprofile_doc,
+"_resetopcodeprofile()\n\
+\n\
+Reset all counts of the opcode profiler to zero.\n\
+\n\
+This function should be used for internal and specialized purposes only."
+);
+
 static PyObject *
 sys_clear_type_cache(PyObject* self, PyObject* args)
 {
@@ -1499,6 +1760,15 @@ static PyMethodDef sys_methods[] = {
      setswitchinterval_doc},
     {"getswitchinterval",       sys_getswitchinterval, METH_NOARGS,
      getswitchinterval_doc},
+    {"_setgilscheduling", sys_setgilscheduling, METH_VARARGS,
+     setgilscheduling_doc},
+    {"_getgilscheduling", sys_getgilscheduling, METH_NOARGS,
+     getgilscheduling_doc},
+    {"_getgilwaitstats", sys_getgilwaitstats, METH_NOARGS,
+     getgilwaitstats_doc},
+    {"_setgilstats", sys_setgilstats, METH_VARARGS, setgilstats_doc},
+    {"_getgilstats", sys_getgilstats, METH_NOARGS, getgilstats_doc},
+    {"_resetgilstats", sys_resetgilstats, METH_NOARGS, resetgilstats_doc},
 #ifdef HAVE_DLOPEN
     {"setdlopenflags", sys_setdlopenflags, METH_VARARGS,
      setdlopenflags_doc},
@@ -1512,6 +1782,22 @@ static PyMethodDef sys_methods[] = {
     {"call_tracing", sys_call_tracing, METH_VARARGS, call_tracing_doc},
     {"_debugmallocstats", sys_debugmallocstats, METH_NOARGS,
      debugmallocstats_doc},
+    {"_setmalloccache", sys_setmalloccache, METH_VARARGS,
+     setmalloccache_doc},
+    {"_getmalloccache", sys_getmalloccache, METH_NOARGS,
+     getmalloccache_doc},
+    {"_malloctrim", (PyCFunction)sys_malloctrim,
+     METH_VARARGS | METH_KEYWORDS, malloctrim_doc},
+    {"_getdictsharingstats", sys_getdictsharingstats, METH_NOARGS,
+     getdictsharingstats_doc},
+    {"_getspecializationstats", _Py_GetSpecializationStats, METH_NOARGS,
+     getspecializationstats_doc},
+    {"_setopcodeprofile", (PyCFunction)sys_setopcodeprofile,
+     METH_VARARGS | METH_KEYWORDS, setopcodeprofile_doc},
+    {"_getopcodeprofile", sys_getopcodeprofile, METH_VARARGS,
+     getopcodeprofile_doc},
+    {"_resetopcodeprofile", sys_resetopcodeprofile, METH_NOARGS,
+     resetopcodeprofile_doc},
     {"set_coroutine_wrapper", sys_set_coroutine_wrapper, METH_O,
      set_coroutine_wrapper_doc},
     {"get_coroutine_wrapper", sys_get_coroutine_wrapper, METH_NOARGS,
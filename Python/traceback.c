@@ -112,19 +112,27 @@ static PyTracebackObject *
 newtracebackobject(PyTracebackObject *next, PyFrameObject *frame)
 {
     PyTracebackObject *tb;
+    PyFrameObject *frameobj, *live;
     if ((next != NULL && !PyTraceBack_Check(next)) ||
                     frame == NULL || !PyFrame_Check(frame)) {
         PyErr_BadInternalCall();
         return NULL;
     }
+    /* The frame may be on the data stack, or forward to a frame on the
+       data stack: the traceback references the frame object, and takes
+       f_lasti from the executing frame. */
+    frameobj = _PyFrame_Materialize(frame);
+    if (frameobj == NULL)
+        return NULL;
+    live = _PyFrame_LIVE(frame);
     tb = PyObject_GC_New(PyTracebackObject, &PyTraceBack_Type);
     if (tb != NULL) {
         Py_XINCREF(next);
         tb->tb_next = next;
-        Py_XINCREF(frame);
-        tb->tb_frame = frame;
-        tb->tb_lasti = frame->f_lasti;
-        tb->tb_lineno = PyFrame_GetLineNumber(frame);
+        Py_INCREF(frameobj);
+        tb->tb_frame = frameobj;
+        tb->tb_lasti = live->f_lasti;
+        tb->tb_lineno = PyFrame_GetLineNumber(live);
         PyObject_GC_Track(tb);
     }
     return tb;
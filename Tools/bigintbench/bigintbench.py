@@ -0,0 +1,73 @@
+"""Benchmark arithmetic on huge ints.
+
+Measure the time of str(), int(str), divmod() and pow() with a modulus on
+random ints of several sizes, given in bits.  The quotient of divmod() is
+about as large as the divisor; pow() raises to a small exponent so that the
+modular reductions weigh as much as the multiplications.  Compare the
+results of two builds to evaluate a change of the algorithms.
+"""
+
+import argparse
+import random
+import time
+
+
+def bench_str(a, b, s, args):
+    t0 = time.perf_counter()
+    str(a)
+    return time.perf_counter() - t0
+
+def bench_int(a, b, s, args):
+    t0 = time.perf_counter()
+    int(s)
+    return time.perf_counter() - t0
+
+def bench_divmod(a, b, s, args):
+    t0 = time.perf_counter()
+    divmod(a * b, b)
+    return time.perf_counter() - t0
+
+def bench_pow(a, b, s, args):
+    e = random.Random(0).getrandbits(args.exponent) | 1
+    t0 = time.perf_counter()
+    pow(a, e, b)
+    return time.perf_counter() - t0
+
+BENCHMARKS = [
+    ('str', bench_str),
+    ('int(str)', bench_int),
+    ('divmod', bench_divmod),
+    ('pow', bench_pow),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-s', '--sizes', type=int, nargs='+',
+                        default=[10**4, 10**5, 10**6],
+                        help='numbers of bits (default: %(default)s)')
+    parser.add_argument('-e', '--exponent', type=int, default=16,
+                        help='number of bits of the exponent of pow() '
+                             '(default: %(default)s)')
+    parser.add_argument('-r', '--repeat', type=int, default=3,
+                        help='number of timings, the best one is kept '
+                             '(default: %(default)s)')
+    options = parser.parse_args()
+
+    print('%9s' % 'bits'
+          + ''.join('%11s' % name for name, func in BENCHMARKS)
+          + '  (ms)')
+    for n in options.sizes:
+        rng = random.Random(n)
+        a = rng.getrandbits(n) | (1 << (n - 1))
+        b = rng.getrandbits(n) | (1 << (n - 1)) | 1
+        s = str(a)
+        timings = [min(func(a, b, s, options)
+                       for i in range(options.repeat))
+                   for name, func in BENCHMARKS]
+        print('%9d' % n
+              + ''.join('%11.1f' % (t * 1e3) for t in timings))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,190 @@
+"""Benchmark calls of Python functions and types.
+
+Measure the time of calls of functions with positional arguments (the fast
+path of calls), with keyword arguments and default values, with closures,
+of methods, and of a recursive function, in nanoseconds per call.  Compare
+the results of two builds to evaluate a change of the creation of frames.
+
+Calls of builtin types, of Python classes and of bound methods called from
+C code are measured as well, to evaluate the overhead of building tuples of
+arguments.
+"""
+
+import argparse
+import time
+
+
+def f0():
+    pass
+
+def f3(a, b, c):
+    pass
+
+def fdef(a, b=2, c=3):
+    pass
+
+def fib(n):
+    if n < 2:
+        return n
+    return fib(n - 1) + fib(n - 2)
+
+def make_closure():
+    x = 1
+    def closure(a):
+        return a + x
+    return closure
+
+class C:
+    def method(self, a):
+        pass
+
+class Init:
+    def __init__(self, a):
+        pass
+
+class NoInit:
+    pass
+
+
+def bench_noargs(n):
+    f = f0
+    t0 = time.perf_counter()
+    for i in range(n):
+        f(); f(); f(); f(); f(); f(); f(); f(); f(); f()
+    return time.perf_counter() - t0
+
+def bench_positional(n):
+    f = f3
+    t0 = time.perf_counter()
+    for i in range(n):
+        f(1, 2, 3); f(1, 2, 3); f(1, 2, 3); f(1, 2, 3); f(1, 2, 3)
+        f(1, 2, 3); f(1, 2, 3); f(1, 2, 3); f(1, 2, 3); f(1, 2, 3)
+    return time.perf_counter() - t0
+
+def bench_keywords(n):
+    f = f3
+    t0 = time.perf_counter()
+    for i in range(n):
+        f(1, b=2, c=3); f(1, b=2, c=3); f(1, b=2, c=3); f(1, b=2, c=3)
+        f(1, b=2, c=3); f(1, b=2, c=3); f(1, b=2, c=3); f(1, b=2, c=3)
+        f(1, b=2, c=3); f(1, b=2, c=3)
+    return time.perf_counter() - t0
+
+def bench_defaults(n):
+    f = fdef
+    t0 = time.perf_counter()
+    for i in range(n):
+        f(1); f(1); f(1); f(1); f(1); f(1); f(1); f(1); f(1); f(1)
+    return time.perf_counter() - t0
+
+def bench_closure(n):
+    f = make_closure()
+    t0 = time.perf_counter()
+    for i in range(n):
+        f(1); f(1); f(1); f(1); f(1); f(1); f(1); f(1); f(1); f(1)
+    return time.perf_counter() - t0
+
+def bench_method(n):
+    o = C()
+    t0 = time.perf_counter()
+    for i in range(n):
+        o.method(1); o.method(1); o.method(1); o.method(1); o.method(1)
+        o.method(1); o.method(1); o.method(1); o.method(1); o.method(1)
+    return time.perf_counter() - t0
+
+def bench_recursive(n):
+    # fib(15) makes 1973 calls: about 200 times 10 calls
+    t0 = time.perf_counter()
+    for i in range(n // 200):
+        fib(15)
+    return (time.perf_counter() - t0) * (10 * n) / (1973 * (n // 200))
+
+def bench_int(n):
+    t = int
+    t0 = time.perf_counter()
+    for i in range(n):
+        t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1)
+    return time.perf_counter() - t0
+
+def bench_str(n):
+    t = str
+    t0 = time.perf_counter()
+    for i in range(n):
+        t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1)
+    return time.perf_counter() - t0
+
+def bench_list(n):
+    t = list
+    a = (1, 2)
+    t0 = time.perf_counter()
+    for i in range(n):
+        t(a); t(a); t(a); t(a); t(a); t(a); t(a); t(a); t(a); t(a)
+    return time.perf_counter() - t0
+
+def bench_dict(n):
+    t = dict
+    t0 = time.perf_counter()
+    for i in range(n):
+        t(a=1); t(a=1); t(a=1); t(a=1); t(a=1)
+        t(a=1); t(a=1); t(a=1); t(a=1); t(a=1)
+    return time.perf_counter() - t0
+
+def bench_class(n):
+    t = Init
+    t0 = time.perf_counter()
+    for i in range(n):
+        t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1); t(1)
+    return time.perf_counter() - t0
+
+def bench_class_noinit(n):
+    t = NoInit
+    t0 = time.perf_counter()
+    for i in range(n):
+        t(); t(); t(); t(); t(); t(); t(); t(); t(); t()
+    return time.perf_counter() - t0
+
+def bench_bound_method(n):
+    # map() calls the bound method from C code
+    f = C().method
+    items = range(10 * n)
+    t0 = time.perf_counter()
+    for x in map(f, items):
+        pass
+    return time.perf_counter() - t0
+
+BENCHMARKS = [
+    ('noargs', bench_noargs),
+    ('positional', bench_positional),
+    ('keywords', bench_keywords),
+    ('defaults', bench_defaults),
+    ('closure', bench_closure),
+    ('method', bench_method),
+    ('recursive', bench_recursive),
+    ('int', bench_int),
+    ('str', bench_str),
+    ('list', bench_list),
+    ('dict', bench_dict),
+    ('class', bench_class),
+    ('class_noinit', bench_class_noinit),
+    ('bound_method', bench_bound_method),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-n', '--number', type=int, default=100000,
+                        help='number of loops of 10 calls '
+                             '(default: %(default)s)')
+    parser.add_argument('-r', '--repeat', type=int, default=5,
+                        help='number of timings, the best one is kept '
+                             '(default: %(default)s)')
+    options = parser.parse_args()
+
+    n = options.number
+    for name, func in BENCHMARKS:
+        best = min(func(n) for i in range(options.repeat))
+        print('%-12s %6.1f ns per call' % (name, best * 1e9 / (10 * n)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,80 @@
+"""Benchmark lookups in large dictionaries.
+
+Measure the time of successful and failed lookups, and of insertions, in
+dictionaries of str and int keys of several sizes.  The keys are looked up
+in random order, so that the large tables don't fit in the CPU caches.
+Compare the results of two builds to evaluate a change of the hash table.
+"""
+
+import argparse
+import random
+import time
+
+
+def str_keys(n, seed):
+    return ['key:%d:%d' % (seed, i) for i in range(n)]
+
+def int_keys(n, seed):
+    rng = random.Random(seed)
+    return [rng.getrandbits(48) for i in range(n)]
+
+KEYS = [
+    ('str', str_keys),
+    ('int', int_keys),
+]
+
+
+def bench_hit(d, keys, misses):
+    t0 = time.perf_counter()
+    for key in keys:
+        d[key]
+    return time.perf_counter() - t0
+
+def bench_miss(d, keys, misses):
+    t0 = time.perf_counter()
+    for key in misses:
+        key in d
+    return time.perf_counter() - t0
+
+def bench_insert(d, keys, misses):
+    t0 = time.perf_counter()
+    new = {}
+    for key in keys:
+        new[key] = None
+    return time.perf_counter() - t0
+
+BENCHMARKS = [
+    ('hit', bench_hit),
+    ('miss', bench_miss),
+    ('insert', bench_insert),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-s', '--sizes', type=int, nargs='+',
+                        default=[10**3, 10**4, 10**5, 10**6],
+                        help='numbers of keys (default: %(default)s)')
+    parser.add_argument('-r', '--repeat', type=int, default=5,
+                        help='number of timings, the best one is kept '
+                             '(default: %(default)s)')
+    options = parser.parse_args()
+
+    print('%-6s %9s' % ('keys', 'size')
+          + ''.join('%10s' % name for name, func in BENCHMARKS)
+          + '  (ns per key)')
+    for kind, make_keys in KEYS:
+        for n in options.sizes:
+            keys = make_keys(n, 1)
+            misses = make_keys(n, 2)
+            d = dict.fromkeys(keys)
+            random.shuffle(keys)
+            timings = [min(func(d, keys, misses)
+                           for i in range(options.repeat))
+                       for name, func in BENCHMARKS]
+            print('%-6s %9d' % (kind, n)
+                  + ''.join('%10.1f' % (t * 1e9 / n) for t in timings))
+
+
+if __name__ == '__main__':
+    main()
@@ -92,6 +92,10 @@ Py_TPFLAGS_DICT_SUBCLASS     = (1 << 29)
 Py_TPFLAGS_BASE_EXC_SUBCLASS = (1 << 30)
 Py_TPFLAGS_TYPE_SUBCLASS     = (1 << 31)
 
+# Tables of dict keys of at least this size have tag bytes (see
+# DK_TAGS_MINSIZE in Objects/dictobject.c)
+DK_TAGS_MINSIZE = (1 << 14)
+
 
 MAX_OUTPUT_LEN=1024
 
@@ -729,6 +733,9 @@ class PyDictObjectPtr(PyObjectPtr):
             offset = 4 * dk_size
         else:
             offset = 8 * dk_size
+        if dk_size >= DK_TAGS_MINSIZE:
+            # DK_HAS_TAGS(): the indices are followed by a tag byte per slot
+            offset += dk_size
 
         ent_addr = keys['dk_indices']['as_1'].address
         ent_addr = ent_addr.cast(_type_unsigned_char_ptr()) + offset
@@ -0,0 +1,117 @@
+"""Benchmark the small object allocator.
+
+Measure the allocation throughput of a few allocation-heavy workloads with
+the per-thread pymalloc block caches enabled and disabled (see
+sys._setmalloccache()).  Optionally run the workloads in several threads
+at once.
+"""
+
+import argparse
+import sys
+import threading
+import time
+
+
+def bench_tuples(n):
+    for i in range(n):
+        (i, i, i)
+        (i, i, i, i, i, i)
+
+def bench_floats(n):
+    x = 1.0
+    for i in range(n):
+        x = x * 1.0 + 0.0
+
+def bench_lists(n):
+    for i in range(n // 100):
+        lst = [float(j) for j in range(100)]
+        del lst
+
+def bench_dicts(n):
+    for i in range(n // 4):
+        {'a': i, 'b': i, 'c': i}
+
+def bench_strings(n):
+    s = 'abc'
+    for i in range(n // 2):
+        s[:2] + str(i)
+
+def bench_objects(n):
+    class C:
+        def __init__(self, x):
+            self.x = x
+    for i in range(n // 10):
+        C(i)
+
+BENCHMARKS = [
+    ('tuples', bench_tuples),
+    ('floats', bench_floats),
+    ('lists', bench_lists),
+    ('dicts', bench_dicts),
+    ('strings', bench_strings),
+    ('objects', bench_objects),
+]
+
+
+def run(func, n, nthreads):
+    if nthreads == 1:
+        t0 = time.perf_counter()
+        func(n)
+        return time.perf_counter() - t0
+    threads = [threading.Thread(target=func, args=(n,))
+               for _ in range(nthreads)]
+    t0 = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return time.perf_counter() - t0
+
+
+def best_of(func, n, nthreads, repeat):
+    return min(run(func, n, nthreads) for _ in range(repeat))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-n', '--loops', type=int, default=10**6,
+                        help='number of iterations per benchmark '
+                             '(default: %(default)s)')
+    parser.add_argument('-r', '--repeat', type=int, default=5,
+                        help='number of timings, the best one is kept '
+                             '(default: %(default)s)')
+    parser.add_argument('-t', '--threads', type=int, default=1,
+                        help='number of threads running each benchmark '
+                             '(default: %(default)s)')
+    parser.add_argument('benchmarks', nargs='*',
+                        help='benchmarks to run (default: all)')
+    options = parser.parse_args()
+
+    if not hasattr(sys, '_setmalloccache'):
+        sys.exit('this Python has no per-thread pymalloc caches')
+    names = options.benchmarks or [name for name, func in BENCHMARKS]
+    unknown = set(names) - {name for name, func in BENCHMARKS}
+    if unknown:
+        parser.error('unknown benchmarks: %s' % ', '.join(sorted(unknown)))
+
+    print('%-10s %12s %12s %8s' % ('benchmark', 'no cache', 'cache',
+                                   'speedup'))
+    old = sys._getmalloccache()
+    try:
+        for name, func in BENCHMARKS:
+            if name not in names:
+                continue
+            timings = []
+            for enabled in (False, True):
+                sys._setmalloccache(enabled)
+                timings.append(best_of(func, options.loops, options.threads,
+                                       options.repeat))
+            print('%-10s %10.1f ms %10.1f ms %7.2fx'
+                  % (name, timings[0] * 1e3, timings[1] * 1e3,
+                     timings[0] / timings[1]))
+    finally:
+        sys._setmalloccache(old)
+
+
+if __name__ == '__main__':
+    main()
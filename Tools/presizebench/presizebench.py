@@ -0,0 +1,74 @@
+"""Benchmark building dictionaries and sets from iterables of known length.
+
+Measure the time of dict.fromkeys(), dict(zip()), set(), and of merging
+two dictionaries of half the size with {**a, **b}, for inputs of several
+sizes.  When the length of the input is known, these constructions size
+their table from it, in two steps for inputs longer than a sample of their
+first items, instead of resizing it as it fills up.  Compare the results of
+two builds to evaluate a change of the presizing.
+"""
+
+import argparse
+import time
+
+
+def bench_fromkeys(keys, values, halves):
+    t0 = time.perf_counter()
+    dict.fromkeys(keys)
+    return time.perf_counter() - t0
+
+def bench_dict_zip(keys, values, halves):
+    t0 = time.perf_counter()
+    dict(zip(keys, values))
+    return time.perf_counter() - t0
+
+def bench_set(keys, values, halves):
+    t0 = time.perf_counter()
+    set(keys)
+    return time.perf_counter() - t0
+
+def bench_merge(keys, values, halves):
+    a, b = halves
+    t0 = time.perf_counter()
+    {**a, **b}
+    return time.perf_counter() - t0
+
+BENCHMARKS = [
+    ('fromkeys', bench_fromkeys),
+    ('dict(zip)', bench_dict_zip),
+    ('set', bench_set),
+    ('{**a,**b}', bench_merge),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-s', '--sizes', type=int, nargs='+',
+                        default=[10**2, 10**3, 10**4, 10**5, 10**6],
+                        help='numbers of items (default: %(default)s)')
+    parser.add_argument('-r', '--repeat', type=int, default=5,
+                        help='number of timings, the best one is kept '
+                             '(default: %(default)s)')
+    options = parser.parse_args()
+
+    print('%9s' % 'size'
+          + ''.join('%11s' % name for name, func in BENCHMARKS)
+          + '  (ns per item)')
+    for n in options.sizes:
+        keys = [i * 7919 for i in range(n)]
+        values = list(range(n))
+        halves = (dict(zip(keys[::2], values[::2])),
+                  dict(zip(keys[1::2], values[1::2])))
+        # Small inputs are timed many times in a row to be measurable
+        loops = max(1, 10**5 // n)
+        timings = []
+        for name, func in BENCHMARKS:
+            best = min(sum(func(keys, values, halves) for j in range(loops))
+                       for i in range(options.repeat))
+            timings.append(best / loops)
+        print('%9d' % n
+              + ''.join('%11.1f' % (t * 1e9 / n) for t in timings))
+
+
+if __name__ == '__main__':
+    main()
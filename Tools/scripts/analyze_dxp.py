@@ -1,19 +1,22 @@
 """
 Some helper functions to analyze the output of sys.getdxp() (which is
-only available if Python was built with -DDYNAMIC_EXECUTION_PROFILE).
+only available if Python was built with -DDYNAMIC_EXECUTION_PROFILE),
+or else of the opcode profiler (see sys._setopcodeprofile()).
 These will tell you which opcodes have been executed most frequently
-in the current process, and, if Python was also built with -DDXPAIRS,
-will tell you which instruction _pairs_ were executed most frequently,
-which may help in choosing new instructions.
+in the current process, and, if Python was also built with -DDXPAIRS
+or the opcode profiler is used, will tell you which instruction _pairs_
+were executed most frequently, which may help in choosing new
+instructions.
 
-If Python was built without -DDYNAMIC_EXECUTION_PROFILE, importing
-this module will raise a RuntimeError.
+If Python was built without -DDYNAMIC_EXECUTION_PROFILE, the opcode
+profiler must be enabled, either with -X opcodeprofile or by calling
+enable_profile().
 
 If you're running a script you want to profile, a simple way to get
 the common pairs is:
 
 $ PYTHONPATH=$PYTHONPATH:<python_srcdir>/Tools/scripts \
-./python -i -O the_script.py --args
+./python -X opcodeprofile -i -O the_script.py --args
 ...
 > from analyze_dxp import *
 > s = render_common_pairs()
@@ -26,13 +29,21 @@ import operator
 import sys
 import threading
 
-if not hasattr(sys, "getdxp"):
+if hasattr(sys, "getdxp"):
+    _getdxp = sys.getdxp
+elif hasattr(sys, "_getopcodeprofile"):
+    def _getdxp():
+        # Same as sys.getdxp() with -DDXPAIRS, which 0s itself
+        profile = sys._getopcodeprofile()
+        sys._resetopcodeprofile()
+        return profile
+else:
     raise RuntimeError("Can't import analyze_dxp: Python built without"
                        " -DDYNAMIC_EXECUTION_PROFILE.")
 
 
 _profile_lock = threading.RLock()
-_cumulative_profile = sys.getdxp()
+_cumulative_profile = _getdxp()
 
 # If Python was built with -DDXPAIRS, sys.getdxp() returns a list of
 # lists of ints.  Otherwise it returns just a list of ints.
@@ -43,12 +54,19 @@ def has_pairs(profile):
     return len(profile) > 0 and isinstance(profile[0], list)
 
 
+def enable_profile():
+    """Enables the opcode profiler, if Python was built without
+    -DDYNAMIC_EXECUTION_PROFILE (which profiles all the time)."""
+    if not hasattr(sys, "getdxp"):
+        sys._setopcodeprofile(True)
+
+
 def reset_profile():
     """Forgets any execution profile that has been gathered so far."""
     with _profile_lock:
-        sys.getdxp()  # Resets the internal profile
+        _getdxp()  # Resets the internal profile
         global _cumulative_profile
-        _cumulative_profile = sys.getdxp()  # 0s out our copy.
+        _cumulative_profile = _getdxp()  # 0s out our copy.
 
 
 def merge_profile():
@@ -57,7 +75,7 @@ def merge_profile():
     We need this because sys.getdxp() 0s itself every time it's called."""
 
     with _profile_lock:
-        new_profile = sys.getdxp()
+        new_profile = _getdxp()
         if has_pairs(new_profile):
             for first_inst in range(len(_cumulative_profile)):
                 for second_inst in range(len(_cumulative_profile[first_inst])):
@@ -53,6 +53,9 @@ def main(opcode_py, outfile='Include/opcode.h'):
             if name == 'POP_EXCEPT': # Special entry for HAVE_ARGUMENT
                 fobj.write("#define %-23s %3d\n" %
                             ('HAVE_ARGUMENT', opcode['HAVE_ARGUMENT']))
+        fobj.write("\n/* Specialized instructions, never emitted by the compiler */\n")
+        for name, op in opcode['_specialized_instructions']:
+            fobj.write("#define %-23s %3s\n" % (name, op))
         fobj.write(footer)
 
     print("%s regenerated from %s" % (outfile, opcode_py))
@@ -0,0 +1,78 @@
+"""Benchmark list.sort() on lists of a single type.
+
+Measure the time of sorting random lists of small ints, large ints,
+floats, ASCII and non-ASCII strings, and tuples of ints, of several sizes.
+The pre-sort check picks a specialized comparison for most of these, and
+falls back to the rich comparison of the type for the others.  Compare the
+results of two builds to evaluate a change of the sort.
+"""
+
+import argparse
+import random
+import time
+
+
+def small_ints(n, rng):
+    return [rng.randrange(-2**30 + 1, 2**30) for i in range(n)]
+
+def large_ints(n, rng):
+    return [rng.getrandbits(64) for i in range(n)]
+
+def floats(n, rng):
+    return [rng.random() for i in range(n)]
+
+def ascii_strs(n, rng):
+    return ['%016x' % rng.getrandbits(64) for i in range(n)]
+
+def unicode_strs(n, rng):
+    return ['€%016x' % rng.getrandbits(64) for i in range(n)]
+
+def int_tuples(n, rng):
+    return [(rng.randrange(n), i) for i in range(n)]
+
+DATA = [
+    ('int', small_ints),
+    ('bigint', large_ints),
+    ('float', floats),
+    ('ascii', ascii_strs),
+    ('unicode', unicode_strs),
+    ('tuple', int_tuples),
+]
+
+
+def bench(data, repeat):
+    best = None
+    for i in range(repeat):
+        lst = data[:]
+        t0 = time.perf_counter()
+        lst.sort()
+        dt = time.perf_counter() - t0
+        if best is None or dt < best:
+            best = dt
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-s', '--sizes', type=int, nargs='+',
+                        default=[10**3, 10**4, 10**5, 10**6],
+                        help='numbers of items (default: %(default)s)')
+    parser.add_argument('-r', '--repeat', type=int, default=5,
+                        help='number of timings, the best one is kept '
+                             '(default: %(default)s)')
+    options = parser.parse_args()
+
+    print('%9s' % 'size'
+          + ''.join('%9s' % name for name, func in DATA)
+          + '  (ns per item)')
+    for n in options.sizes:
+        timings = []
+        for name, make_data in DATA:
+            data = make_data(n, random.Random(n))
+            timings.append(bench(data, options.repeat))
+        print('%9d' % n
+              + ''.join('%9.1f' % (t * 1e9 / n) for t in timings))
+
+
+if __name__ == '__main__':
+    main()
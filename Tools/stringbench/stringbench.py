@@ -218,6 +218,42 @@ def find_test_slow_match_100_characters_bis(STR):
     for x in _RANGE_100:
         s1_find(s2)
 
+@bench('("A"*100000).find("A"*500+"B"+"A"*499)',
+       "no match, 1000 characters, repetitive", 10)
+def find_test_no_match_1000_characters_repetitive(STR):
+    s1 = STR("A" * 100000)
+    s2 = STR("A" * 500 + "B" + "A" * 499)
+    s1_find = s1.find
+    for x in _RANGE_10:
+        s1_find(s2)
+
+@bench('("AB"*50000+"C").find("AB"*50+"C")',
+       "late match, 101 characters, repetitive", 10)
+def find_test_slow_match_101_characters_repetitive(STR):
+    s1 = STR("AB" * 50000 + "C")
+    s2 = STR("AB" * 50 + "C")
+    s1_find = s1.find
+    for x in _RANGE_10:
+        s1_find(s2)
+
+@bench('...text.with.2000.lines...find("ERROR")',
+       "no match, 5 characters, big string", 100)
+def find_test_no_match_5_characters_big(STR):
+    s1 = _get_2000_lines(STR)
+    s2 = STR("ERROR")
+    s1_find = s1.find
+    for x in _RANGE_100:
+        s1_find(s2)
+
+@bench('("ABCDEFGH"*12500).find("CDEFGHXYZ")',
+       "no match, 9 characters, big string", 100)
+def find_test_no_match_9_characters_big(STR):
+    s1 = STR("ABCDEFGH" * 12500)
+    s2 = STR("CDEFGHXYZ")
+    s1_find = s1.find
+    for x in _RANGE_100:
+        s1_find(s2)
+
 
 #### Same tests for 'rfind'
 
@@ -1081,6 +1117,24 @@ def count_aact(STR):
     for x in _RANGE_10:
         seq_count(needle)
 
+@bench('...text.with.2000.lines...count("ome")',
+       "count a 3 characters substring, big string", 100)
+def count_3_characters_big(STR):
+    s = _get_2000_lines(STR)
+    s_count = s.count
+    needle = STR("ome")
+    for x in _RANGE_100:
+        s_count(needle)
+
+@bench('("AB"*50000).count("AB"*50+"A")',
+       "count a 101 characters substring, repetitive", 10)
+def count_101_characters_repetitive(STR):
+    s = STR("AB" * 50000)
+    s_count = s.count
+    needle = STR("AB" * 50 + "A")
+    for x in _RANGE_10:
+        s_count(needle)
+
 ##### startswith and endswith
 
 @bench('"Andrew".startswith("A")', 'startswith single character', 1000)